@@ -34,23 +34,51 @@
 #pragma once
 
 #include "../CacheStrategy.h"
+#include "../CacheBatch.h"
+#include "../CacheSharded.h"
+#include "../CacheSnapshot.h"
+#include "../CacheLock.h"
 #include "ArcLruPart.h"
 #include "ArcLfuPart.h"
+#include <chrono>
+#include <cmath>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace Cache {
 
-template<typename Key, typename Value>
+// Mutex 为锁策略, 见 CacheLock.h
+template<typename Key, typename Value, typename Mutex = std::mutex, typename Hash = CacheHash<Key>>
 class ArcCache : public CacheStrategy<Key, Value> {
 public:
-    explicit ArcCache(size_t capacity = 10, size_t transformThreshold = 3) 
+    /**
+     * 不设置 weigher 时 T1/T2 各自最多 capacity 个条目(共 2 * capacity, 复制到 T2 的节点在 T1 中还有一份)
+     * 设置 weigher 后 capacity 表示总权重预算: T1/T2 的分区目标之和为 capacity, 节点从 T1 转到 T2 时不再保留 T1 中的副本,
+     * 常驻条目的权重之和不超过 capacity; 两个 ghost 列表也按权重计算, 单个条目不能超过所在分区的预算
+    */
+    explicit ArcCache(size_t capacity = 10, size_t transformThreshold = 3, CacheWeigher<Key, Value> weigher = nullptr) 
         : capacity_(capacity)
         , transformThreshold_(transformThreshold)
-        , lruPart_(std::make_unique<ArcLruPart<Key, Value>>(capacity, transformThreshold))
-        , lfuPart_(std::make_unique<ArcLfuPart<Key, Value>>(capacity, transformThreshold))
-    {}
+        , weighted_(weigher != nullptr)
+        , lruPart_(std::make_unique<ArcLruPart<Key, Value, Hash>>(weighted_ ? capacity - capacity / 2 : capacity, transformThreshold, weigher))
+        , lfuPart_(std::make_unique<ArcLfuPart<Key, Value, Hash>>(weighted_ ? capacity / 2 : capacity, transformThreshold, weigher))
+    {
+        this->template useLoadHash<Hash>();
+        if (weighted_) {
+            // ghost 列表仍按整个预算记录
+            lruPart_->setCapacity(lruPart_->getCapacity(), capacity);
+            lfuPart_->setCapacity(lfuPart_->getCapacity(), capacity);
+        }
+    }
 
-    ~ArcCache() override = default;
+    ~ArcCache() override {
+        this->cancelLoads();
+    }
 
     // void put(Key key, Value value) override {
     //     bool inGhost = checkGhostCaches(key);
@@ -65,65 +93,430 @@ public:
     // }
     
     /* put()不增加LRU节点的访问次数, 增加LFU节点的访问次数 */
-    void put(Key key, Value value) override {
-        // ghost缓存里没有该key就添加到缓存列表里
-        bool inGhost = checkGhostCaches(key);
-        if (inGhost == false) {
-            if (lfuPart_->inLfuMainCache(key)) {
-                // key 在 LFU 缓存里
-                lfuPart_->put(key, value);
+    void put(const Key& key, const Value& value) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        putLocked(key, value);
+    }
+
+    void put(const Key& key, Value&& value) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        putLocked(key, std::move(value));
+    }
+
+    // 带 TTL 的添加: ttl 之后条目失效, 由 T1/T2 各自的定时轮回收; 不带 ttl 的 put() 会清除已有的过期时间
+    void put(const Key& key, const Value& value, std::chrono::nanoseconds ttl) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        putLocked(key, value, cacheExpireAt(ttl));
+    }
+
+    void put(const Key& key, Value&& value, std::chrono::nanoseconds ttl) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        putLocked(key, std::move(value), cacheExpireAt(ttl));
+    }
+
+    // get()增加LRU节点和LFU节点的访问次数
+    bool get(const Key& key, Value& value) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        return getLocked(key, value);
+    }
+
+    // 只查 T1/T2 的索引, ghost 不算在缓存中, 不调整访问顺序
+    bool contains(const Key& key) override {
+        std::lock_guard<Mutex> lock(mutex_);
+        uint64_t now = hasTimers() ? cacheNowNanos() : 0;
+        return lruPart_->inLruMainCache(key, now) || lfuPart_->inLfuMainCache(key, now);
+    }
+
+    // 删除 T1/T2 中的条目(包括复制到 T2 的副本), 不进入 ghost 列表, 分区大小不变
+    void remove(const Key& key) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        lruPart_->remove(key);
+        lfuPart_->remove(key);
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) override {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        return getBatch(keys, nullptr, keys.size(), values, found);
+    }
+
+    void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) override {
+        putBatch(keys, values, nullptr, std::min(keys.size(), values.size()));
+    }
+
+    /**
+     * 批量查找的分片入口: 只处理 indices 指定的 count 个下标(indices 为空表示 0..count-1), 整批只加一次锁
+     * 每个 key 要依次查 ghost/T1/T2 多个索引, 这里不做预取, 只摊薄加锁开销
+    */
+    size_t getBatch(const std::vector<Key>& keys, const size_t* indices, size_t count,
+                    std::vector<Value>& values, std::vector<bool>& found) {
+        size_t hits = 0;
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        for (size_t pos = 0; pos < count; pos++) {
+            size_t i = batchIndexAt(indices, pos);
+            if (getLocked(keys[i], values[i])) {
+                found[i] = true;
+                hits++;
             }
-            else {
-                // key 在 LRU 缓存里
-                lruPart_->put(key, value);
+        }
+        return hits;
+    }
+
+    // 批量添加的分片入口, 下标含义同 getBatch()
+    void putBatch(const std::vector<Key>& keys, const std::vector<Value>& values, const size_t* indices, size_t count) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        for (size_t pos = 0; pos < count; pos++) {
+            size_t i = batchIndexAt(indices, pos);
+            putLocked(keys[i], values[i]);
+        }
+    }
+
+    size_t getCapacity() {
+        std::lock_guard<Mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    // 立即回收所有已经到期的条目; 读写操作本身也会顺带回收, 这里用于长时间没有访问的缓存
+    void purgeExpired() {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+    }
+
+    /**
+     * 淘汰监听器, 传入空函数时取消; 见 CacheEvictionListener
+     * 节点从 T1 复制到 T2 后两边各有一份, 只有最后一份被淘汰时才通知, 进入 ghost 列表的条目同样会通知
+    */
+    void setEvictionListener(CacheEvictionListener<Key, Value> listener) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        if (!listener) {
+            lruPart_->setEvictionListener(nullptr);
+            lfuPart_->setEvictionListener(nullptr);
+            return;
+        }
+        auto shared = std::make_shared<CacheEvictionListener<Key, Value>>(std::move(listener));
+        lruPart_->setEvictionListener([this, shared](const Key& key, const Value& value, uint64_t expireAt) {
+            if (!lfuPart_->inLfuMainCache(key)) (*shared)(key, value, expireAt);
+        });
+        lfuPart_->setEvictionListener([this, shared](const Key& key, const Value& value, uint64_t expireAt) {
+            if (!lruPart_->inLruMainCache(key)) (*shared)(key, value, expireAt);
+        });
+    }
+
+    /**
+     * 延迟释放: 开启后 T1/T2 淘汰、过期和覆盖的旧值不在锁内析构, 由 runMaintenance() 在锁外统一析构
+     * ghost 列表只保存 key 的指纹, 修剪 ghost 列表不涉及值的释放
+    */
+    void setDeferredRelease(bool enabled) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        lruPart_->setDeferredRelease(enabled);
+        lfuPart_->setDeferredRelease(enabled);
+    }
+
+    // 一次后台维护: 回收两部分中到期的条目, 待释放的旧值在锁外析构
+    void runMaintenance() {
+        std::vector<Value> lruRetired;
+        std::vector<Value> lfuRetired;
+        {
+            StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+            expireEntries();
+            lruRetired = lruPart_->takeRetired();
+            lfuRetired = lfuPart_->takeRetired();
+        }
+    }
+
+    /**
+     * window 之内到期、并且上次写入之后被读过的条目的 key, 用于提前刷新
+     * 同时在 T1/T2 中的 key 只返回一次, 任意一份被读过就算读过
+    */
+    std::vector<Key> expiringKeys(std::chrono::nanoseconds window) {
+        std::vector<Key> keys;
+        std::lock_guard<Mutex> lock(mutex_);
+        if (!hasTimers()) return keys;
+        uint64_t deadline = cacheNowNanos() + static_cast<uint64_t>(window.count());
+        lfuPart_->forEachExpiringBefore(deadline, [&](const Key& key, bool read) {
+            if (read || lruPart_->readSinceWrite(key)) keys.push_back(key);
+        });
+        lruPart_->forEachExpiringBefore(deadline, [&](const Key& key, bool read) {
+            if (read && !lfuPart_->inLfuMainCache(key)) keys.push_back(key);
+        });
+        return keys;
+    }
+
+    // 提前刷新的写回: 只替换已有条目的值并以 ttl 续期, 不调整访问顺序和频次; 条目已经不在缓存中时返回 false
+    template<typename V>
+    bool refresh(const Key& key, V&& value, std::chrono::nanoseconds ttl) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        uint64_t expireAt = cacheExpireAt(ttl);
+        // 复制到 T2 的节点两边各有一份, 都要更新
+        if (lfuPart_->inLfuMainCache(key, now_)) {
+            lruPart_->refresh(key, static_cast<const Value&>(value), expireAt);
+            return lfuPart_->refresh(key, std::forward<V>(value), expireAt);
+        }
+        return lruPart_->inLruMainCache(key, now_) && lruPart_->refresh(key, std::forward<V>(value), expireAt);
+    }
+
+    // 调整缓存总容量, LRU/LFU 两部分按当前的分区比例缩放
+    void resize(size_t capacity) {
+        std::lock_guard<Mutex> lock(mutex_);
+        setPartitions(capacity, lruPart_->getCapacity(), lfuPart_->getCapacity());
+    }
+
+    // 清空 T1/T2 和两个 ghost 列表, 分区大小保持不变
+    void purge() {
+        std::lock_guard<Mutex> lock(mutex_);
+        lruPart_->clear();
+        lfuPart_->clear();
+    }
+
+    /**
+     * 保存快照: 两部分的分区容量, 然后依次是
+     * T1(最久未访问 → 最近访问, 含访问次数)、B1 的指纹和权重、T2(频次升序, 含频次)、B2 的指纹和权重
+     * 复制到 T2 的节点在 T1 中的副本同样保存; 保存期间持有锁, 成功返回 true
+    */
+    template<typename KeySerializer = CacheSerializer<Key>, typename ValueSerializer = CacheSerializer<Value>>
+    bool saveSnapshot(const std::string& path) {
+        SnapshotWriter out(path);
+        if (!out.ok()) return false;
+        {
+            StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+            expireEntries();
+            uint64_t now = hasTimers() ? now_ : 0;
+            uint64_t lruCount = 0;
+            uint64_t lfuCount = 0;
+            auto countLive = [now](uint64_t& count) {
+                return [now, &count](const Key&, const Value&, size_t, uint64_t expireAt) {
+                    if (expireAt == 0 || expireAt > now) count++;
+                };
+            };
+            lruPart_->forEachMain(countLive(lruCount));
+            lfuPart_->forEachMain(countLive(lfuCount));
+
+            out.writeHeader(SnapshotPolicy::Arc, lruCount + lfuCount);
+            out.writePod(static_cast<uint64_t>(lruPart_->getCapacity()));
+            out.writePod(static_cast<uint64_t>(lfuPart_->getCapacity()));
+            auto writeMain = [&](const Key& key, const Value& value, size_t count, uint64_t expireAt) {
+                uint64_t remaining = 0;
+                if (!snapshotRemainingTtl(expireAt, now, remaining)) return;
+                KeySerializer::write(out, key);
+                ValueSerializer::write(out, value);
+                out.writePod(static_cast<uint64_t>(count));
+                out.writePod(remaining);
+            };
+            auto writeGhost = [&](uint64_t fingerprint, size_t weight) {
+                out.writePod(fingerprint);
+                out.writePod(static_cast<uint64_t>(weight));
+            };
+            out.writePod(lruCount);
+            lruPart_->forEachMain(writeMain);
+            out.writePod(static_cast<uint64_t>(lruPart_->getGhostSize()));
+            lruPart_->forEachGhost(writeGhost);
+            out.writePod(lfuCount);
+            lfuPart_->forEachMain(writeMain);
+            out.writePod(static_cast<uint64_t>(lfuPart_->getGhostSize()));
+            lfuPart_->forEachGhost(writeGhost);
+        }
+        return out.commit();
+    }
+
+    /**
+     * 载入快照: 清空后恢复分区比例(按本缓存的容量缩放)、T1/T2 的顺序和访问次数以及两个 ghost 列表
+     * 文件不存在、格式不对或者被截断时返回 false, 截断前的条目会保留在缓存中
+    */
+    template<typename KeySerializer = CacheSerializer<Key>, typename ValueSerializer = CacheSerializer<Value>>
+    bool loadSnapshot(const std::string& path) {
+        SnapshotReader in(path);
+        uint64_t count = 0;
+        uint64_t elapsed = 0;
+        uint64_t lruCapacity = 0;
+        uint64_t lfuCapacity = 0;
+        if (!in.ok() || !in.readHeader(SnapshotPolicy::Arc, count, elapsed)
+            || !in.readPod(lruCapacity) || !in.readPod(lfuCapacity)) {
+            return false;
+        }
+
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        lruPart_->clear();
+        lfuPart_->clear();
+        setPartitions(capacity_, lruCapacity, lfuCapacity);
+        uint64_t now = cacheNowNanos();
+        auto readMain = [&](auto& part) {
+            uint64_t n = 0;
+            if (!in.readPod(n)) return false;
+            for (uint64_t i = 0; i < n; i++) {
+                Key key{};
+                Value value{};
+                uint64_t accessCount = 0;
+                uint64_t remaining = 0;
+                if (!KeySerializer::read(in, key) || !ValueSerializer::read(in, value)
+                    || !in.readPod(accessCount) || !in.readPod(remaining)) {
+                    return false;
+                }
+                uint64_t expireAt = 0;
+                if (snapshotRestoreExpireAt(remaining, elapsed, now, expireAt)) {
+                    part.restoreMain(key, std::move(value), accessCount, expireAt);
+                }
             }
+            return true;
+        };
+        auto readGhost = [&](auto& part) {
+            uint64_t n = 0;
+            if (!in.readPod(n)) return false;
+            for (uint64_t i = 0; i < n; i++) {
+                uint64_t fingerprint = 0;
+                uint64_t weight = 0;
+                if (!in.readPod(fingerprint) || !in.readPod(weight)) return false;
+                part.restoreGhost(fingerprint, std::max<uint64_t>(1, weight));
+            }
+            return true;
+        };
+        return readMain(*lruPart_) && readGhost(*lruPart_) && readMain(*lfuPart_) && readGhost(*lfuPart_);
+    }
+
+    // 返回并清零上次调用以来的 ghost 命中次数, 用于分片间的容量再平衡
+    size_t takeGhostHits() {
+        std::lock_guard<Mutex> lock(mutex_);
+        size_t hits = ghostHits_;
+        ghostHits_ = 0;
+        return hits;
+    }
+
+    /**
+     * 统计快照
+     * · inserts/evictions/expirations 是 T1、T2 两部分之和, 节点从 T1 复制到 T2 时也算一次插入
+     * · 各分区的容量和大小反映 ARC 当前的自适应状态
+    */
+    CacheStatsSnapshot getStats() override {
+        CacheStatsSnapshot snapshot;
+        stats_.addTo(snapshot);
+        std::lock_guard<Mutex> lock(mutex_);
+        snapshot.inserts += lruPart_->getInsertCount() + lfuPart_->getInsertCount();
+        snapshot.evictions += lruPart_->getEvictionCount() + lfuPart_->getEvictionCount();
+        snapshot.expirations += lruPart_->getExpirationCount() + lfuPart_->getExpirationCount();
+        snapshot.lruPartCapacity = lruPart_->getCapacity();
+        snapshot.lfuPartCapacity = lfuPart_->getCapacity();
+        snapshot.lruPartSize = lruPart_->getSize();
+        snapshot.lfuPartSize = lfuPart_->getSize();
+        snapshot.lruGhostSize = lruPart_->getGhostSize();
+        snapshot.lfuGhostSize = lfuPart_->getGhostSize();
+        snapshot.size = snapshot.lruPartSize + snapshot.lfuPartSize;
+        snapshot.weight = lruPart_->getWeight() + lfuPart_->getWeight();
+        return snapshot;
+    }
+
+private:
+    /**
+     * 总容量设为 capacity, 两部分按 lruCapacity : lfuCapacity 的比例分配; 调用方持有 mutex_
+     * 两部分之和不设置 weigher 时是 2 * capacity_, 设置 weigher 时是 capacity_
+    */
+    void setPartitions(size_t capacity, size_t lruCapacity, size_t lfuCapacity) {
+        size_t oldTotal = lruCapacity + lfuCapacity;
+        size_t newTotal = weighted_ ? capacity : capacity * 2;
+        size_t newLruCapacity = (oldTotal == 0) ? newTotal - newTotal / 2 : newTotal * lruCapacity / oldTotal;
+        lruPart_->setCapacity(newLruCapacity, capacity);
+        lfuPart_->setCapacity(newTotal - newLruCapacity, capacity);
+        capacity_ = capacity;
+    }
+
+    bool hasTimers() const {
+        return lruPart_->hasTimers() || lfuPart_->hasTimers();
+    }
+
+    // 回收两部分中已经到期的节点, 没有设置过 TTL 的节点时不读时钟; 调用方持有 mutex_
+    void expireEntries() {
+        if (!hasTimers()) return;
+        now_ = cacheNowNanos();
+        lruPart_->expire(now_);
+        lfuPart_->expire(now_);
+    }
+
+    // 以下两个函数由调用方持有 mutex_, 并且已经调用过 expireEntries()
+    // expireAt 为绝对过期时间, 0 表示不过期
+    template<typename V>
+    void putLocked(const Key& key, V&& value, uint64_t expireAt = 0) {
+        // ghost缓存里没有该key就添加到缓存列表里
+        bool inGhost = checkGhostCaches(key);
+        // 按权重计算时 key 最多只在一部分中, 已经在 T2 中的 key 直接更新 T2
+        bool toLfu = (weighted_ || !inGhost) && lfuPart_->inLfuMainCache(key);
+        // 节点从 T1 复制到 T2 后两边各有一份, 另一份也要同步更新, 否则会读到旧值或者错过过期时间
+        if (toLfu) {
+            if (lruPart_->inLruMainCache(key)) lruPart_->put(key, static_cast<const Value&>(value), expireAt);
+            // key 在 LFU 缓存里
+            lfuPart_->put(key, std::forward<V>(value), expireAt);
         }
         else {
-            lruPart_->put(key, value);
+            if (lfuPart_->inLfuMainCache(key)) lfuPart_->put(key, static_cast<const Value&>(value), expireAt);
+            // key 在 LRU 缓存里
+            lruPart_->put(key, std::forward<V>(value), expireAt);
         }
     }
 
-    // get()增加LRU节点和LFU节点的访问次数
-    bool get(Key key, Value& value) override {
+    bool getLocked(const Key& key, Value& value) {
         // 节点在ghost缓存中就移出该节点并调整LRU和LFU的大小
         // 不在ghost缓存中什么也不做
         checkGhostCaches(key); 
         bool shouldTransform = false;
-        if (lruPart_->get(key, value, shouldTransform)) {
-            // 如果节点在LRU部分缓存中 并且访问次数达标, 就把该节点复制到LFU列表中
-            if (shouldTransform) lfuPart_->put(key, value); 
+        if (lruPart_->get(key, value, shouldTransform, now_)) {
+            // 如果节点在LRU部分缓存中 并且访问次数达标, 就把该节点复制到LFU列表中, 过期时间一并复制
+            // 按权重计算时改为移动: T2 接收后删除 T1 中的副本, 同一个条目不占两份预算
+            if (shouldTransform) {
+                lfuPart_->put(key, value, lruPart_->getExpireAt(key));
+                lfuPart_->markRead(key);
+                if (weighted_ && lfuPart_->inLfuMainCache(key)) lruPart_->remove(key);
+            }
+            stats_.hits.add();
             return true;
         }
         // 节点不在LRU部分缓存中, 就去LFU部分缓存中去找
-        return lfuPart_->get(key, value);
-    }
-
-    Value get(Key key) override {
-        Value value{};
-        get(key, value);
-        return value;
+        bool found = lfuPart_->get(key, value, now_);
+        if (found) {
+            stats_.hits.add();
+        }
+        else {
+            stats_.misses.add();
+        }
+        return found;
     }
 
-private:
-    bool checkGhostCaches(Key key) {
+    bool checkGhostCaches(const Key& key) {
         // 节点在ghost缓存中就移出该节点(移出节点的操作由checkGhost()方法完成)并调整LRU和LFU的大小
+        // 分区调整的步长是命中的 ghost 条目的权重, 不设置权重函数时为 1
         bool inGhost = false;
-        if (lruPart_->checkGhost(key)) {
+        size_t weight = 0;
+        if (lruPart_->checkGhost(key, weight)) {
             // 节点在LRU的ghost缓存中
-            if (lfuPart_->decreaseCapacity()) {
-                // 减少LFU部分的缓存大小并增加LRU部分的缓存大小
-                lruPart_->increaseCapacity();
+            // 减少LFU部分的缓存大小并增加LRU部分的缓存大小
+            size_t moved = lfuPart_->decreaseCapacity(weight);
+            if (moved > 0) {
+                lruPart_->increaseCapacity(moved);
             }
             inGhost = true;
+            stats_.lruGhostHits.add();
         }
-        else if (lfuPart_->checkGhost(key)) {
+        else if (lfuPart_->checkGhost(key, weight)) {
             // 节点在LFU的ghost缓存中
-            if (lruPart_->decreaseCapacity()) {
-                // 减少LRU部分的缓存大小并增加LFU部分的缓存大小
-                lfuPart_->increaseCapacity();
+            // 减少LRU部分的缓存大小并增加LFU部分的缓存大小
+            size_t moved = lruPart_->decreaseCapacity(weight);
+            if (moved > 0) {
+                lfuPart_->increaseCapacity(moved);
             }
             inGhost = true;
+            stats_.lfuGhostHits.add();
         }
+        if (inGhost) ghostHits_++;
         return inGhost;
     }
 
@@ -131,8 +524,33 @@ private:
 private: 
     size_t capacity_;
     size_t transformThreshold_;
-    std::unique_ptr<ArcLruPart<Key, Value>> lruPart_;
-    std::unique_ptr<ArcLfuPart<Key, Value>> lfuPart_;
+    bool weighted_;                 // 是否设置了 weigher, 决定分区之和与 T1 → T2 是复制还是移动
+    size_t ghostHits_ = 0;          // ghost 命中次数(说明该缓存容量不足)
+    uint64_t now_ = 0;              // 最近一次读取的时间, 只在有节点设置了 TTL 时更新
+    Mutex mutex_;                   // LRU/LFU 两部分及分区调整共用一把锁
+    CacheStats stats_;              // 统计计数器(锁内更新)
+    std::unique_ptr<ArcLruPart<Key, Value, Hash>> lruPart_;
+    std::unique_ptr<ArcLfuPart<Key, Value, Hash>> lfuPart_;
+};
+
+
+/**
+ * 对ARC进行分片, 提高高并发使用的性能
+ * · 每个分片是一个完整的 ArcCache, 在自己的锁内独立完成 T1/T2 分区调整
+ * · rebalanceCapacity() 按各分片的 ghost 命中次数在分片之间重新分配容量, 总容量不变
+*/
+template<typename Key, typename Value, typename Hash = CacheHash<Key>, typename Mutex = std::mutex>
+class HashArcCache : public ShardedCacheStrategy<ArcCache<Key, Value, Mutex, Hash>, 0, Hash> {
+public:
+    // 设置 weigher 后 capacity 为总权重预算, 平均分给各分片, 常驻条目的权重之和不超过它; 不设置时见 ArcCache 构造函数
+    HashArcCache(size_t capacity, int sliceNum, size_t transformThreshold = 3, CacheWeigher<Key, Value> weigher = nullptr)
+        : ShardedCacheStrategy<ArcCache<Key, Value, Mutex, Hash>, 0, Hash>(capacity, sliceNum, transformThreshold, weigher)
+    {}
+
+    // 分片间容量再平衡(由调用方定期调用), 按各分片上个周期的 ghost 命中次数分配, 见 ShardedCache::rebalanceCapacity()
+    void rebalanceCapacity(size_t minSliceCapacity = 1) {
+        this->sharded_.rebalanceCapacity([](ArcCache<Key, Value, Mutex, Hash>& slice) { return slice.takeGhostHits(); }, minSliceCapacity);
+    }
 };
 
 } // namespace Cache
\ No newline at end of file
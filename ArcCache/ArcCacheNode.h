@@ -1,34 +1,55 @@
 #pragma once
 
-#include <memory>
+#include <cstddef>
+#include <utility>
+
+#include "../CacheTimerWheel.h"
 
 namespace Cache {
 
+template<typename Key, typename Value> struct ArcFreqBucket;
+
+// 继承 TimerEntry, 设置了 TTL 的主缓存节点挂在所属部分的定时轮上, ghost 节点不调度
 template<typename Key, typename Value>
-class ArcNode {
+class ArcNode : public TimerEntry {
 private:
     Key key_;
     Value value_;
     size_t accessCount_;        // 访问次数
-    std::shared_ptr<ArcNode> prev_;
-    std::shared_ptr<ArcNode> next_;
+    size_t weight_;             // 条目权重, 插入和更新值时由所属部分计算
+    ArcNode* prev_;             // 侵入式链表指针, 节点内存由 NodePool 管理
+    ArcNode* next_;
+    ArcFreqBucket<Key, Value>* bucket_; // LFU部分中节点所在的频率桶, 不在频率桶中时为空
 
 public:
-    ArcNode(): accessCount_(1), prev_(nullptr), next_(nullptr) {}
+    ArcNode(): accessCount_(1), weight_(1), prev_(nullptr), next_(nullptr), bucket_(nullptr) {}
 
-    ArcNode(Key key, Value value)
+    ArcNode(const Key& key, const Value& value)
         : key_(key)
         , value_(value)
         , accessCount_(1)
+        , weight_(1)
         , prev_(nullptr)
         , next_(nullptr)
+        , bucket_(nullptr)
+    {}
+
+    ArcNode(const Key& key, Value&& value)
+        : key_(key)
+        , value_(std::move(value))
+        , accessCount_(1)
+        , weight_(1)
+        , prev_(nullptr)
+        , next_(nullptr)
+        , bucket_(nullptr)
     {}
 
     // Get()
-    Key getKey() const {
+    const Key& getKey() const {
         return key_;
     }
-    Value getValue() const {
+    // 返回引用, 调用方在锁内只做一次拷贝
+    const Value& getValue() const {
         return value_;
     }
     size_t getAccessCount() const {
@@ -39,12 +60,16 @@ public:
     void setValue(const Value& value) {
         value_ = value;
     }
+    void setValue(Value&& value) {
+        value_ = std::move(value);
+    }
     void increaseAccessCount() {
         accessCount_++;
     }
 
-    template<typename K, typename V> friend class ArcLruPart;
-    template<typename K, typename V> friend class ArcLfuPart;
+    template<typename K, typename V, typename H> friend class ArcLruPart;
+    template<typename K, typename V, typename H> friend class ArcLfuPart;
+    template<typename K, typename V> friend struct ArcFreqBucket;
 };
 
 } // namespace Cache
\ No newline at end of file
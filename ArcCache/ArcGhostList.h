@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../CacheFlatIndex.h"
+#include "../CacheHash.h"
+
+namespace Cache {
+
+/**
+ * 只保存 key 指纹的 ghost 列表 (ARC 的 B1/B2, 2Q 的 A1out)
+ * 1. ghost 只用来判断"最近是否淘汰过这个 key", 不需要 key 和 value 本身:
+ *    每个条目只有 64 位指纹(key 的哈希值)和权重, 按淘汰顺序放在一个 FIFO 环形数组里
+ * 2. 指纹 -> 环形数组中的序号 存在 FingerprintIndex 里, 查找、删除、淘汰最旧的条目都是 O(1);
+ *    从中间删除(ghost 命中)只把环形数组里的条目标记为空, 轮到它淘汰时直接跳过, 空条目过多时压缩
+ * 3. 每个条目约 16 字节 + 索引的 16 字节/0.75, 远小于一个完整的缓存节点
+ * 两个不同的 key 指纹相同(概率约 n / 2^64)时会被当作同一个 ghost, 只影响一次分区调整, 不影响正确性
+ * 本身不加锁, 由所属缓存的锁保护
+*/
+template<typename Key, typename Hash = CacheHash<Key>>
+class ArcGhostList {
+public:
+    explicit ArcGhostList(size_t expectedSize = 0) {
+        if (expectedSize > 0) {
+            index_.reserve(expectedSize);
+        }
+    }
+
+    static uint64_t fingerprintOf(const Key& key) {
+        return cacheHashOf(Hash(), key);
+    }
+
+    bool contains(const Key& key) const {
+        return index_.contains(fingerprintOf(key));
+    }
+
+    // 作为最新的 ghost 条目加入; 指纹已经在列表中时先移除旧的条目
+    void push(const Key& key, size_t weight) {
+        pushFingerprint(fingerprintOf(key), weight);
+    }
+
+    void pushFingerprint(uint64_t fingerprint, size_t weight) {
+        size_t oldWeight = 0;
+        removeFingerprint(fingerprint, oldWeight);
+        if (tail_ - head_ == ring_.size()) grow();
+        ring_[tail_ & mask_] = Entry{fingerprint, weight};
+        index_.insert(fingerprint, tail_);
+        tail_++;
+        weight_ += weight;
+    }
+
+    // 命中时移除并通过 weight 返回条目的权重
+    bool remove(const Key& key, size_t& weight) {
+        return removeFingerprint(fingerprintOf(key), weight);
+    }
+
+    // 淘汰最旧的条目, 列表为空时什么也不做
+    void removeOldest() {
+        skipRemoved();
+        if (head_ == tail_) return;
+        Entry& entry = ring_[head_ & mask_];
+        index_.erase(entry.fingerprint);
+        weight_ -= entry.weight;
+        head_++;
+    }
+
+    // 从最旧到最新遍历, func(指纹, 权重)
+    template<typename Func>
+    void forEach(Func&& func) const {
+        for (uint64_t seq = head_; seq != tail_; seq++) {
+            const Entry& entry = ring_[seq & mask_];
+            if (entry.weight != 0) func(entry.fingerprint, entry.weight);
+        }
+    }
+
+    void clear() {
+        index_.clear();
+        head_ = 0;
+        tail_ = 0;
+        weight_ = 0;
+    }
+
+    size_t size() const {
+        return index_.size();
+    }
+
+    // 所有条目的权重之和
+    size_t weight() const {
+        return weight_;
+    }
+
+private:
+    struct Entry {
+        uint64_t fingerprint;
+        size_t weight;          // 0 表示已经被移除
+    };
+
+    bool removeFingerprint(uint64_t fingerprint, size_t& weight) {
+        uint64_t seq = 0;
+        if (!index_.find(fingerprint, seq)) return false;
+        Entry& entry = ring_[seq & mask_];
+        weight = entry.weight;
+        weight_ -= entry.weight;
+        entry.weight = 0;
+        index_.erase(fingerprint);
+        skipRemoved();
+        return true;
+    }
+
+    void skipRemoved() {
+        while (head_ != tail_ && ring_[head_ & mask_].weight == 0) {
+            head_++;
+        }
+    }
+
+    // 环形数组满了: 有效条目不到一半时原地压缩, 否则扩容一倍; 序号重新从 0 开始
+    void grow() {
+        size_t live = index_.size();
+        size_t capacity = ring_.empty() ? kMinEntries : (live * 2 <= ring_.size() ? ring_.size() : ring_.size() * 2);
+        std::vector<Entry> ring(capacity);
+        uint64_t seq = 0;
+        for (uint64_t old = head_; old != tail_; old++) {
+            const Entry& entry = ring_[old & mask_];
+            if (entry.weight == 0) continue;
+            ring[seq] = entry;
+            index_.insert(entry.fingerprint, seq);
+            seq++;
+        }
+        ring_.swap(ring);
+        mask_ = capacity - 1;
+        head_ = 0;
+        tail_ = seq;
+    }
+
+private:
+    static constexpr size_t kMinEntries = 16;
+
+    std::vector<Entry> ring_;   // FIFO 环形数组, 大小为 2 的幂
+    size_t mask_ = 0;
+    uint64_t head_ = 0;         // 最旧条目的序号
+    uint64_t tail_ = 0;         // 下一个条目的序号
+    size_t weight_ = 0;
+    FingerprintIndex index_;    // 指纹 -> 序号
+};
+
+} // namespace Cache
@@ -3,212 +3,519 @@
  * · 在 LFU 中, 新加入的缓存项起初频率低, 可能在尚未证明其重要性时就被淘汰
  * · ARC保留了一个专门存储最近访问但被淘汰的数据队列 (ghost list), 帮助识别新数据的价值,
  *   如果某个新数据被多次访问, 可以快速将其提升为频繁访问的数据
- * LFU有一个ghost list淘汰链表, 存储从LLFU中淘汰的数据
+ * LFU有一个ghost list淘汰链表, 记录从LLFU中淘汰的数据(只保留 key 的指纹和权重, 见 ArcGhostList)
 */
 
 #pragma once
 
 #include "ArcCacheNode.h"
-#include <unordered_map>
-#include <map>
-#include <mutex>
-#include <list>
+#include "ArcGhostList.h"
+#include "../CacheStrategy.h"
+#include "../CacheNodePool.h"
+#include "../CacheFlatIndex.h"
+#include "../CacheMaintenance.h"
 
 
 namespace Cache {
 
+/**
+ * 频率桶: 访问频次相同的节点串成一条双向链表(尾插, 头部是该频次下最早进入的节点)
+ * 所有非空的桶按频次从小到大串成双向链表, 第一个桶就是最小频次
+ * 节点记录自己所在的桶, 频次 +1 时只需要挪到相邻的桶, 不需要遍历任何链表
+*/
 template<typename Key, typename Value>
+struct ArcFreqBucket {
+    using NodeType = ArcNode<Key, Value>;
+
+    size_t freq;
+    NodeType head;          // 虚拟头节点
+    NodeType tail;          // 虚拟尾节点
+    ArcFreqBucket* prev;    // 频次更小的桶
+    ArcFreqBucket* next;    // 频次更大的桶
+
+    explicit ArcFreqBucket(size_t f): freq(f), prev(nullptr), next(nullptr) {
+        head.next_ = &tail;
+        tail.prev_ = &head;
+    }
+
+    ArcFreqBucket(const ArcFreqBucket&) = delete;
+    ArcFreqBucket& operator=(const ArcFreqBucket&) = delete;
+
+    bool isEmpty() const {
+        return head.next_ == &tail;
+    }
+
+    void pushBack(NodeType* node) {
+        node->prev_ = tail.prev_;
+        node->next_ = &tail;
+        tail.prev_->next_ = node;
+        tail.prev_ = node;
+        node->bucket_ = this;
+    }
+
+    void unlink(NodeType* node) {
+        node->prev_->next_ = node->next_;
+        node->next_->prev_ = node->prev_;
+        node->prev_ = nullptr;
+        node->next_ = nullptr;
+        node->bucket_ = nullptr;
+    }
+};
+
+// ArcLfuPart 本身不加锁, 所有操作都在所属 ArcCache 的锁内完成
+template<typename Key, typename Value, typename Hash = CacheHash<Key>>
 class ArcLfuPart {
 public:
     using NodeType = ArcNode<Key, Value>;
-    using NodePtr = std::shared_ptr<NodeType>;
-    using NodeMap = std::unordered_map<Key, NodePtr>;
-    using FreqMap = std::map<size_t, std::list<NodePtr>>;   // 频率 -> 频率列表的有序映射
-
-    explicit ArcLfuPart(size_t capacity, size_t transformThreshold)
+    using NodePtr = NodeType*;
+    using NodeMap = FlatNodeIndex<Key, NodeType, Hash>;
+    using Bucket = ArcFreqBucket<Key, Value>;
+    using Weigher = CacheWeigher<Key, Value>;
+
+    // 内存池预留 主缓存, ghost 不占用节点
+    // 设置 weigher 后主缓存和ghost缓存的容量都是权重预算, 内存池和索引不再按容量预留
+    explicit ArcLfuPart(size_t capacity, size_t transformThreshold, Weigher weigher = nullptr)
         : capacity_(capacity)
         , ghostCapacity_(capacity)
+        , usedWeight_(0)
         , transformThreshold_(transformThreshold)
-        , minFreq_(0)
-    {
-        initializeLists();
+        , weigher_(std::move(weigher))
+        , nodePool_(weigher_ ? 0 : capacity)
+        , bucketPool_(16)
+        , mainCache_(weigher_ ? 0 : capacity)
+        , ghostCache_(weigher_ ? 0 : capacity)
+        , minBucket_(nullptr)
+    {}
+
+    ~ArcLfuPart() {
+        releaseAll();
     }
 
-    bool put(Key key, Value value) {
+    // expireAt 为绝对过期时间, 0 表示不过期
+    template<typename V>
+    bool put(const Key& key, V&& value, uint64_t expireAt = 0) {
         if (capacity_ == 0) return false;
 
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = mainCache_.find(key);
-        if (it != mainCache_.end()) {
-            updateExistingNode(it->second, value);
+        NodePtr node = mainCache_.find(key);
+        if (node != nullptr) {
+            updateExistingNode(node, std::forward<V>(value), expireAt);
         }
         else {
-            addNewNode(key, value);
+            addNewNode(key, std::forward<V>(value), expireAt);
         }
         return true;
     }
 
-    bool get(Key key, Value& value) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    // now 为当前时间, 已经过期但定时轮还没回收的节点在这里回收并视为未命中
+    bool get(const Key& key, Value& value, uint64_t now) {
         bool flag = false;
-        auto it = mainCache_.find(key);
-        if (it != mainCache_.end()) {
-            updateNodeFrequency(it->second);
-            value = it->second->getValue();
+        NodePtr node = mainCache_.find(key);
+        if (node != nullptr && node->isExpired(now)) {
+            removeExpired(node);
+            node = nullptr;
+        }
+        if (node != nullptr) {
+            updateNodeFrequency(node);
+            node->markRead();
+            value = node->getValue();
             flag = true;
         }
         return flag;
     }
 
-    bool inLfuMainCache(Key key) {
-        return mainCache_.find(key) != mainCache_.end();
+    // now 不为 0 时已过期的节点不算在主缓存中
+    bool inLfuMainCache(const Key& key, uint64_t now = 0) {
+        NodePtr node = mainCache_.find(key);
+        return node != nullptr && !node->isExpired(now);
     }
 
-    bool checkGhost(Key key) {
-        bool flag = false;
-        auto it = ghostCache_.find(key);
-        if (it != ghostCache_.end()) {
-            removeFromGhost(it->second);
-            ghostCache_.erase(it);
-            flag = true;
+    // 回收定时轮中到 now 为止已经到期的节点
+    void expire(uint64_t now) {
+        timerWheel_.advance(now, [this](TimerEntry* entry) {
+            removeExpired(static_cast<NodePtr>(entry));
+        });
+    }
+
+    bool hasTimers() const {
+        return !timerWheel_.empty();
+    }
+
+    // 命中ghost时通过 weight 返回该条目的权重, 作为分区调整的步长
+    bool checkGhost(const Key& key, size_t& weight) {
+        return ghostCache_.remove(key, weight);
+    }
+
+    void increaseCapacity(size_t delta = 1) {
+        capacity_ += delta;
+    }
+
+    // 容量最多减少 delta, 返回实际减少的量, 为 0 表示已经不能再减
+    size_t decreaseCapacity(size_t delta = 1) {
+        size_t shrink = std::min(delta, capacity_);
+        if (shrink == 0) return 0;
+        capacity_ -= shrink;
+        while (usedWeight_ > capacity_) {
+            evictLeastFrequent();
         }
-        return flag;
+        return shrink;
+    }
+
+    size_t getCapacity() const {
+        return capacity_;
+    }
+
+    size_t getSize() const {
+        return mainCache_.size();
+    }
+
+    size_t getWeight() const {
+        return usedWeight_;
+    }
+
+    size_t getGhostSize() const {
+        return ghostCache_.size();
+    }
+
+    // 累计插入/淘汰的节点数, 由 ArcCache 汇总进统计
+    size_t getInsertCount() const {
+        return insertCount_;
+    }
+
+    size_t getEvictionCount() const {
+        return evictionCount_;
+    }
+
+    size_t getExpirationCount() const {
+        return expirationCount_;
+    }
+
+    // 直接设置主缓存和ghost缓存的容量, 超出的部分按最小频次淘汰
+    void setCapacity(size_t capacity, size_t ghostCapacity) {
+        capacity_ = capacity;
+        ghostCapacity_ = ghostCapacity;
+        while (usedWeight_ > capacity_) {
+            evictLeastFrequent();
+        }
+        while (ghostCache_.weight() > ghostCapacity_) {
+            ghostCache_.removeOldest();
+        }
+    }
+
+    /**
+     * 快照用的遍历, 顺序即载入时的插入顺序
+     * 主缓存按频次从小到大、同频次从最早到最近, func(key, value, 频次, 过期时间); ghost 从最旧到最新, func(指纹, 权重)
+    */
+    template<typename Func>
+    void forEachMain(Func&& func) const {
+        for (Bucket* bucket = minBucket_; bucket != nullptr; bucket = bucket->next) {
+            for (NodePtr node = bucket->head.next_; node != &bucket->tail; node = node->next_) {
+                func(node->getKey(), node->getValue(), bucket->freq, node->expireAt_);
+            }
+        }
+    }
+
+    template<typename Func>
+    void forEachGhost(Func&& func) const {
+        ghostCache_.forEach(func);
+    }
+
+    /**
+     * 载入快照: 在 clear() 之后按 forEachMain() 的顺序调用, 节点追加到频次为 freq 的桶末尾
+     * 频次升序时新桶总是追加在桶链末尾, O(1); 已经在主缓存中的 key 忽略
+    */
+    template<typename V>
+    void restoreMain(const Key& key, V&& value, size_t freq, uint64_t expireAt) {
+        if (capacity_ == 0 || mainCache_.find(key) != nullptr) return;
+        NodePtr node = nodePool_.allocate(key, std::forward<V>(value));
+        node->weight_ = weigh(node);
+        if (node->weight_ > capacity_) {
+            nodePool_.deallocate(node);
+            return;
+        }
+        while (usedWeight_ + node->weight_ > capacity_) {
+            evictLeastFrequent();
+        }
+        freq = std::max<size_t>(1, freq);
+        // 快照不是按频次升序排列的(被改动过)时并入最后一个桶, 保证桶链有序
+        if (restoreTail_ != nullptr && freq < restoreTail_->freq) {
+            freq = restoreTail_->freq;
+        }
+        if (restoreTail_ == nullptr || restoreTail_->freq != freq) {
+            restoreTail_ = insertBucketAfter(restoreTail_, freq);
+        }
+        node->accessCount_ = freq;
+        restoreTail_->pushBack(node);
+        mainCache_.insert(key, node);
+        usedWeight_ += node->weight_;
+        insertCount_++;
+        if (expireAt != 0) {
+            timerWheel_.reschedule(node, expireAt);
+        }
+    }
+
+    // 载入快照: ghost 只恢复指纹和权重, 作为最新的 ghost 条目
+    void restoreGhost(uint64_t fingerprint, size_t weight) {
+        if (weight > ghostCapacity_) return;
+        while (ghostCache_.weight() + weight > ghostCapacity_) {
+            ghostCache_.removeOldest();
+        }
+        ghostCache_.pushFingerprint(fingerprint, weight);
+    }
+
+    // 淘汰监听器, 由所属 ArcCache 设置(它负责跳过另一部分中还有副本的 key)
+    void setEvictionListener(CacheEvictionListener<Key, Value> listener) {
+        evictionListener_ = std::move(listener);
+    }
+
+    // 延迟释放: 开启后淘汰、过期和覆盖的旧值移进待释放列表, 由所属 ArcCache 取走后在锁外析构
+    void setDeferredRelease(bool enabled) {
+        retired_.setEnabled(enabled);
     }
 
-    void increaseCapacity() {
-        capacity_++;
+    std::vector<Value> takeRetired() {
+        return retired_.take();
     }
 
-    bool decreaseCapacity() {
-        if (capacity_ <= 0) return true;
-        if (mainCache_.size() == capacity_) {
+    // 对 deadline 之前到期的主缓存节点调用 func(key, 上次写入之后是否被读过), 用于提前刷新
+    template<typename Func>
+    void forEachExpiringBefore(uint64_t deadline, Func&& func) {
+        timerWheel_.forEachExpiringBefore(deadline, [&](TimerEntry* entry) {
+            func(static_cast<NodePtr>(entry)->getKey(), entry->readSinceWrite());
+        });
+    }
+
+    // 删除主缓存中的 key, 不进入ghost缓存, 不通知监听器, 也不计入淘汰; key 不存在时返回 false
+    bool remove(const Key& key) {
+        NodePtr node = mainCache_.find(key);
+        if (node == nullptr) return false;
+        Bucket* bucket = node->bucket_;
+        bucket->unlink(node);
+        if (bucket->isEmpty()) {
+            removeBucket(bucket);
+        }
+        mainCache_.erase(node->getKey());
+        usedWeight_ -= node->weight_;
+        timerWheel_.deschedule(node);
+        retired_.retire(node->value_);
+        nodePool_.deallocate(node);
+        return true;
+    }
+
+    // 节点从 T1 转来时由 ArcCache 调用: 这次转移本身是一次读
+    void markRead(const Key& key) {
+        NodePtr node = mainCache_.find(key);
+        if (node != nullptr) node->markRead();
+    }
+
+    // 提前刷新的写回: 替换已有节点的值和过期时间, 不增加频次; key 不在主缓存中时返回 false
+    template<typename V>
+    bool refresh(const Key& key, V&& value, uint64_t expireAt) {
+        NodePtr node = mainCache_.find(key);
+        if (node == nullptr) return false;
+        retired_.retire(node->value_);
+        node->setValue(std::forward<V>(value));
+        node->markWritten();
+        timerWheel_.reschedule(node, expireAt);
+        size_t weight = weigh(node);
+        usedWeight_ = usedWeight_ - node->weight_ + weight;
+        node->weight_ = weight;
+        while (usedWeight_ > capacity_) {
             evictLeastFrequent();
         }
-        capacity_--;
         return true;
     }
 
+    // 清空主缓存和ghost缓存, 容量和累计计数保持不变
+    void clear() {
+        releaseAll();
+        mainCache_.clear();
+        ghostCache_.clear();
+        timerWheel_.clear();
+        usedWeight_ = 0;
+    }
+
 private:
-    // arcLfuPart只有一个ghost列表 
-    void initializeLists() {
-        ghostHead_ = std::make_shared<NodeType>();
-        ghostTail_ = std::make_shared<NodeType>();
-        ghostHead_->next_ = ghostTail_;
-        ghostTail_->prev_ = ghostHead_;
+    // 归还所有节点和频率桶
+    void releaseAll() {
+        mainCache_.forEach([this](NodePtr node) {
+            retired_.retire(node->value_);
+            nodePool_.deallocate(node);
+        });
+        while (minBucket_ != nullptr) {
+            Bucket* next = minBucket_->next;
+            bucketPool_.deallocate(minBucket_);
+            minBucket_ = next;
+        }
+        restoreTail_ = nullptr;
     }
 
-    void updateExistingNode(NodePtr node, const Value& value) {
-        node->setValue(value);
+    template<typename V>
+    void updateExistingNode(NodePtr node, V&& value, uint64_t expireAt) {
+        retired_.retire(node->value_);
+        node->setValue(std::forward<V>(value));
+        node->markWritten();
+        if (node->expireAt_ != expireAt) {
+            timerWheel_.reschedule(node, expireAt);
+        }
+        size_t weight = weigh(node);
+        usedWeight_ = usedWeight_ - node->weight_ + weight;
+        node->weight_ = weight;
         updateNodeFrequency(node);
+        // 新值变重后可能超出预算, 必要时连同这个节点本身一起淘汰
+        while (usedWeight_ > capacity_) {
+            evictLeastFrequent();
+        }
     }
 
-    void addNewNode(const Key& key, const Value& value) {
-        if (mainCache_.size() >= capacity_) {
+    size_t weigh(NodePtr node) const {
+        return weigher_ ? std::max<size_t>(1, weigher_(node->key_, node->value_)) : 1;
+    }
+
+    template<typename V>
+    void addNewNode(const Key& key, V&& value, uint64_t expireAt) {
+        NodePtr newNode = nodePool_.allocate(key, std::forward<V>(value));
+        newNode->weight_ = weigh(newNode);
+        if (newNode->weight_ > capacity_) {
+            // 单个条目就超过主缓存预算, 不缓存
+            nodePool_.deallocate(newNode);
+            return;
+        }
+        while (usedWeight_ + newNode->weight_ > capacity_) {
             evictLeastFrequent();
         }
 
-        NodePtr newNode = std::make_shared<NodeType>(key, value);
-        mainCache_[key] = newNode;
+        mainCache_.insert(key, newNode);
+        usedWeight_ += newNode->weight_;
+        insertCount_++;
         
-        // 将新节点加入到频率为 1 的频率列表里
-        if (freqMap_.find(1) == freqMap_.end()) {
-            freqMap_[1] = std::list<NodePtr>();
+        // 将新节点加入到频率为 1 的频率桶里, 频率为 1 的桶只可能是第一个桶
+        Bucket* bucket = minBucket_;
+        if (bucket == nullptr || bucket->freq != newNode->getAccessCount()) {
+            bucket = insertBucketAfter(nullptr, newNode->getAccessCount());
+        }
+        bucket->pushBack(newNode);
+        if (expireAt != 0) {
+            timerWheel_.reschedule(newNode, expireAt);
         }
-        freqMap_[1].emplace_back(newNode);
-        minFreq_ = 1;
     }
 
+    // 节点移动到相邻的 freq + 1 桶中, O(1)
     void updateNodeFrequency(NodePtr node) {
-        size_t oldFreq = node->getAccessCount();
+        Bucket* oldBucket = node->bucket_;
         node->increaseAccessCount();
         size_t newFreq = node->getAccessCount();
 
-        // 从旧的频率列表中移除
-        auto& oldList = freqMap_[oldFreq];
-        oldList.remove(node);
-        if (oldList.empty()) {
-            freqMap_.erase(oldFreq);
-            if (oldFreq == minFreq_) {
-                minFreq_ = newFreq;
-            }
+        // 添加到新的频率桶 如果相邻的桶频次不对就在它前面创建一个新的桶
+        Bucket* newBucket = oldBucket->next;
+        if (newBucket == nullptr || newBucket->freq != newFreq) {
+            newBucket = insertBucketAfter(oldBucket, newFreq);
         }
 
-        // 添加到新的频率列表 如果不存在就创建一个新的频率列表
-        if (freqMap_.find(newFreq) == freqMap_.end()) {
-            freqMap_[newFreq] = std::list<NodePtr>();
+        // 从旧的频率桶中移除, 空桶直接回收
+        oldBucket->unlink(node);
+        if (oldBucket->isEmpty()) {
+            removeBucket(oldBucket);
         }
-        freqMap_[newFreq].emplace_back(node);
+        newBucket->pushBack(node);
     }
 
-    void evictLeastFrequent() {
-        if (freqMap_.empty()) return;
-
-        // 获取最小频率列表
-        auto& minFreqList = freqMap_[minFreq_];
-        if (minFreqList.empty()) return;
-
-        // 移除最少使用的节点
-        NodePtr leastNode = minFreqList.front();
-        minFreqList.pop_front();
-
-        // 如果该频率列表为空, 则删除该频率映射
-        if (minFreqList.empty()) {
-            freqMap_.erase(minFreq_);
-            // 更新最小频率
-            if (!freqMap_.empty()) {
-                minFreq_ = freqMap_.begin()->first;
-            }
+    // 在 prev 之后插入频次为 freq 的新桶, prev 为空表示插入到最前面
+    Bucket* insertBucketAfter(Bucket* prev, size_t freq) {
+        Bucket* bucket = bucketPool_.allocate(freq);
+        Bucket* next = (prev == nullptr) ? minBucket_ : prev->next;
+        bucket->prev = prev;
+        bucket->next = next;
+        if (next != nullptr) next->prev = bucket;
+        if (prev != nullptr) {
+            prev->next = bucket;
         }
-
-        // 将节点移动到ghostCache
-        if (ghostCache_.size() >= ghostCapacity_) {
-            removeOldestGhost();
+        else {
+            minBucket_ = bucket;
         }
-        addToGhost(leastNode);
-
-        // 从主缓存中移除
-        mainCache_.erase(leastNode->getKey());
+        return bucket;
     }
 
-    void removeFromGhost(NodePtr node) {
-        node->prev_->next_ = node->next_;
-        node->next_->prev_ = node->prev_;    
+    void removeBucket(Bucket* bucket) {
+        if (bucket == restoreTail_) {
+            restoreTail_ = bucket->prev;
+        }
+        if (bucket->prev != nullptr) {
+            bucket->prev->next = bucket->next;
+        }
+        else {
+            minBucket_ = bucket->next;
+        }
+        if (bucket->next != nullptr) bucket->next->prev = bucket->prev;
+        bucketPool_.deallocate(bucket);
     }
 
-    // 尾插, 新的节点加入到尾部
-    void addToGhost(NodePtr node) {
-        // 重置节点的访问次数
-        node->accessCount_ = 1;
+    void evictLeastFrequent() {
+        // 第一个桶就是最小频率桶
+        Bucket* bucket = minBucket_;
+        if (bucket == nullptr || bucket->isEmpty()) return;
 
-        node->next_ = ghostTail_;
-        ghostTail_->prev_->next_ = node;
-        node->prev_ = ghostTail_->prev_;
-        ghostTail_->prev_ = node;
-        
-        ghostCache_[node->getKey()] = node;
+        // 移除最少使用的节点(最小频次下最早进入的节点)
+        NodePtr leastNode = bucket->head.next_;
+        bucket->unlink(leastNode);
+
+        // 如果该频率桶为空, 则回收该桶
+        if (bucket->isEmpty()) {
+            removeBucket(bucket);
+        }
+
+        // 从主缓存中移除
+        mainCache_.erase(leastNode->getKey());
+        usedWeight_ -= leastNode->weight_;
+        if (evictionListener_) evictionListener_(leastNode->getKey(), leastNode->value_, leastNode->expireAt_);
+        timerWheel_.deschedule(leastNode);
+
+        // 把 key 的指纹和权重加入ghostCache, 比整个ghost预算还重的条目不进入ghost; 节点连同值在这里释放
+        if (leastNode->weight_ <= ghostCapacity_) {
+            while (ghostCache_.weight() + leastNode->weight_ > ghostCapacity_) {
+                ghostCache_.removeOldest();
+            }
+            ghostCache_.push(leastNode->getKey(), leastNode->weight_);
+        }
+        retired_.retire(leastNode->value_);
+        nodePool_.deallocate(leastNode);
+        evictionCount_++;
     }
 
-    void removeOldestGhost() {
-        NodePtr oldestGhost = ghostHead_->next_;
-        if (oldestGhost != ghostTail_) {
-            removeFromGhost(oldestGhost);
-            ghostCache_.erase(oldestGhost->getKey());
+    // 过期的节点直接释放, 不进入ghost缓存
+    void removeExpired(NodePtr node) {
+        Bucket* bucket = node->bucket_;
+        bucket->unlink(node);
+        if (bucket->isEmpty()) {
+            removeBucket(bucket);
         }
+        mainCache_.erase(node->getKey());
+        usedWeight_ -= node->weight_;
+        timerWheel_.deschedule(node);
+        retired_.retire(node->value_);
+        nodePool_.deallocate(node);
+        expirationCount_++;
     }
 
+
 private:
-    size_t capacity_;
+    size_t capacity_;               // 主缓存容量(设置权重函数时为权重预算)
     size_t ghostCapacity_;
+    size_t usedWeight_;             // 主缓存中条目的权重之和
     size_t transformThreshold_;
-    size_t minFreq_;
-    std::mutex mutex_;
+    size_t insertCount_ = 0;        // 累计插入主缓存的节点数
+    size_t evictionCount_ = 0;      // 累计从主缓存淘汰(进入ghost)的节点数
+    size_t expirationCount_ = 0;    // 累计因 TTL 到期回收的节点数
+    Weigher weigher_;               // 权重函数, 为空时每个条目权重为 1
+    NodePool<NodeType> nodePool_;   // 主缓存节点内存池
+    NodePool<Bucket> bucketPool_;   // 频率桶内存池
 
     NodeMap mainCache_;
-    NodeMap ghostCache_;
-    FreqMap freqMap_;
-
-    NodePtr ghostHead_;
-    NodePtr ghostTail_;
+    ArcGhostList<Key, Hash> ghostCache_;    // 只保存指纹和权重
+    Bucket* minBucket_;             // 频率桶链表头, 即最小频次的桶
+    Bucket* restoreTail_ = nullptr; // 载入快照时最近一次追加的桶, 被回收时退回前一个桶
+    TimerWheel timerWheel_;         // 设置了 TTL 的主缓存节点
+    RetireList<Value> retired_;     // 延迟释放的旧值
+    CacheEvictionListener<Key, Value> evictionListener_;   // 容量淘汰时的回调, 可以为空
 };
 
 } // namespace Cache
\ No newline at end of file
@@ -4,121 +4,339 @@
  *   可能会导致热点数据被淘汰, 出现缓存抖动 (该被淘汰的数据又要访问)
  * ARC使用2个队列来分别跟踪最近访问 (类似LRU) 和经常访问 (类似LFU) 的数据, 
  *   并根据访问模式动态调整这两部分缓存的大小, 从而避免热点数据过早被淘汰
- * LRU有一个ghost list淘汰链表, 存储从LRU链表中淘汰的数据
+ * LRU有一个ghost list淘汰链表, 记录从LRU链表中淘汰的数据(只保留 key 的指纹和权重, 见 ArcGhostList)
 */
 
 #pragma once
 
 #include "ArcCacheNode.h"
-#include <unordered_map>
-#include <mutex>
+#include "ArcGhostList.h"
+#include "../CacheStrategy.h"
+#include "../CacheNodePool.h"
+#include "../CacheFlatIndex.h"
+#include "../CacheMaintenance.h"
 
 namespace Cache {
 
-template<typename Key, typename Value>
+// ArcLruPart 本身不加锁, 所有操作都在所属 ArcCache 的锁内完成
+template<typename Key, typename Value, typename Hash = CacheHash<Key>>
 class ArcLruPart {
 public:
     using NodeType = ArcNode<Key, Value>;
-    using NodePtr = std::shared_ptr<NodeType>;
-    using NodeMap = std::unordered_map<Key, NodePtr>;
+    using NodePtr = NodeType*;
+    using NodeMap = FlatNodeIndex<Key, NodeType, Hash>;
+    using Weigher = CacheWeigher<Key, Value>;
 
-    explicit ArcLruPart(size_t capacity, size_t transformThreshold)
+    // 内存池预留 主缓存 + 2个虚拟节点, ghost 不占用节点
+    // 设置 weigher 后主缓存和ghost缓存的容量都是权重预算, 内存池和索引不再按容量预留
+    explicit ArcLruPart(size_t capacity, size_t transformThreshold, Weigher weigher = nullptr)
         : capacity_(capacity)
         , ghostCapacity_(capacity)
+        , usedWeight_(0)
         , transformThreshold_(transformThreshold)
+        , weigher_(std::move(weigher))
+        , nodePool_(weigher_ ? 2 : capacity + 2)
+        , mainCache_(weigher_ ? 0 : capacity)
+        , ghostCache_(weigher_ ? 0 : capacity)
     {    
         initlizeLists();
     }
 
+    ~ArcLruPart() {
+        releaseList(mainHead_, false);
+    }
+
     // 在ARCLru中, put()方法不会会增加节点的访问次数
-    bool put(Key key, Value value) {
+    // expireAt 为绝对过期时间, 0 表示不过期
+    template<typename V>
+    bool put(const Key& key, V&& value, uint64_t expireAt = 0) {
         if (capacity_ == 0) return false;
 
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = mainCache_.find(key);
-        if (it != mainCache_.end()) {
+        NodePtr node = mainCache_.find(key);
+        if (node != nullptr) {
             // 在主缓存中
-            updateExistingNode(it->second, value);
+            updateExistingNode(node, std::forward<V>(value), expireAt);
         }
         else {
             // 不在主缓存中
-            addNewNode(key, value);
+            addNewNode(key, std::forward<V>(value), expireAt);
         }
         return true;
     }
 
     // 在ARCLru中, get()方法会增加一次节点的访问次数
-    bool get(Key key, Value& value, bool& shouldTransform) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    // now 为当前时间, 已经过期但定时轮还没回收的节点在这里回收并视为未命中
+    bool get(const Key& key, Value& value, bool& shouldTransform, uint64_t now) {
         bool flag = false;
-        auto it = mainCache_.find(key);
-        if (it != mainCache_.end()) {
-            shouldTransform = updateNodeAccess(it->second);
-            value = it->second->getValue();
+        NodePtr node = mainCache_.find(key);
+        if (node != nullptr && node->isExpired(now)) {
+            removeExpired(node);
+            node = nullptr;
+        }
+        if (node != nullptr) {
+            shouldTransform = updateNodeAccess(node);
+            node->markRead();
+            value = node->getValue();
             flag = true;
         }
         return flag;
     }
 
-    bool inLruMainCache(Key key) {
-        return mainCache_.find(key) != mainCache_.end();
+    // now 不为 0 时已过期的节点不算在主缓存中
+    bool inLruMainCache(const Key& key, uint64_t now = 0) {
+        NodePtr node = mainCache_.find(key);
+        return node != nullptr && !node->isExpired(now);
     }
 
-    bool checkGhost(Key key) {
-        auto it = ghostCache_.find(key);
-        bool flag = false;
-        // 在ghost缓存中就把这个节点移出ghost缓存, 并清空它的映射
-        if (it != ghostCache_.end()) {
-            removeFromGhost(it->second);
-            ghostCache_.erase(it);
-            flag = true;
-        }
-        return flag;
+    // 主缓存中节点的过期时间, 不存在或不过期时为 0
+    uint64_t getExpireAt(const Key& key) {
+        NodePtr node = mainCache_.find(key);
+        return node == nullptr ? 0 : node->expireAt_;
     }
 
-    void increaseCapacity() {
-        capacity_++;
+    // 上次写入之后是否被读过, 不在主缓存中时为 false
+    bool readSinceWrite(const Key& key) {
+        NodePtr node = mainCache_.find(key);
+        return node != nullptr && node->readSinceWrite();
     }
 
-    bool decreaseCapacity() {
-        if (capacity_ <= 0) return false;
-        if (mainCache_.size() == capacity_) {
+    // 提前刷新的写回: 替换已有节点的值和过期时间, 不调整访问顺序和访问次数; key 不在主缓存中时返回 false
+    template<typename V>
+    bool refresh(const Key& key, V&& value, uint64_t expireAt) {
+        NodePtr node = mainCache_.find(key);
+        if (node == nullptr) return false;
+        retired_.retire(node->value_);
+        node->setValue(std::forward<V>(value));
+        node->markWritten();
+        timerWheel_.reschedule(node, expireAt);
+        size_t weight = weigh(node);
+        usedWeight_ = usedWeight_ - node->weight_ + weight;
+        node->weight_ = weight;
+        while (usedWeight_ > capacity_) {
             evictLeastRecent();
         }
-        capacity_--;
         return true;
     }
 
+    // 删除主缓存中的 key(显式删除, 或者节点已经转到 T2), 不进入ghost缓存, 不通知监听器, 也不计入淘汰; key 不存在时返回 false
+    bool remove(const Key& key) {
+        NodePtr node = mainCache_.find(key);
+        if (node == nullptr) return false;
+        removeFromMain(node);
+        mainCache_.erase(node->getKey());
+        usedWeight_ -= node->weight_;
+        timerWheel_.deschedule(node);
+        retired_.retire(node->value_);
+        nodePool_.deallocate(node);
+        return true;
+    }
+
+    // 回收定时轮中到 now 为止已经到期的节点
+    void expire(uint64_t now) {
+        timerWheel_.advance(now, [this](TimerEntry* entry) {
+            removeExpired(static_cast<NodePtr>(entry));
+        });
+    }
+
+    bool hasTimers() const {
+        return !timerWheel_.empty();
+    }
+
+    // 命中ghost时通过 weight 返回该条目的权重, 作为分区调整的步长
+    bool checkGhost(const Key& key, size_t& weight) {
+        // 在ghost缓存中就把这个条目移出ghost缓存
+        return ghostCache_.remove(key, weight);
+    }
+
+    void increaseCapacity(size_t delta = 1) {
+        capacity_ += delta;
+    }
+
+    // 容量最多减少 delta, 返回实际减少的量, 为 0 表示已经不能再减
+    size_t decreaseCapacity(size_t delta = 1) {
+        size_t shrink = std::min(delta, capacity_);
+        if (shrink == 0) return 0;
+        capacity_ -= shrink;
+        while (usedWeight_ > capacity_) {
+            evictLeastRecent();
+        }
+        return shrink;
+    }
+
+    size_t getCapacity() const {
+        return capacity_;
+    }
+
+    size_t getSize() const {
+        return mainCache_.size();
+    }
+
+    size_t getWeight() const {
+        return usedWeight_;
+    }
+
+    size_t getGhostSize() const {
+        return ghostCache_.size();
+    }
+
+    // 累计插入/淘汰的节点数, 由 ArcCache 汇总进统计
+    size_t getInsertCount() const {
+        return insertCount_;
+    }
+
+    size_t getEvictionCount() const {
+        return evictionCount_;
+    }
+
+    size_t getExpirationCount() const {
+        return expirationCount_;
+    }
+
+    // 直接设置主缓存和ghost缓存的容量, 超出的部分按LRU顺序淘汰
+    void setCapacity(size_t capacity, size_t ghostCapacity) {
+        capacity_ = capacity;
+        ghostCapacity_ = ghostCapacity;
+        while (usedWeight_ > capacity_) {
+            evictLeastRecent();
+        }
+        while (ghostCache_.weight() > ghostCapacity_) {
+            ghostCache_.removeOldest();
+        }
+    }
+
+    /**
+     * 快照用的遍历, 顺序即载入时的插入顺序
+     * 主缓存从最久未访问到最近访问, func(key, value, 访问次数, 过期时间); ghost 从最旧到最新, func(指纹, 权重)
+    */
+    template<typename Func>
+    void forEachMain(Func&& func) const {
+        for (NodePtr node = mainTail_->prev_; node != mainHead_; node = node->prev_) {
+            func(node->getKey(), node->getValue(), node->getAccessCount(), node->expireAt_);
+        }
+    }
+
+    template<typename Func>
+    void forEachGhost(Func&& func) const {
+        ghostCache_.forEach(func);
+    }
+
+    // 载入快照: 插入为最近访问的节点并恢复访问次数, 已经在主缓存中的 key 忽略
+    template<typename V>
+    void restoreMain(const Key& key, V&& value, size_t accessCount, uint64_t expireAt) {
+        if (capacity_ == 0 || mainCache_.find(key) != nullptr) return;
+        NodePtr node = addNewNode(key, std::forward<V>(value), expireAt);
+        if (node != nullptr) {
+            node->accessCount_ = std::max<size_t>(1, accessCount);
+        }
+    }
+
+    // 载入快照: ghost 只恢复指纹和权重, 作为最新的 ghost 条目
+    void restoreGhost(uint64_t fingerprint, size_t weight) {
+        if (weight > ghostCapacity_) return;
+        while (ghostCache_.weight() + weight > ghostCapacity_) {
+            ghostCache_.removeOldest();
+        }
+        ghostCache_.pushFingerprint(fingerprint, weight);
+    }
+
+    // 淘汰监听器, 由所属 ArcCache 设置(它负责跳过另一部分中还有副本的 key)
+    void setEvictionListener(CacheEvictionListener<Key, Value> listener) {
+        evictionListener_ = std::move(listener);
+    }
+
+    // 延迟释放: 开启后淘汰、过期和覆盖的旧值移进待释放列表, 由所属 ArcCache 取走后在锁外析构
+    void setDeferredRelease(bool enabled) {
+        retired_.setEnabled(enabled);
+    }
+
+    std::vector<Value> takeRetired() {
+        return retired_.take();
+    }
+
+    // 对 deadline 之前到期的主缓存节点调用 func(key, 上次写入之后是否被读过), 用于提前刷新
+    template<typename Func>
+    void forEachExpiringBefore(uint64_t deadline, Func&& func) {
+        timerWheel_.forEachExpiringBefore(deadline, [&](TimerEntry* entry) {
+            func(static_cast<NodePtr>(entry)->getKey(), entry->readSinceWrite());
+        });
+    }
+
+    // 清空主缓存和ghost缓存, 容量和累计计数保持不变
+    void clear() {
+        releaseList(mainHead_, true);
+        mainCache_.clear();
+        ghostCache_.clear();
+        timerWheel_.clear();
+        usedWeight_ = 0;
+        initlizeLists();
+    }
+
 private:
     void initlizeLists() {
-        mainHead_ = std::make_shared<NodeType>();
-        mainTail_ = std::make_shared<NodeType>();
+        mainHead_ = nodePool_.allocate();
+        mainTail_ = nodePool_.allocate();
         mainHead_->next_ = mainTail_;
         mainTail_->prev_ = mainHead_;
+    }
 
-        ghostHead_ = std::make_shared<NodeType>();
-        ghostTail_ = std::make_shared<NodeType>();
-        ghostHead_->next_ = ghostTail_;
-        ghostTail_->prev_ = ghostHead_;
+    // 归还一条链表上的所有节点(含首尾虚拟节点), retire 为 true 时值交给延迟释放
+    void releaseList(NodePtr head, bool retire) {
+        while (head != nullptr) {
+            NodePtr next = head->next_;
+            if (retire) retired_.retire(head->value_);
+            nodePool_.deallocate(head);
+            head = next;
+        }
     }
 
-    void updateExistingNode(NodePtr node, const Value value) {
+    template<typename V>
+    void updateExistingNode(NodePtr node, V&& value, uint64_t expireAt) {
         // 改变value
-        node->setValue(value);
+        retired_.retire(node->value_);
+        node->setValue(std::forward<V>(value));
+        node->markWritten();
+        if (node->expireAt_ != expireAt) {
+            timerWheel_.reschedule(node, expireAt);
+        }
+        size_t weight = weigh(node);
+        usedWeight_ = usedWeight_ - node->weight_ + weight;
+        node->weight_ = weight;
         // 移到链表头表示刚刚访问
         moveToFront(node);
+        // 新值变重后可能超出预算, 必要时连同这个节点本身一起淘汰
+        while (usedWeight_ > capacity_) {
+            evictLeastRecent();
+        }
+    }
+
+    size_t weigh(NodePtr node) const {
+        return weigher_ ? std::max<size_t>(1, weigher_(node->key_, node->value_)) : 1;
     }
 
-    void addNewNode(const Key& key, const Value& value) {
-        if (mainCache_.size() >= capacity_) {
+    // 返回新节点, 没有缓存时返回空
+    template<typename V>
+    NodePtr addNewNode(const Key& key, V&& value, uint64_t expireAt) {
+        NodePtr newNode = nodePool_.allocate(key, std::forward<V>(value));
+        newNode->weight_ = weigh(newNode);
+        if (newNode->weight_ > capacity_) {
+            // 单个条目就超过主缓存预算, 不缓存
+            nodePool_.deallocate(newNode);
+            return nullptr;
+        }
+        while (usedWeight_ + newNode->weight_ > capacity_) {
             // 主缓存已满则驱逐最近最少访问
             evictLeastRecent();
         }
 
-        NodePtr newNode = std::make_shared<NodeType>(key, value);
         // 加入到主缓存映射中
-        mainCache_[key] = newNode;
+        mainCache_.insert(key, newNode);
+        usedWeight_ += newNode->weight_;
+        insertCount_++;
         addToFront(newNode);
+        if (expireAt != 0) {
+            timerWheel_.reschedule(newNode, expireAt);
+        }
+        return newNode;
     }
 
     bool updateNodeAccess(NodePtr node) {
@@ -150,64 +368,61 @@ private:
 
         // 从主链表中移除
         removeFromMain(leastRecent);
-
-        // 添加到ghostList, 如果ghost列表满了就淘汰最尾部的节点
-        if (ghostCache_.size() >= ghostCapacity_) {
-            removeOldestGhost();
-        }
-        addToGhost(leastRecent);
-
         // 从主缓存映射中移除
         mainCache_.erase(leastRecent->getKey());
+        usedWeight_ -= leastRecent->weight_;
+        if (evictionListener_) evictionListener_(leastRecent->getKey(), leastRecent->value_, leastRecent->expireAt_);
+        timerWheel_.deschedule(leastRecent);
+
+        // 把 key 的指纹和权重加入ghostList, 如果ghost列表满了就淘汰最旧的条目; 比整个ghost预算还重的条目不进入ghost
+        // 节点连同值在这里释放
+        if (leastRecent->weight_ <= ghostCapacity_) {
+            while (ghostCache_.weight() + leastRecent->weight_ > ghostCapacity_) {
+                ghostCache_.removeOldest();
+            }
+            ghostCache_.push(leastRecent->getKey(), leastRecent->weight_);
+        }
+        retired_.retire(leastRecent->value_);
+        nodePool_.deallocate(leastRecent);
+        evictionCount_++;
     }
 
-    void removeFromMain(NodePtr node) {
-        node->prev_->next_ = node->next_;
-        node->next_->prev_ = node->prev_;
+    // 过期的节点直接释放, 不进入ghost缓存
+    void removeExpired(NodePtr node) {
+        removeFromMain(node);
+        mainCache_.erase(node->getKey());
+        usedWeight_ -= node->weight_;
+        timerWheel_.deschedule(node);
+        retired_.retire(node->value_);
+        nodePool_.deallocate(node);
+        expirationCount_++;
     }
 
-    void removeFromGhost(NodePtr node) {
+    void removeFromMain(NodePtr node) {
         node->prev_->next_ = node->next_;
         node->next_->prev_ = node->prev_;
     }
 
-    void addToGhost(NodePtr node) {
-        // 加入到ghost列表需要重置节点的访问计数
-        node->accessCount_ = 1;
-
-        // 添加到ghostList的头部
-        node->next_ = ghostHead_->next_;
-        ghostHead_->next_ = node;
-        node->next_->prev_ = node;
-        node->prev_ = ghostHead_;
-
-        // 添加到ghost缓存映射
-        ghostCache_[node->getKey()] = node;
-    }
-
-    void removeOldestGhost() {
-        NodePtr oldestGhost = ghostTail_->prev_;
-
-        if (oldestGhost == ghostHead_) return;
-
-        removeFromGhost(oldestGhost);
-        ghostCache_.erase(oldestGhost->getKey());
-    }
 
 private:
-    size_t capacity_;               // 主缓存容量
+    size_t capacity_;               // 主缓存容量(设置权重函数时为权重预算)
     size_t ghostCapacity_;          // ghost缓存容量
+    size_t usedWeight_;             // 主缓存中条目的权重之和
     size_t transformThreshold_;     // 转换阈值
-    std::mutex mutex_;           
+    size_t insertCount_ = 0;        // 累计插入主缓存的节点数
+    size_t evictionCount_ = 0;      // 累计从主缓存淘汰(进入ghost)的节点数
+    size_t expirationCount_ = 0;    // 累计因 TTL 到期回收的节点数
+    Weigher weigher_;               // 权重函数, 为空时每个条目权重为 1
+    NodePool<NodeType> nodePool_;   // 主缓存节点内存池
 
     NodeMap mainCache_;
-    NodeMap ghostCache_;
+    ArcGhostList<Key, Hash> ghostCache_;    // 只保存指纹和权重
+    TimerWheel timerWheel_;         // 设置了 TTL 的主缓存节点
+    RetireList<Value> retired_;     // 延迟释放的旧值
+    CacheEvictionListener<Key, Value> evictionListener_;   // 容量淘汰时的回调, 可以为空
 
     NodePtr mainHead_;
     NodePtr mainTail_;
-
-    NodePtr ghostHead_;
-    NodePtr ghostTail_;
 };
 
 } // namespace Cache
\ No newline at end of file
@@ -0,0 +1,535 @@
+/**
+ * 标准 ARC (Megiddo & Modha "ARC: A Self-Tuning, Low Overhead Replacement Cache")
+ * 与 ArcCache 的区别:
+ * 1. T1/T2 共用一个容量 c, 不再各自持有容量; 自适应参数 p 是 T1 的目标大小, T2 的目标大小为 c - p
+ * 2. 再次命中的条目从 T1 移动(而不是复制)到 T2 的 MRU 端, 每个 key 最多只有一份, 不会重复占用容量
+ * 3. p 按 ghost 列表的大小之比调整: B1 命中时 p 增加 max(1, |B2|/|B1|), B2 命中时减少 max(1, |B1|/|B2|),
+ *    工作负载的阶段变化时一次 ghost 命中就能移动多个单位, 而不是每次只挪一个条目
+ * 4. 淘汰(REPLACE): |T1| 超过 p (或者 B2 命中且 |T1| 等于 p)时淘汰 T1 的 LRU 进入 B1, 否则淘汰 T2 的 LRU 进入 B2
+ * 5. 目录大小保持 |T1| + |B1| <= c, |T1| + |T2| + |B1| + |B2| <= 2c; ghost 只保存 key 的指纹(ArcGhostList)
+ * 设置权重函数时以上的"大小"都按权重计算
+*/
+
+#pragma once
+
+#include "../CacheStrategy.h"
+#include "../CacheBatch.h"
+#include "../CacheSharded.h"
+#include "../CacheNodePool.h"
+#include "../CacheFlatIndex.h"
+#include "../CacheMaintenance.h"
+#include "../CacheTimerWheel.h"
+#include "../CacheLock.h"
+#include "ArcGhostList.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Cache {
+
+template<typename Key, typename Value, typename Mutex = std::mutex, typename Hash = CacheHash<Key>> class ExactArcCache;
+
+// 继承 TimerEntry, 设置了 TTL 的节点挂在定时轮上
+template<typename Key, typename Value>
+class ExactArcNode : public TimerEntry {
+private:
+    Key key_;
+    Value value_;
+    size_t weight_;             // 条目权重, 插入和更新值时计算
+    bool inT2_;                 // 所在的链表: T1 (只访问过一次) 或 T2 (至少访问过两次)
+    ExactArcNode* prev_;        // 侵入式循环链表指针, 节点内存由 NodePool 管理
+    ExactArcNode* next_;
+
+public:
+    // 链表的虚拟头节点
+    ExactArcNode(): weight_(0), inT2_(false), prev_(this), next_(this) {}
+
+    template<typename... Args>
+    explicit ExactArcNode(const Key& key, Args&&... args)
+        : key_(key)
+        , value_(std::forward<Args>(args)...)
+        , weight_(1)
+        , inT2_(false)
+        , prev_(nullptr)
+        , next_(nullptr)
+    {}
+
+    const Key& getKey() const {
+        return key_;
+    }
+    const Value& getValue() const {
+        return value_;
+    }
+
+    template<typename, typename, typename, typename> friend class ExactArcCache;
+};
+
+
+// Mutex 为锁策略, 见 CacheLock.h
+template<typename Key, typename Value, typename Mutex, typename Hash>
+class ExactArcCache : public CacheStrategy<Key, Value> {
+public:
+    using NodeType = ExactArcNode<Key, Value>;
+    using NodePtr = NodeType*;
+    using NodeMap = FlatNodeIndex<Key, NodeType, Hash>;
+    using Weigher = CacheWeigher<Key, Value>;
+
+    // 设置 weigher 后 capacity 为总权重预算, p 和各列表的大小也都按权重计算
+    explicit ExactArcCache(size_t capacity = 10, Weigher weigher = nullptr)
+        : capacity_(capacity)
+        , weigher_(std::move(weigher))
+        , nodePool_(weigher_ ? 0 : capacity)
+        , nodeMap_(weigher_ ? 0 : capacity)
+        , b1_(weigher_ ? 0 : capacity)
+        , b2_(weigher_ ? 0 : capacity)
+    {
+        this->template useLoadHash<Hash>();
+    }
+
+    ~ExactArcCache() override {
+        this->cancelLoads();
+        clearLocked();
+    }
+
+    void put(const Key& key, const Value& value) override {
+        putImpl(key, 0, value);
+    }
+
+    void put(const Key& key, Value&& value) override {
+        putImpl(key, 0, std::move(value));
+    }
+
+    // 带 TTL 的添加: ttl 之后条目失效, 由定时轮回收, 不进入 ghost 列表; 不带 ttl 的 put() 会清除已有的过期时间
+    void put(const Key& key, const Value& value, std::chrono::nanoseconds ttl) {
+        putImpl(key, cacheExpireAt(ttl), value);
+    }
+
+    void put(const Key& key, Value&& value, std::chrono::nanoseconds ttl) {
+        putImpl(key, cacheExpireAt(ttl), std::move(value));
+    }
+
+    // key 不在缓存中时直接在新节点里构造值; key 已存在时构造新值并移动赋值
+    template<typename... Args>
+    void emplace(const Key& key, Args&&... args) {
+        putImpl(key, 0, std::forward<Args>(args)...);
+    }
+
+    // 命中时条目移到 T2 的 MRU 端
+    bool get(const Key& key, Value& value) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        return getLocked(nodeMap_.find(key), value);
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 只查 T1/T2 的索引, ghost 不算在缓存中, 不调整访问顺序
+    bool contains(const Key& key) override {
+        std::lock_guard<Mutex> lock(mutex_);
+        NodePtr node = nodeMap_.find(key);
+        return node != nullptr && (node->expireAt_ == 0 || !node->isExpired(cacheNowNanos()));
+    }
+
+    // 删除 T1/T2 中的条目, 不进入 B1/B2, p 不变
+    void remove(const Key& key) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        NodePtr node = nodeMap_.find(key);
+        if (node == nullptr) return;
+        unlink(node);
+        nodeMap_.erase(key);
+        timerWheel_.deschedule(node);
+        retired_.retire(node->value_);
+        nodePool_.deallocate(node);
+    }
+
+    size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) override {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        return getBatch(keys, nullptr, keys.size(), values, found);
+    }
+
+    void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) override {
+        putBatch(keys, values, nullptr, std::min(keys.size(), values.size()));
+    }
+
+    /**
+     * 批量查找的分片入口: 只处理 indices 指定的 count 个下标(indices 为空表示 0..count-1), 整批只加一次锁
+     * 只有一个索引, 按 forEachBatched 先算哈希并预取, 再逐个查找
+    */
+    size_t getBatch(const std::vector<Key>& keys, const size_t* indices, size_t count,
+                    std::vector<Value>& values, std::vector<bool>& found) {
+        size_t hits = 0;
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            if (getLocked(nodeMap_.find(keys[i], hash), values[i])) {
+                found[i] = true;
+                hits++;
+            }
+        });
+        return hits;
+    }
+
+    // 批量添加的分片入口, 下标含义同 getBatch()
+    void putBatch(const std::vector<Key>& keys, const std::vector<Value>& values, const size_t* indices, size_t count) {
+        if (capacity_ == 0) return;
+
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            putLocked(keys[i], nodeMap_.find(keys[i], hash), 0, values[i]);
+        });
+    }
+
+    // 立即回收所有已经到期的条目; 读写操作本身也会顺带回收, 这里用于长时间没有访问的缓存
+    void purgeExpired() {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+    }
+
+    // 清空 T1/T2 和两个 ghost 列表, p 恢复为 0
+    void purge() {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        clearLocked();
+    }
+
+    // T1 的目标大小 p, 用于观察自适应状态
+    size_t getTargetT1() {
+        std::lock_guard<Mutex> lock(mutex_);
+        return p_;
+    }
+
+    // 淘汰监听器, 传入空函数时取消; 见 CacheEvictionListener
+    void setEvictionListener(CacheEvictionListener<Key, Value> listener) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        evictionListener_ = std::move(listener);
+    }
+
+    // 延迟释放: 开启后淘汰、过期和覆盖的旧值移进待释放列表, 由 runMaintenance() 在锁外析构
+    void setDeferredRelease(bool enabled) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        retired_.setEnabled(enabled);
+    }
+
+    // 一次后台维护: 回收到期条目, 待释放的旧值在锁外析构
+    void runMaintenance() {
+        std::vector<Value> retired;
+        {
+            StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+            expireEntries();
+            retired = retired_.take();
+        }
+    }
+
+    // window 之内到期、并且上次写入之后被读过的条目的 key, 用于提前刷新
+    std::vector<Key> expiringKeys(std::chrono::nanoseconds window) {
+        std::vector<Key> keys;
+        std::lock_guard<Mutex> lock(mutex_);
+        if (timerWheel_.empty()) return keys;
+        uint64_t deadline = cacheNowNanos() + static_cast<uint64_t>(window.count());
+        timerWheel_.forEachExpiringBefore(deadline, [&](TimerEntry* entry) {
+            if (entry->readSinceWrite()) keys.push_back(static_cast<NodePtr>(entry)->getKey());
+        });
+        return keys;
+    }
+
+    // 提前刷新的写回: 只替换已有条目的值并以 ttl 续期, 不在 T1/T2 之间移动也不算命中; 条目已经不在缓存中时返回 false
+    template<typename V>
+    bool refresh(const Key& key, V&& value, std::chrono::nanoseconds ttl) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        NodePtr node = nodeMap_.find(key);
+        if (node == nullptr || node->isExpired(now_)) return false;
+        retired_.retire(node->value_);
+        node->value_ = std::forward<V>(value);
+        node->markWritten();
+        timerWheel_.reschedule(node, cacheExpireAt(ttl));
+        reweigh(node);
+        replace(0, false);
+        return true;
+    }
+
+    /**
+     * 统计快照, 复用 ARC 的分区字段:
+     * lruPartCapacity/lfuPartCapacity 为 T1/T2 的目标大小 p 和 c - p, 其余为 T1/T2/B1/B2 的条目数
+    */
+    CacheStatsSnapshot getStats() override {
+        CacheStatsSnapshot snapshot;
+        stats_.addTo(snapshot);
+        std::lock_guard<Mutex> lock(mutex_);
+        snapshot.lruPartCapacity = p_;
+        snapshot.lfuPartCapacity = capacity_ - p_;
+        snapshot.lruPartSize = t1Count_;
+        snapshot.lfuPartSize = nodeMap_.size() - t1Count_;
+        snapshot.lruGhostSize = b1_.size();
+        snapshot.lfuGhostSize = b2_.size();
+        snapshot.size = nodeMap_.size();
+        snapshot.weight = t1Weight_ + t2Weight_;
+        return snapshot;
+    }
+
+private:
+    template<typename... Args>
+    void putImpl(const Key& key, uint64_t expireAt, Args&&... args) {
+        if (capacity_ == 0) return;
+
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        putLocked(key, nodeMap_.find(key), expireAt, std::forward<Args>(args)...);
+    }
+
+    // 以下函数由调用方持有 mutex_, 并且已经调用过 expireEntries()
+    bool getLocked(NodePtr node, Value& value) {
+        if (node != nullptr && node->isExpired(now_)) {
+            removeExpired(node);
+            node = nullptr;
+        }
+        if (node == nullptr) {
+            stats_.misses.add();
+            return false;
+        }
+        touch(node);
+        node->markRead();
+        value = node->value_;
+        stats_.hits.add();
+        return true;
+    }
+
+    // expireAt 为绝对过期时间, 0 表示不过期
+    template<typename... Args>
+    void putLocked(const Key& key, NodePtr node, uint64_t expireAt, Args&&... args) {
+        if (node != nullptr && node->isExpired(now_)) {
+            removeExpired(node);
+            node = nullptr;
+        }
+        if (node != nullptr) {
+            // 已经在 T1/T2 中: 更新值, 按命中处理
+            retired_.retire(node->value_);
+            node->value_ = Value(std::forward<Args>(args)...);
+            node->markWritten();
+            if (node->expireAt_ != expireAt) {
+                timerWheel_.reschedule(node, expireAt);
+            }
+            reweigh(node);
+            touch(node);
+            // 新值变重后可能超出预算, 必要时连同这个节点本身一起淘汰
+            replace(0, false);
+            return;
+        }
+
+        node = nodePool_.allocate(key, std::forward<Args>(args)...);
+        node->weight_ = weigh(node);
+        if (node->weight_ > capacity_) {
+            // 单个条目就超过总预算, 不缓存
+            nodePool_.deallocate(node);
+            return;
+        }
+        size_t weight = node->weight_;
+        size_t b1Weight = b1_.weight();
+        size_t b2Weight = b2_.weight();
+        size_t ghostWeight = 0;
+        if (b1_.remove(key, ghostWeight)) {
+            // B1 命中: 说明 T1 太小, p 增加 max(1, |B2|/|B1|)
+            size_t delta = b1Weight >= b2Weight ? ghostWeight : std::max(ghostWeight, ghostWeight * b2Weight / b1Weight);
+            p_ = std::min(capacity_, p_ + delta);
+            stats_.lruGhostHits.add();
+            replace(weight, false);
+            link(node, true);
+        }
+        else if (b2_.remove(key, ghostWeight)) {
+            // B2 命中: 说明 T2 太小, p 减少 max(1, |B1|/|B2|)
+            size_t delta = b2Weight >= b1Weight ? ghostWeight : std::max(ghostWeight, ghostWeight * b1Weight / b2Weight);
+            p_ = p_ > delta ? p_ - delta : 0;
+            stats_.lfuGhostHits.add();
+            replace(weight, true);
+            link(node, true);
+        }
+        else {
+            // 完全未命中: |T1| + |B1| 已满时先丢弃 B1 中最旧的条目, B1 为空时直接淘汰 T1 的 LRU(不进入 ghost)
+            while (t1Weight_ + b1_.weight() + weight > capacity_ && b1_.size() > 0) {
+                b1_.removeOldest();
+            }
+            while (t1Weight_ + b1_.weight() + weight > capacity_ && t1Weight_ > 0) {
+                evict(t1_.prev_, false);
+            }
+            // 整个目录超过 2c 时丢弃 B2 中最旧的条目
+            while (directoryWeight() + weight > capacity_ * 2 && b2_.size() > 0) {
+                b2_.removeOldest();
+            }
+            replace(weight, false);
+            link(node, false);
+        }
+        timerWheel_.reschedule(node, expireAt);
+        nodeMap_.insert(key, node);
+        stats_.inserts.add();
+        trimGhosts();
+    }
+
+    /**
+     * REPLACE: 直到 T1 + T2 能放下 incoming 为止, 按 p 从 T1 或 T2 的 LRU 端淘汰, 淘汰的条目进入对应的 ghost 列表
+     * b2Hit 表示本次插入的是 B2 命中的 key, 此时 |T1| 等于 p 也从 T1 淘汰
+    */
+    void replace(size_t incoming, bool b2Hit) {
+        while (t1Weight_ + t2Weight_ + incoming > capacity_ && !nodeMap_.empty()) {
+            bool fromT1 = t1Weight_ > 0 && (t1Weight_ > p_ || (b2Hit && t1Weight_ == p_) || t2Weight_ == 0);
+            evict(fromT1 ? t1_.prev_ : t2_.prev_, true);
+        }
+    }
+
+    // ghost 列表只会在条目的权重变化时略微超出目录的上限, 这里兜底
+    void trimGhosts() {
+        while (t1Weight_ + b1_.weight() > capacity_ && b1_.size() > 0) {
+            b1_.removeOldest();
+        }
+        while (directoryWeight() > capacity_ * 2 && b2_.size() > 0) {
+            b2_.removeOldest();
+        }
+        while (directoryWeight() > capacity_ * 2 && b1_.size() > 0) {
+            b1_.removeOldest();
+        }
+    }
+
+    size_t directoryWeight() const {
+        return t1Weight_ + t2Weight_ + b1_.weight() + b2_.weight();
+    }
+
+    // 命中: 移到 T2 的 MRU 端
+    void touch(NodePtr node) {
+        unlink(node);
+        link(node, true);
+    }
+
+    // 淘汰一个常驻条目, toGhost 为 true 时它的指纹进入 B1/B2
+    void evict(NodePtr node, bool toGhost) {
+        unlink(node);
+        nodeMap_.erase(node->key_);
+        timerWheel_.deschedule(node);
+        if (evictionListener_) evictionListener_(node->key_, node->value_, node->expireAt_);
+        if (toGhost) {
+            (node->inT2_ ? b2_ : b1_).push(node->key_, node->weight_);
+        }
+        retired_.retire(node->value_);
+        nodePool_.deallocate(node);
+        stats_.evictions.add();
+    }
+
+    // 过期的节点直接释放, 不进入 ghost 列表
+    void removeExpired(NodePtr node) {
+        unlink(node);
+        nodeMap_.erase(node->key_);
+        timerWheel_.deschedule(node);
+        retired_.retire(node->value_);
+        nodePool_.deallocate(node);
+        stats_.expirations.add();
+    }
+
+    // 回收定时轮中已经到期的节点, 没有设置过 TTL 的节点时不读时钟
+    void expireEntries() {
+        if (timerWheel_.empty()) return;
+        now_ = cacheNowNanos();
+        timerWheel_.advance(now_, [this](TimerEntry* entry) {
+            removeExpired(static_cast<NodePtr>(entry));
+        });
+    }
+
+    // 插入到 T1 或 T2 的 MRU 端(虚拟头节点之后)
+    void link(NodePtr node, bool toT2) {
+        NodeType& head = toT2 ? t2_ : t1_;
+        node->inT2_ = toT2;
+        node->next_ = head.next_;
+        node->prev_ = &head;
+        head.next_->prev_ = node;
+        head.next_ = node;
+        if (toT2) {
+            t2Weight_ += node->weight_;
+        }
+        else {
+            t1Weight_ += node->weight_;
+            t1Count_++;
+        }
+    }
+
+    void unlink(NodePtr node) {
+        node->prev_->next_ = node->next_;
+        node->next_->prev_ = node->prev_;
+        if (node->inT2_) {
+            t2Weight_ -= node->weight_;
+        }
+        else {
+            t1Weight_ -= node->weight_;
+            t1Count_--;
+        }
+    }
+
+    void reweigh(NodePtr node) {
+        size_t weight = weigh(node);
+        size_t& listWeight = node->inT2_ ? t2Weight_ : t1Weight_;
+        listWeight = listWeight - node->weight_ + weight;
+        node->weight_ = weight;
+    }
+
+    size_t weigh(NodePtr node) const {
+        return weigher_ ? std::max<size_t>(1, weigher_(node->key_, node->value_)) : 1;
+    }
+
+    void clearLocked() {
+        for (NodeType* head: {&t1_, &t2_}) {
+            NodePtr node = head->next_;
+            while (node != head) {
+                NodePtr next = node->next_;
+                retired_.retire(node->value_);
+                nodePool_.deallocate(node);
+                node = next;
+            }
+            head->prev_ = head->next_ = head;
+        }
+        nodeMap_.clear();
+        timerWheel_.clear();
+        b1_.clear();
+        b2_.clear();
+        t1Weight_ = t2Weight_ = 0;
+        t1Count_ = 0;
+        p_ = 0;
+    }
+
+private:
+    size_t capacity_;               // c: T1 + T2 的总容量(设置权重函数时为总权重预算)
+    size_t p_ = 0;                  // T1 的目标大小, 0 <= p <= c
+    Weigher weigher_;               // 权重函数, 为空时每个条目权重为 1
+    NodePool<NodeType> nodePool_;   // 常驻节点内存池
+    NodeMap nodeMap_;               // key -> T1/T2 中的节点
+    NodeType t1_;                   // T1 的虚拟头节点, 头部是 MRU
+    NodeType t2_;                   // T2 的虚拟头节点
+    size_t t1Weight_ = 0;
+    size_t t2Weight_ = 0;
+    size_t t1Count_ = 0;            // T1 的条目数, T2 的条目数由索引大小减去它得到
+    ArcGhostList<Key, Hash> b1_;    // 从 T1 淘汰的 key 的指纹
+    ArcGhostList<Key, Hash> b2_;    // 从 T2 淘汰的 key 的指纹
+    uint64_t now_ = 0;              // 最近一次读取的时间, 只在有节点设置了 TTL 时更新
+    TimerWheel timerWheel_;         // 设置了 TTL 的节点
+    RetireList<Value> retired_;     // 延迟释放的旧值
+    CacheEvictionListener<Key, Value> evictionListener_;   // 容量淘汰时的回调, 可以为空
+    Mutex mutex_;
+    CacheStats stats_;              // 统计计数器(锁内更新)
+};
+
+
+// 对缓存空间切片, 每个分片是一个独立的标准 ARC, 各自维护 p
+template<typename Key, typename Value, typename Hash = CacheHash<Key>, typename Mutex = std::mutex>
+class HashExactArcCache : public ShardedCacheStrategy<ExactArcCache<Key, Value, Mutex, Hash>, 0, Hash> {
+public:
+    // 设置 weigher 后 capacity 为总权重预算, 平均分给各分片
+    HashExactArcCache(size_t capacity, int sliceNum, CacheWeigher<Key, Value> weigher = nullptr)
+        : ShardedCacheStrategy<ExactArcCache<Key, Value, Mutex, Hash>, 0, Hash>(capacity, sliceNum, weigher)
+    {}
+};
+
+} // namespace Cache
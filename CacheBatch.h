@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Cache {
+
+/**
+ * 批量接口(getMany/putMany)的公共部分
+ * 1. forEachBatched(): 单个缓存内的批量循环, 每 kBatchChunk 个 key 一组分三轮流水处理(group prefetching):
+ *    第一轮算好整组的哈希值并预取索引中对应的控制字节组, 第二轮按指纹找到候选节点并预取节点,
+ *    第三轮才真正查找和处理; 一组内的访存同时在途, 大缓存下由逐个等待内存延迟变为受内存带宽限制
+ * 2. ShardBatch: 分片缓存把一批 key 按分片分组, 每个分片只加一次锁
+*/
+constexpr size_t kBatchChunk = 16;
+
+// 批量操作中第 pos 个待处理元素的下标, indices 为空表示 0..count-1
+inline size_t batchIndexAt(const size_t* indices, size_t pos) {
+    return indices == nullptr ? pos : indices[pos];
+}
+
+/**
+ * 对 keys 中由 indices/count 指定的元素依次调用 func(下标, 哈希值)
+ * index 需要提供 hash(key)、prefetch(hash) 和 prefetchNode(hash), 调用方负责加锁
+*/
+template<typename Index, typename Key, typename Func>
+void forEachBatched(const Index& index, const std::vector<Key>& keys, const size_t* indices, size_t count, Func&& func) {
+    size_t hashes[kBatchChunk];
+    for (size_t begin = 0; begin < count; begin += kBatchChunk) {
+        size_t n = std::min(kBatchChunk, count - begin);
+        for (size_t j = 0; j < n; j++) {
+            hashes[j] = index.hash(keys[batchIndexAt(indices, begin + j)]);
+            index.prefetch(hashes[j]);
+        }
+        for (size_t j = 0; j < n; j++) {
+            index.prefetchNode(hashes[j]);
+        }
+        for (size_t j = 0; j < n; j++) {
+            func(batchIndexAt(indices, begin + j), hashes[j]);
+        }
+    }
+}
+
+/**
+ * 按分片对一批 key 分组(计数排序)
+ * 分组后分片 s 的 key 下标连续存放在 indices(s) 开始的 size(s) 个位置, 保持原有的相对顺序
+*/
+class ShardBatch {
+public:
+    template<typename Key, typename ShardOf>
+    ShardBatch(const std::vector<Key>& keys, size_t count, size_t shardCount, ShardOf&& shardOf)
+        : order_(count)
+        , offsets_(shardCount + 1, 0)
+    {
+        std::vector<uint32_t> shards(count);
+        for (size_t i = 0; i < count; i++) {
+            shards[i] = static_cast<uint32_t>(shardOf(keys[i]));
+            offsets_[shards[i] + 1]++;
+        }
+        for (size_t s = 0; s < shardCount; s++) {
+            offsets_[s + 1] += offsets_[s];
+        }
+        std::vector<size_t> cursor(offsets_.begin(), offsets_.end() - 1);
+        for (size_t i = 0; i < count; i++) {
+            order_[cursor[shards[i]]++] = i;
+        }
+    }
+
+    const size_t* indices(size_t shard) const {
+        return order_.data() + offsets_[shard];
+    }
+
+    size_t size(size_t shard) const {
+        return offsets_[shard + 1] - offsets_[shard];
+    }
+
+private:
+    std::vector<size_t> order_;     // 按分片排好的 key 下标
+    std::vector<size_t> offsets_;   // 分片 s 的下标位于 order_[offsets_[s], offsets_[s + 1])
+};
+
+} // namespace Cache
@@ -0,0 +1,409 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "CacheHash.h"
+#include "CacheNuma.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CACHE_FLAT_INDEX_SSE2 1
+#endif
+
+namespace Cache {
+
+/**
+ * 开放寻址的扁平哈希索引 (Swiss table 风格), 替代 std::unordered_map<Key, NodePtr>
+ * 1. 控制字节数组: 每个槽位 1 字节, 存放 key 哈希值低 7 位指纹 (或 空/已删除 标记)
+ *    16 个控制字节组成一组, 查找时用 SSE2 一次比较整组指纹, 不支持 SSE2 时逐字节比较
+ * 2. 槽位数组只存节点指针, key 只保存在节点里(通过 node->getKey() 比较), 不再重复存一份
+ * 3. 按组做三角探测, 组数为 2 的幂, 保证探测序列能遍历所有组
+ * 4. 负载因子上限 7/8, 超过后扩容; 删除标记过多时原地重建
+ * 节点类型需要提供 getKey() 方法
+*/
+template<typename Key, typename Node, typename Hash = CacheHash<Key>>
+class FlatNodeIndex {
+public:
+    using NodePtr = Node*;
+
+    explicit FlatNodeIndex(size_t expectedSize = 0)
+        : groupMask_(0)
+        , groupCount_(0)
+        , size_(0)
+        , deleted_(0)
+    {
+        if (expectedSize > 0) {
+            reserve(expectedSize);
+        }
+    }
+
+    FlatNodeIndex(const FlatNodeIndex&) = delete;
+    FlatNodeIndex& operator=(const FlatNodeIndex&) = delete;
+
+    // 查找 key 对应的节点, 不存在返回 nullptr
+    NodePtr find(const Key& key) const {
+        size_t slot = findSlot(key, hashOf(key));
+        return slot == kNotFound ? nullptr : slots_[slot];
+    }
+
+    // 使用预先算好的哈希值查找(hash 必须来自 hash(key)), 批量查找时把哈希计算和探测分开
+    NodePtr find(const Key& key, size_t hash) const {
+        size_t slot = findSlot(key, hash);
+        return slot == kNotFound ? nullptr : slots_[slot];
+    }
+
+    size_t hash(const Key& key) const {
+        return hashOf(key);
+    }
+
+    // 预取 hash 对应的第一组控制字节和槽位, 只是提示, 不影响结果
+    void prefetch(size_t hash) const {
+        if (groupCount_ == 0) return;
+        size_t offset = groupOf(hash) * kGroupWidth;
+        __builtin_prefetch(ctrl_.get() + offset);
+        __builtin_prefetch(slots_.get() + offset);
+    }
+
+    /**
+     * 预取 hash 在第一组中指纹匹配的节点, 调用前应该已经 prefetch(hash) 并且隔了足够长的时间让控制字节到达缓存
+     * 只看第一组: 负载因子 7/8 下绝大多数 key 都在第一组, 落到后面的组只是少预取一次
+    */
+    void prefetchNode(size_t hash) const {
+        if (groupCount_ == 0) return;
+        size_t base = groupOf(hash) * kGroupWidth;
+        for (uint32_t mask = matchByte(ctrl_.get() + base, fingerprint(hash)); mask != 0; mask &= mask - 1) {
+            const char* node = reinterpret_cast<const char*>(slots_[base + lowestBit(mask)]);
+            __builtin_prefetch(node);
+            if (sizeof(Node) > kCacheLine) __builtin_prefetch(node + kCacheLine);
+        }
+    }
+
+    // 插入 key -> node, key 已存在时覆盖节点指针, 新插入返回 true
+    bool insert(const Key& key, NodePtr node) {
+        size_t hash = hashOf(key);
+        size_t slot = findSlot(key, hash);
+        if (slot != kNotFound) {
+            slots_[slot] = node;
+            return false;
+        }
+
+        if (groupCount_ == 0 || size_ + deleted_ + 1 > maxLoad()) {
+            rehashForInsert();
+        }
+        slot = findInsertSlot(hash);
+        if (ctrl_[slot] == kDeleted) deleted_--;
+        ctrl_[slot] = fingerprint(hash);
+        slots_[slot] = node;
+        size_++;
+        return true;
+    }
+
+    // 删除 key, 存在并删除返回 true
+    bool erase(const Key& key) {
+        if (groupCount_ == 0) return false;
+        size_t slot = findSlot(key, hashOf(key));
+        if (slot == kNotFound) return false;
+
+        // 所在组里还有空槽时, 没有任何探测会越过这一组, 直接置空即可; 否则只能打删除标记
+        const int8_t* ctrl = ctrl_.get() + (slot / kGroupWidth) * kGroupWidth;
+        if (matchByte(ctrl, kEmpty) != 0) {
+            ctrl_[slot] = kEmpty;
+        }
+        else {
+            ctrl_[slot] = kDeleted;
+            deleted_++;
+        }
+        slots_[slot] = nullptr;
+        size_--;
+        return true;
+    }
+
+    // 预留至少能放下 n 个元素的空间
+    void reserve(size_t n) {
+        size_t groups = 1;
+        while (groups * kGroupWidth * 7 / 8 < n) {
+            groups <<= 1;
+        }
+        if (groups > groupCount_) {
+            rehash(groups);
+        }
+    }
+
+    // 之后的数组分配在 NUMA 节点 node 上, 并把现有的数组按原大小重建到该节点; node < 0 时只影响之后的重建
+    void setNumaNode(int node) {
+        numaNode_ = node;
+        if (node >= 0 && groupCount_ > 0) rehash(groupCount_);
+    }
+
+    void clear() {
+        if (groupCount_ == 0) return;
+        std::memset(ctrl_.get(), kEmpty, groupCount_ * kGroupWidth);
+        std::fill(slots_.get(), slots_.get() + groupCount_ * kGroupWidth, nullptr);
+        size_ = 0;
+        deleted_ = 0;
+    }
+
+    // 遍历所有节点, func 的参数为 NodePtr
+    template<typename Func>
+    void forEach(Func&& func) const {
+        size_t total = groupCount_ * kGroupWidth;
+        for (size_t i = 0; i < total; i++) {
+            if (ctrl_[i] >= 0) func(slots_[i]);
+        }
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+private:
+    static constexpr size_t kGroupWidth = 16;
+    static constexpr size_t kCacheLine = 64;
+    static constexpr size_t kNotFound = static_cast<size_t>(-1);
+    static constexpr int8_t kEmpty = static_cast<int8_t>(0x80);     // -128, 空槽
+    static constexpr int8_t kDeleted = static_cast<int8_t>(0xFE);   // -2, 删除标记
+
+    // 指纹取哈希值的低 7 位, 组号取其上的位; 分片缓存用的是高 32 位(见 cacheShardOf)
+    size_t hashOf(const Key& key) const {
+        return static_cast<size_t>(cacheHashOf(hasher_, key));
+    }
+
+    static int8_t fingerprint(size_t hash) {
+        return static_cast<int8_t>(hash & 0x7F);
+    }
+
+    size_t groupOf(size_t hash) const {
+        return (hash >> 7) & groupMask_;
+    }
+
+    size_t maxLoad() const {
+        return groupCount_ * kGroupWidth * 7 / 8;
+    }
+
+    // 返回组内控制字节等于 value 的位图
+    static uint32_t matchByte(const int8_t* ctrl, int8_t value) {
+#ifdef CACHE_FLAT_INDEX_SSE2
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; i++) {
+            if (ctrl[i] == value) mask |= 1u << i;
+        }
+        return mask;
+#endif
+    }
+
+    // 返回组内 空槽/删除标记 的位图 (两者最高位都是 1)
+    static uint32_t matchEmptyOrDeleted(const int8_t* ctrl) {
+#ifdef CACHE_FLAT_INDEX_SSE2
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        return static_cast<uint32_t>(_mm_movemask_epi8(group));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; i++) {
+            if (ctrl[i] < 0) mask |= 1u << i;
+        }
+        return mask;
+#endif
+    }
+
+    static size_t lowestBit(uint32_t mask) {
+        return static_cast<size_t>(__builtin_ctz(mask));
+    }
+
+    size_t findSlot(const Key& key, size_t hash) const {
+        if (groupCount_ == 0) return kNotFound;
+        int8_t h2 = fingerprint(hash);
+        size_t group = groupOf(hash);
+        for (size_t step = 1; ; step++) {
+            const int8_t* ctrl = ctrl_.get() + group * kGroupWidth;
+            for (uint32_t mask = matchByte(ctrl, h2); mask != 0; mask &= mask - 1) {
+                size_t slot = group * kGroupWidth + lowestBit(mask);
+                if (slots_[slot]->getKey() == key) return slot;
+            }
+            // 组内还有空槽说明 key 从未被放到更远的组, 可以直接结束探测
+            if (matchByte(ctrl, kEmpty) != 0) return kNotFound;
+            group = (group + step) & groupMask_;
+        }
+    }
+
+    // 找到哈希值对应探测序列上的第一个 空槽/删除标记(调用前保证表未满)
+    size_t findInsertSlot(size_t hash) const {
+        size_t group = groupOf(hash);
+        for (size_t step = 1; ; step++) {
+            uint32_t mask = matchEmptyOrDeleted(ctrl_.get() + group * kGroupWidth);
+            if (mask != 0) return group * kGroupWidth + lowestBit(mask);
+            group = (group + step) & groupMask_;
+        }
+    }
+
+    void rehashForInsert() {
+        if (groupCount_ == 0) {
+            rehash(1);
+        }
+        else if (size_ + 1 <= maxLoad() / 2) {
+            // 大部分是删除标记, 原地重建即可
+            rehash(groupCount_);
+        }
+        else {
+            rehash(groupCount_ * 2);
+        }
+    }
+
+    void rehash(size_t newGroupCount) {
+        NumaArray<int8_t> oldCtrl = std::move(ctrl_);
+        NumaArray<NodePtr> oldSlots = std::move(slots_);
+        size_t oldTotal = groupCount_ * kGroupWidth;
+
+        groupCount_ = newGroupCount;
+        groupMask_ = newGroupCount - 1;
+        size_t total = groupCount_ * kGroupWidth;
+        ctrl_ = NumaArray<int8_t>(total, numaNode_);
+        slots_ = NumaArray<NodePtr>(total, numaNode_);
+        std::memset(ctrl_.get(), kEmpty, total);
+        std::fill(slots_.get(), slots_.get() + total, nullptr);
+        deleted_ = 0;
+
+        for (size_t i = 0; i < oldTotal; i++) {
+            if (oldCtrl[i] < 0) continue;
+            NodePtr node = oldSlots[i];
+            size_t hash = hashOf(node->getKey());
+            size_t slot = findInsertSlot(hash);
+            ctrl_[slot] = fingerprint(hash);
+            slots_[slot] = node;
+        }
+    }
+
+private:
+    NumaArray<int8_t> ctrl_;            // 控制字节
+    NumaArray<NodePtr> slots_;          // 节点指针
+    size_t groupMask_;                  // 组数 - 1
+    size_t groupCount_;                 // 组数
+    size_t size_;                       // 元素个数
+    size_t deleted_;                    // 删除标记个数
+    Hash hasher_;
+    int numaNode_ = -1;                 // 数组所在的 NUMA 节点, -1 表示不指定
+};
+
+/**
+ * 64 位指纹 -> 64 位值的开放寻址表, 不保存 key 本身, 每个条目 16 字节
+ * 线性探测, 删除时把后面同一探测链上的条目前移, 不留删除标记; 负载因子上限 3/4
+ * 指纹 0 保留给空槽, 真实指纹为 0 时按 1 存; 指纹相同的两个 key 会共用一个条目, 由调用方决定如何处理
+ * 用于只需要记住"见过哪些 key"的场合, 例如 ghost 列表和第二层存储的索引
+*/
+class FingerprintIndex {
+public:
+    bool find(uint64_t fingerprint, uint64_t& value) const {
+        if (slots_.empty()) return false;
+        fingerprint = tagOf(fingerprint);
+        for (size_t i = fingerprint & mask_; slots_[i].fingerprint != 0; i = (i + 1) & mask_) {
+            if (slots_[i].fingerprint == fingerprint) {
+                value = slots_[i].value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool contains(uint64_t fingerprint) const {
+        uint64_t value = 0;
+        return find(fingerprint, value);
+    }
+
+    // 插入或覆盖, 新插入返回 true
+    bool insert(uint64_t fingerprint, uint64_t value) {
+        if ((size_ + 1) * 4 > slots_.size() * 3) rehash(slots_.empty() ? kMinSlots : slots_.size() * 2);
+        fingerprint = tagOf(fingerprint);
+        size_t i = fingerprint & mask_;
+        for (; slots_[i].fingerprint != 0; i = (i + 1) & mask_) {
+            if (slots_[i].fingerprint == fingerprint) {
+                slots_[i].value = value;
+                return false;
+            }
+        }
+        slots_[i] = Slot{fingerprint, value};
+        size_++;
+        return true;
+    }
+
+    // 删除成功返回 true
+    bool erase(uint64_t fingerprint) {
+        if (slots_.empty()) return false;
+        fingerprint = tagOf(fingerprint);
+        size_t i = fingerprint & mask_;
+        for (; slots_[i].fingerprint != fingerprint; i = (i + 1) & mask_) {
+            if (slots_[i].fingerprint == 0) return false;
+        }
+        for (size_t j = (i + 1) & mask_; slots_[j].fingerprint != 0; j = (j + 1) & mask_) {
+            size_t home = slots_[j].fingerprint & mask_;
+            if (((j - home) & mask_) >= ((j - i) & mask_)) {
+                slots_[i] = slots_[j];
+                i = j;
+            }
+        }
+        slots_[i] = Slot();
+        size_--;
+        return true;
+    }
+
+    // 预留至少能容纳 count 个条目而不扩容的空间
+    void reserve(size_t count) {
+        size_t slots = kMinSlots;
+        while (slots * 3 < count * 4) slots *= 2;
+        if (slots > slots_.size()) rehash(slots);
+    }
+
+    void clear() {
+        std::fill(slots_.begin(), slots_.end(), Slot());
+        size_ = 0;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+private:
+    static constexpr size_t kMinSlots = 16;
+
+    struct Slot {
+        uint64_t fingerprint = 0;
+        uint64_t value = 0;
+    };
+
+    static uint64_t tagOf(uint64_t fingerprint) {
+        return fingerprint == 0 ? 1 : fingerprint;
+    }
+
+    void rehash(size_t slotCount) {
+        std::vector<Slot> old;
+        old.swap(slots_);
+        slots_.assign(slotCount, Slot());
+        mask_ = slotCount - 1;
+        size_ = 0;
+        for (const Slot& slot: old) {
+            if (slot.fingerprint != 0) insert(slot.fingerprint, slot.value);
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace Cache
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace Cache {
+
+/**
+ * 缓存内部使用的哈希函数
+ * 1. 标准库对整数的 std::hash 是恒等映射, 连续的 id 在分片和索引里都会呈条带分布,
+ *    CacheHash 对整数做一次 64 位混合, 对字符串用 wyhash, 其余类型在 std::hash 的结果上再混合
+ * 2. 输出的每一位都均匀依赖输入(avalanche), 所以分片和索引可以使用同一个哈希值的不同位:
+ *    分片取高 32 位(cacheShardOf), 索引取低位(指纹和组号), 两者互不相关
+ * 3. 自定义的哈希类型定义 is_avalanching 即表示输出已经充分混合, 缓存不再额外混合;
+ *    没有定义的(例如 std::hash)由 cacheHashOf() 补一次混合
+ * 4. 各缓存策略和 Hash* 分片缓存的 Hash 模板参数同时用于分片选择、分片内索引、ghost 指纹和合并加载,
+ *    自定义 key 类型只需要提供 Hash 和 operator==, 不需要特化 std::hash
+*/
+
+// 64 位整数混合 (murmur3 的 fmix64): 乘法把低位扩散到高位, 移位异或再把高位扩散回低位
+inline uint64_t cacheMix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+namespace detail {
+
+// 64x64 -> 128 位乘法, 结果的低/高 64 位分别写回 a/b
+inline void wyMultiply(uint64_t& a, uint64_t& b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    a = static_cast<uint64_t>(r);
+    b = static_cast<uint64_t>(r >> 64);
+#else
+    uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t carry = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    carry += lo < t;
+    a = lo;
+    b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+inline uint64_t wyMix(uint64_t a, uint64_t b) {
+    wyMultiply(a, b);
+    return a ^ b;
+}
+
+inline uint64_t wyRead8(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint64_t wyRead4(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+// 1~3 字节: 取首、中、尾三个字节
+inline uint64_t wyRead3(const uint8_t* p, size_t len) {
+    return (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[len >> 1]) << 8) | p[len - 1];
+}
+
+} // namespace detail
+
+/**
+ * 字节串哈希 (wyhash final4, 公有领域算法)
+ * 每 16/48 字节做一次 128 位乘法混合, 短字符串(<=16 字节)只需两次乘法, 比 libstdc++ 的 murmur2 快且分布更好
+*/
+inline uint64_t cacheHashBytes(const void* data, size_t len, uint64_t seed = 0) {
+    static constexpr uint64_t kSecret[4] = {
+        0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+    };
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    seed ^= detail::wyMix(seed ^ kSecret[0], kSecret[1]);
+    uint64_t a, b;
+    if (len <= 16) {
+        if (len >= 4) {
+            size_t mid = (len >> 3) << 2;
+            a = (detail::wyRead4(p) << 32) | detail::wyRead4(p + mid);
+            b = (detail::wyRead4(p + len - 4) << 32) | detail::wyRead4(p + len - 4 - mid);
+        }
+        else if (len > 0) {
+            a = detail::wyRead3(p, len);
+            b = 0;
+        }
+        else {
+            a = b = 0;
+        }
+    }
+    else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed = detail::wyMix(detail::wyRead8(p) ^ kSecret[1], detail::wyRead8(p + 8) ^ seed);
+                seed1 = detail::wyMix(detail::wyRead8(p + 16) ^ kSecret[2], detail::wyRead8(p + 24) ^ seed1);
+                seed2 = detail::wyMix(detail::wyRead8(p + 32) ^ kSecret[3], detail::wyRead8(p + 40) ^ seed2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (i > 16) {
+            seed = detail::wyMix(detail::wyRead8(p) ^ kSecret[1], detail::wyRead8(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = detail::wyRead8(p + i - 16);
+        b = detail::wyRead8(p + i - 8);
+    }
+    a ^= kSecret[1];
+    b ^= seed;
+    detail::wyMultiply(a, b);
+    return detail::wyMix(a ^ kSecret[0] ^ len, b ^ kSecret[1]);
+}
+
+// 默认哈希: 在 std::hash 的结果上再混合一次
+template<typename Key, typename = void>
+struct CacheHash {
+    using is_avalanching = void;
+
+    size_t operator()(const Key& key) const {
+        return static_cast<size_t>(cacheMix64(static_cast<uint64_t>(std::hash<Key>()(key))));
+    }
+};
+
+// 整数和枚举: 直接混合数值本身
+template<typename Key>
+struct CacheHash<Key, std::enable_if_t<std::is_integral<Key>::value || std::is_enum<Key>::value>> {
+    using is_avalanching = void;
+
+    size_t operator()(Key key) const {
+        return static_cast<size_t>(cacheMix64(static_cast<uint64_t>(key)));
+    }
+};
+
+template<>
+struct CacheHash<std::string_view> {
+    using is_avalanching = void;
+
+    size_t operator()(std::string_view key) const {
+        return static_cast<size_t>(cacheHashBytes(key.data(), key.size()));
+    }
+};
+
+template<>
+struct CacheHash<std::string> {
+    using is_avalanching = void;
+
+    size_t operator()(const std::string& key) const {
+        return static_cast<size_t>(cacheHashBytes(key.data(), key.size()));
+    }
+};
+
+// CacheHash<Key> 是否可用: 整数/枚举、字符串, 或者有 std::hash<Key>(没有特化的 std::hash 不能默认构造)
+template<typename Key>
+struct HasCacheHash : std::integral_constant<bool, std::is_integral<Key>::value || std::is_enum<Key>::value ||
+                                                   std::is_default_constructible<std::hash<Key>>::value> {};
+
+// 哈希类型是否声明了 is_avalanching(输出已经充分混合)
+template<typename Hash, typename = void>
+struct IsAvalanchingHash : std::false_type {};
+
+template<typename Hash>
+struct IsAvalanchingHash<Hash, std::void_t<typename Hash::is_avalanching>> : std::true_type {};
+
+// 用 hasher 计算 key 的哈希值, hasher 没有充分混合时补一次混合
+template<typename Hash, typename Key>
+inline uint64_t cacheHashOf(const Hash& hasher, const Key& key) {
+    uint64_t hash = static_cast<uint64_t>(hasher(key));
+    if constexpr (IsAvalanchingHash<Hash>::value) {
+        return hash;
+    }
+    else {
+        return cacheMix64(hash);
+    }
+}
+
+/**
+ * 由哈希值的高 32 位选出 [0, shardCount) 中的分片 (Lemire 的乘法取高位, 代替取模)
+ * 分片数是编译期常量且为 2 的幂时编译器会把它折叠成一次移位
+*/
+inline size_t cacheShardOf(uint64_t hash, size_t shardCount) {
+    return static_cast<size_t>(((hash >> 32) * static_cast<uint64_t>(shardCount)) >> 32);
+}
+
+} // namespace Cache
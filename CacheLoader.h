@@ -0,0 +1,317 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "CacheHash.h"
+
+namespace Cache {
+
+/**
+ * 未命中时的合并加载 (single-flight)
+ * 1. 同一个 key 同时只有一次加载在进行: 第一个未命中的线程(leader)调用加载函数,
+ *    之后到达的线程拿到同一个 shared_future 等待结果, 不会各自去访问后端
+ * 2. 加载结束(成功、没有数据或者抛出异常)后登记立即撤销, 之后的未命中会重新加载;
+ *    leader 在撤销登记之前已经把结果写入缓存, 所以撤销之后到达的线程可以直接命中;
+ *    只有在撤销之前未命中、撤销之后才登记的线程会再加载一次, 这个窗口很小, 不影响正确性
+ * 3. 登记表按 key 的哈希分条带, 每个条带一把锁, 锁只在登记/撤销时持有, 加载函数在锁外执行;
+ *    哈希函数由所属缓存传入, 与它的 Hash 模板参数一致
+ * 4. 异步加载的结果由一个完成线程等待, 就绪后写入缓存并撤销登记, 与调用方是否等待返回的 future 无关;
+ *    start() 返回时已经就绪(或者是 deferred)的加载直接在 leader 线程完成; 完成线程只有一个, 轮询所有未就绪的加载
+ * 5. 写回要访问缓存本身, 缓存必须在析构函数开头调用 cancelLoads(), 之后的结果不再写回
+ * 结果为 std::nullopt 表示加载函数没有找到数据, 这种结果不写入缓存
+*/
+template<typename Key, typename Value>
+class LoadCoalescer {
+public:
+    using Result = std::optional<Value>;
+    using Flight = std::shared_future<Result>;
+    // 登记表使用的哈希, 返回值应当已经充分混合(例如 cacheHashOf() 的结果)
+    using HashFunction = size_t (*)(const Key&);
+
+    explicit LoadCoalescer(HashFunction hash)
+        : hash_{hash}
+        , stripes_(new Stripe[kStripeCount])
+    {
+        for (size_t i = 0; i < kStripeCount; i++) {
+            stripes_[i].flights = FlightMap(0, hash_);
+        }
+    }
+
+    ~LoadCoalescer() {
+        cancelLoads();
+        {
+            std::lock_guard<std::mutex> lock(completionMutex_);
+            stopping_ = true;
+        }
+        completionCv_.notify_one();
+        if (completionThread_.joinable()) {
+            completionThread_.join();
+        }
+    }
+
+    LoadCoalescer(const LoadCoalescer&) = delete;
+    LoadCoalescer& operator=(const LoadCoalescer&) = delete;
+
+    /**
+     * 同步加载: key 没有正在进行的加载时在当前线程调用 load() 并返回它的结果,
+     * 否则等待正在进行的那一次; load() 抛出的异常会同时传给所有等待者
+    */
+    template<typename Load>
+    Result run(const Key& key, Load&& load) {
+        std::promise<Result> promise;
+        Flight flight;
+        if (!join(key, promise.get_future().share(), flight)) {
+            return flight.get();
+        }
+        try {
+            Result result = load();
+            finish(key);
+            promise.set_value(result);
+            return result;
+        }
+        catch (...) {
+            finish(key);
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    /**
+     * 异步加载: leader 调用 start() 发起加载, start() 返回一个 future(get() 得到 Result 或者 Value);
+     * 结果就绪后交给 onLoaded(result) 写入缓存, 撤销登记, 再让返回的 shared_future 就绪,
+     * 调用方丢弃 future 不影响写回和撤销; start() 或加载本身抛出的异常在等待 future 时抛出
+     * start() 返回时已经就绪(或者是 deferred)的加载在当前线程完成, 其余的交给完成线程
+    */
+    template<typename Start, typename OnLoaded>
+    Flight runAsync(const Key& key, Start&& start, OnLoaded&& onLoaded) {
+        auto promise = std::make_shared<std::promise<Result>>();
+        Flight flight = promise->get_future().share();
+        Flight existing;
+        if (!join(key, flight, existing)) {
+            return existing;
+        }
+        try {
+            using Pending = std::decay_t<decltype(start())>;
+            using Task = PendingLoad<Pending, std::decay_t<OnLoaded>>;
+            auto task = std::make_unique<Task>(key, promise, start(), std::forward<OnLoaded>(onLoaded));
+            if (task->ready()) {
+                complete(*task);
+            }
+            else {
+                enqueue(std::move(task));
+            }
+        }
+        catch (...) {
+            // start() 抛出异常或者入队失败
+            finish(key);
+            promise->set_exception(std::current_exception());
+        }
+        return flight;
+    }
+
+    /**
+     * 停止写回: 返回时正在进行的 onLoaded 已经结束, 之后就绪的加载只完成 future、撤销登记, 不再调用 onLoaded
+     * 缓存在析构函数开头调用, 保证完成线程不会访问已经析构的成员; 可以重复调用
+    */
+    void cancelLoads() {
+        std::lock_guard<std::mutex> lock(writeBackMutex_);
+        cancelled_ = true;
+    }
+
+    // 当前正在进行的加载数
+    size_t inflight() {
+        size_t count = 0;
+        for (size_t i = 0; i < kStripeCount; i++) {
+            std::lock_guard<std::mutex> lock(stripes_[i].mutex);
+            count += stripes_[i].flights.size();
+        }
+        return count;
+    }
+
+private:
+    static constexpr size_t kStripeCount = 16;
+
+    struct FlightHash {
+        using is_avalanching = void;
+
+        size_t operator()(const Key& key) const {
+            return function(key);
+        }
+
+        HashFunction function = nullptr;
+    };
+
+    using FlightMap = std::unordered_map<Key, Flight, FlightHash>;
+
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+        FlightMap flights;
+    };
+
+    // 等待完成的异步加载, 按 start() 返回的 future 类型擦除
+    struct PendingTask {
+        PendingTask(const Key& key, std::shared_ptr<std::promise<Result>> promise)
+            : key(key)
+            , promise(std::move(promise))
+        {}
+        virtual ~PendingTask() = default;
+        // 加载结果是否已经就绪(或者是 deferred, 可以直接 get())
+        virtual bool ready() = 0;
+        // 最多等待 timeout, 用于没有任何加载就绪时让完成线程休眠
+        virtual void waitFor(std::chrono::microseconds timeout) = 0;
+        // 取出结果, 加载抛出的异常原样抛出
+        virtual Result take() = 0;
+        virtual void writeBack(const Result& result) = 0;
+
+        Key key;
+        std::shared_ptr<std::promise<Result>> promise;
+    };
+
+    template<typename Pending, typename OnLoaded>
+    struct PendingLoad : PendingTask {
+        template<typename F>
+        PendingLoad(const Key& key, std::shared_ptr<std::promise<Result>> promise, Pending pending, F&& onLoaded)
+            : PendingTask(key, std::move(promise))
+            , pending(std::move(pending))
+            , onLoaded(std::forward<F>(onLoaded))
+        {}
+
+        bool ready() override {
+            return pending.wait_for(std::chrono::seconds(0)) != std::future_status::timeout;
+        }
+
+        void waitFor(std::chrono::microseconds timeout) override {
+            pending.wait_for(timeout);
+        }
+
+        Result take() override {
+            return Result(pending.get());
+        }
+
+        void writeBack(const Result& result) override {
+            onLoaded(result);
+        }
+
+        Pending pending;
+        OnLoaded onLoaded;
+    };
+
+    // 没有加载就绪时完成线程每次休眠的上限, 也是新就绪的加载写回的最大延迟
+    static constexpr std::chrono::microseconds kCompletionPoll{500};
+
+    // 取出结果, 写回(没有被 cancelLoads() 停止时), 撤销登记, 最后让 future 就绪
+    void complete(PendingTask& task) {
+        try {
+            Result result = task.take();
+            {
+                std::lock_guard<std::mutex> lock(writeBackMutex_);
+                if (!cancelled_) {
+                    task.writeBack(result);
+                }
+            }
+            finish(task.key);
+            task.promise->set_value(std::move(result));
+        }
+        catch (...) {
+            finish(task.key);
+            task.promise->set_exception(std::current_exception());
+        }
+    }
+
+    // 交给完成线程, 第一次使用时才创建它; 每个合并加载表只有一个完成线程, 与未就绪的加载数无关
+    void enqueue(std::unique_ptr<PendingTask> task) {
+        std::lock_guard<std::mutex> lock(completionMutex_);
+        queued_.push_back(std::move(task));
+        if (!completionThread_.joinable()) {
+            completionThread_ = std::thread([this]() { completionLoop(); });
+        }
+        completionCv_.notify_one();
+    }
+
+    /**
+     * 完成线程: 轮流检查手上的加载, 就绪的立即完成; 一个都没有就绪时在最早的那个上最多等待 kCompletionPoll
+     * 停止时还没有就绪的加载直接丢弃, 它们的 future 以 broken_promise 结束
+    */
+    void completionLoop() {
+        std::vector<std::unique_ptr<PendingTask>> tasks;
+        std::unique_lock<std::mutex> lock(completionMutex_);
+        while (true) {
+            for (std::unique_ptr<PendingTask>& task: queued_) {
+                tasks.push_back(std::move(task));
+            }
+            queued_.clear();
+            if (stopping_) break;
+            if (tasks.empty()) {
+                completionCv_.wait(lock, [this]() { return stopping_ || !queued_.empty(); });
+                continue;
+            }
+            lock.unlock();
+            bool progressed = false;
+            for (size_t i = 0; i < tasks.size();) {
+                if (tasks[i]->ready()) {
+                    complete(*tasks[i]);
+                    tasks[i] = std::move(tasks.back());
+                    tasks.pop_back();
+                    progressed = true;
+                }
+                else {
+                    i++;
+                }
+            }
+            if (!progressed && !tasks.empty()) {
+                tasks.front()->waitFor(kCompletionPoll);
+            }
+            lock.lock();
+        }
+        lock.unlock();
+        tasks.clear();
+    }
+
+    Stripe& stripeOf(const Key& key) {
+        return stripes_[cacheShardOf(hash_(key), kStripeCount)];
+    }
+
+    // 把 flight 登记为 key 的加载, 成为 leader 返回 true; 已经有加载在进行时把它写入 existing 并返回 false
+    bool join(const Key& key, const Flight& flight, Flight& existing) {
+        Stripe& stripe = stripeOf(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto it = stripe.flights.find(key);
+        if (it != stripe.flights.end()) {
+            existing = it->second;
+            return false;
+        }
+        stripe.flights.emplace(key, flight);
+        return true;
+    }
+
+    void finish(const Key& key) {
+        Stripe& stripe = stripeOf(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.flights.erase(key);
+    }
+
+private:
+    FlightHash hash_;
+    std::unique_ptr<Stripe[]> stripes_;
+    std::mutex writeBackMutex_;                 // 写回与 cancelLoads() 互斥
+    bool cancelled_ = false;                    // cancelLoads() 之后不再写回
+    std::mutex completionMutex_;                // 保护 queued_ 和 stopping_
+    std::condition_variable completionCv_;
+    std::vector<std::unique_ptr<PendingTask>> queued_;     // 新交给完成线程、还没被它取走的加载
+    bool stopping_ = false;
+    std::thread completionThread_;              // 第一次有未就绪的加载时创建
+};
+
+} // namespace Cache
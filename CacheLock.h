@@ -0,0 +1,217 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * 缓存的锁策略, 作为各缓存的 Mutex 模板参数使用
+ * · std::mutex: 默认, 拿不到锁时通过 futex 睡眠, 唤醒一次要几微秒
+ * · SpinLock: 纯自旋, 临界区只有几百纳秒并且线程数不超过核数时交接最快
+ * · SpinThenParkMutex: 先自旋一小段时间, 还拿不到再睡眠, 线程数超过核数时也不会空转
+ * · std::shared_mutex: 支持 lock_shared 的锁, 能做只读查找的策略(LruCache)在共享锁内读取;
+ *   LruCache 的读优化模式不需要它, 其他锁会自带一把读写锁(OptionalSharedMutex)
+ * · SkipPromotionOnContention<>: 读写锁, 另外让 LruCache::get() 在独占锁被占用时跳过这次提升, 改为共享锁内只读查找
+ * 任何满足 Lockable(lock/try_lock/unlock) 的类型都可以作为 Mutex; 不支持 lock_shared 时共享锁退化为独占锁
+*/
+
+namespace Cache {
+
+// 自旋等待时提示 CPU 降低功耗并让出流水线给同一物理核上的另一个超线程
+inline void cacheCpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/**
+ * test-and-test-and-set 自旋锁
+ * 等待时只读锁变量(留在本核缓存里, 不产生缓存行争抢), 看到锁被释放才尝试 exchange;
+ * 每轮等待的 pause 次数指数增长(上限 kMaxBackoff), 自旋 kYieldAfter 轮后每轮让出一次 CPU, 避免持锁线程被抢占时空转
+*/
+class SpinLock {
+public:
+    void lock() {
+        unsigned backoff = 1;
+        unsigned rounds = 0;
+        while (!try_lock()) {
+            while (locked_.load(std::memory_order_relaxed)) {
+                if (rounds++ >= kYieldAfter) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (unsigned i = 0; i < backoff; i++) {
+                    cacheCpuRelax();
+                }
+                backoff = backoff < kMaxBackoff ? backoff * 2 : kMaxBackoff;
+            }
+        }
+    }
+
+    bool try_lock() {
+        return !locked_.load(std::memory_order_relaxed) && !locked_.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() {
+        locked_.store(false, std::memory_order_release);
+    }
+
+private:
+    static constexpr unsigned kMaxBackoff = 64;
+    static constexpr unsigned kYieldAfter = 64;
+
+    std::atomic<bool> locked_{false};
+};
+
+/**
+ * 先自旋再睡眠的互斥锁 (与 glibc 的 PTHREAD_MUTEX_ADAPTIVE_NP 思路相同)
+ * 前 kSpinTries 次用 try_lock 抢锁, 两次之间 pause 的次数指数增长; 仍然失败时退回 std::mutex::lock() 睡眠
+ * 临界区很短时持锁线程几乎总能在自旋期间释放锁, 省掉 futex 的睡眠/唤醒
+*/
+class SpinThenParkMutex {
+public:
+    void lock() {
+        unsigned backoff = 1;
+        for (unsigned i = 0; i < kSpinTries; i++) {
+            if (mutex_.try_lock()) return;
+            for (unsigned j = 0; j < backoff; j++) {
+                cacheCpuRelax();
+            }
+            backoff = backoff < kMaxBackoff ? backoff * 2 : kMaxBackoff;
+        }
+        mutex_.lock();
+    }
+
+    bool try_lock() {
+        return mutex_.try_lock();
+    }
+
+    void unlock() {
+        mutex_.unlock();
+    }
+
+private:
+    static constexpr unsigned kSpinTries = 16;
+    static constexpr unsigned kMaxBackoff = 128;
+
+    std::mutex mutex_;
+};
+
+// Mutex 是否支持共享锁(lock_shared/unlock_shared)
+template<typename Mutex, typename = void>
+struct IsSharedMutex : std::false_type {};
+
+template<typename Mutex>
+struct IsSharedMutex<Mutex, std::void_t<decltype(std::declval<Mutex&>().lock_shared()),
+                                        decltype(std::declval<Mutex&>().unlock_shared())>> : std::true_type {};
+
+/**
+ * 按需共享的锁: 给不支持共享锁的 Mutex(std::mutex、SpinLock...)配一把自己的 std::shared_mutex
+ * setShared(true) 之前所有加锁(包括 lock_shared)都落在 Mutex 上, 与直接使用 Mutex 只差一次可预测的分支;
+ * 之后全部改用内部的读写锁. 只能在没有其他线程使用时(例如构造时)切换
+ * LruCache 用它让读优化模式自带读写锁, 不必为此把所有用户的锁都换成 std::shared_mutex
+*/
+template<typename Mutex>
+class OptionalSharedMutex {
+public:
+    void setShared(bool shared) {
+        shared_ = shared;
+    }
+
+    void lock() {
+        if (shared_) sharedMutex_.lock();
+        else mutex_.lock();
+    }
+
+    bool try_lock() {
+        return shared_ ? sharedMutex_.try_lock() : mutex_.try_lock();
+    }
+
+    void unlock() {
+        if (shared_) sharedMutex_.unlock();
+        else mutex_.unlock();
+    }
+
+    void lock_shared() {
+        if (shared_) sharedMutex_.lock_shared();
+        else mutex_.lock();
+    }
+
+    bool try_lock_shared() {
+        return shared_ ? sharedMutex_.try_lock_shared() : mutex_.try_lock();
+    }
+
+    void unlock_shared() {
+        if (shared_) sharedMutex_.unlock_shared();
+        else mutex_.unlock();
+    }
+
+private:
+    bool shared_ = false;
+    Mutex mutex_;
+    std::shared_mutex sharedMutex_;
+};
+
+// 保证支持共享锁的锁类型: Mutex 本身支持时就是 Mutex, 否则套一层 OptionalSharedMutex
+template<typename Mutex>
+using CacheSharedCapableMutex = std::conditional_t<IsSharedMutex<Mutex>::value, Mutex, OptionalSharedMutex<Mutex>>;
+
+/**
+ * 争用时跳过提升的锁策略
+ * LRU 的命中需要独占锁来移动节点, 热点 key 的读取因此全部串行; 使用这个锁时命中先 try_lock,
+ * 失败说明有其他线程在操作这个缓存, 就只在共享锁内查找并拷贝值, 放弃这一次移动到最近访问端
+ * 被跳过的只是顺序上的微调, 热点 key 很快会在下一次拿到锁的访问中被提升; 不争用时行为与普通互斥锁相同
+ * 默认不开启: 读写锁在持续的共享锁下可能让写线程等待更久
+*/
+template<typename SharedMutex = std::shared_mutex>
+class SkipPromotionOnContention : public SharedMutex {
+public:
+    static constexpr bool kSkipContendedPromotion = true;
+};
+
+// Mutex 是否要求在争用时跳过提升
+template<typename Mutex, typename = void>
+struct SkipsContendedPromotion : std::false_type {};
+
+template<typename Mutex>
+struct SkipsContendedPromotion<Mutex, std::enable_if_t<Mutex::kSkipContendedPromotion>> : std::true_type {};
+
+// 只读操作用的锁守卫: Mutex 支持共享锁时加共享锁, 否则加独占锁
+template<typename Mutex>
+class SharedLockGuard {
+public:
+    explicit SharedLockGuard(Mutex& mutex): mutex_(mutex) {
+        if constexpr (IsSharedMutex<Mutex>::value) {
+            mutex_.lock_shared();
+        }
+        else {
+            mutex_.lock();
+        }
+    }
+
+    ~SharedLockGuard() {
+        if constexpr (IsSharedMutex<Mutex>::value) {
+            mutex_.unlock_shared();
+        }
+        else {
+            mutex_.unlock();
+        }
+    }
+
+    SharedLockGuard(const SharedLockGuard&) = delete;
+    SharedLockGuard& operator=(const SharedLockGuard&) = delete;
+
+private:
+    Mutex& mutex_;
+};
+
+} // namespace Cache
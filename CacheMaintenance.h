@@ -0,0 +1,182 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Cache {
+
+/**
+ * 待释放的旧值列表
+ * 淘汰、过期、覆盖和删除时旧值的析构(例如释放几KB的字符串)原本发生在缓存的锁内,
+ * 开启延迟释放后, 旧值只是被移动进这个列表(移动只交换几个指针), 之后由维护线程取走并在锁外析构
+ * 本身不加锁, 由所属缓存的锁保护; 析构平凡的类型没有释放开销, 不进入列表
+*/
+template<typename Value>
+class RetireList {
+public:
+    void setEnabled(bool enabled) {
+        enabled_ = enabled;
+    }
+
+    bool enabled() const {
+        return enabled_;
+    }
+
+    // 开启时把 value 移进列表, 节点随后析构的只是移走后的空值
+    void retire(Value& value) {
+        if constexpr (!std::is_trivially_destructible<Value>::value) {
+            if (enabled_) items_.push_back(std::move(value));
+        }
+        else {
+            (void)value;
+        }
+    }
+
+    // 取出所有待释放的值, 调用方在锁外析构返回的 vector
+    std::vector<Value> take() {
+        std::vector<Value> items;
+        items.swap(items_);
+        return items;
+    }
+
+    size_t size() const {
+        return items_.size();
+    }
+
+private:
+    bool enabled_ = false;
+    std::vector<Value> items_;
+};
+
+/**
+ * 后台维护线程, 每个缓存可选地配一个
+ * 1. 构造时开启缓存的延迟释放, 之后每隔 interval 调用一次 cache.runMaintenance():
+ *    回收到期条目、排空读缓冲区, 并在锁外析构淘汰/覆盖下来的旧值, 前台 put() 只做链表和索引操作
+ * 2. 设置了提前刷新时, 每次维护后取出 window 内即将到期、并且上次写入之后被读过的 key(cache.expiringKeys()),
+ *    在维护线程中调用 loader(key, value) 重新加载, 成功的通过 cache.refresh() 以 refreshTtl 写回, 热点数据不会因为到期而集体未命中;
+ *    写回不算一次访问(不调整访问顺序和频次), 续期之后没有再被读过的条目到期后正常失效, 只想续期部分条目时让 loader 返回 false
+ * 3. 析构时停止线程, 关闭延迟释放并做最后一次维护, 缓存必须比它活得久
+ * CacheType 需要提供 setDeferredRelease/runMaintenance/expiringKeys/refresh,
+ * LruCache/LfuCache/ArcCache 以及基于它们的 ShardedCache/Hash* 分片缓存都满足
+*/
+template<typename CacheType>
+class CacheMaintainer {
+public:
+    using Key = typename CacheType::KeyType;
+    using Value = typename CacheType::ValueType;
+    using Loader = std::function<bool(const Key&, Value&)>;
+
+    explicit CacheMaintainer(CacheType& cache, std::chrono::milliseconds interval = std::chrono::milliseconds(10))
+        : cache_(cache)
+        , interval_(interval)
+    {
+        cache_.setDeferredRelease(true);
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ~CacheMaintainer() {
+        stop();
+    }
+
+    CacheMaintainer(const CacheMaintainer&) = delete;
+    CacheMaintainer& operator=(const CacheMaintainer&) = delete;
+
+    /**
+     * 提前刷新: 每次维护时重新加载 window 内即将到期并且被读过的条目, 加载成功的以 refreshTtl 写回
+     * loader 为空时关闭刷新
+    */
+    void setRefreshAhead(std::chrono::nanoseconds window, std::chrono::nanoseconds refreshTtl, Loader loader) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refreshWindow_ = window;
+        refreshTtl_ = refreshTtl;
+        loader_ = std::move(loader);
+    }
+
+    // 立即唤醒维护线程做一次维护, 例如在一次大批量写入之后
+    void wake() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wakeRequested_ = true;
+        cv_.notify_one();
+    }
+
+    // 停止维护线程, 可以重复调用
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) return;
+            stopping_ = true;
+            cv_.notify_one();
+        }
+        thread_.join();
+        cache_.setDeferredRelease(false);
+        cache_.runMaintenance();
+    }
+
+    // 已经完成的维护次数
+    size_t runs() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return runs_;
+    }
+
+    // 累计刷新成功的条目数(加载成功并且写回时条目仍在缓存中)
+    size_t refreshed() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return refreshed_;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            cv_.wait_for(lock, interval_, [this] { return stopping_ || wakeRequested_; });
+            if (stopping_) break;
+            wakeRequested_ = false;
+            Loader loader = loader_;
+            std::chrono::nanoseconds window = refreshWindow_;
+            std::chrono::nanoseconds ttl = refreshTtl_;
+            lock.unlock();
+
+            cache_.runMaintenance();
+            size_t refreshed = loader ? refresh(loader, window, ttl) : 0;
+
+            lock.lock();
+            runs_++;
+            refreshed_ += refreshed;
+        }
+    }
+
+    size_t refresh(const Loader& loader, std::chrono::nanoseconds window, std::chrono::nanoseconds ttl) {
+        size_t refreshed = 0;
+        for (const Key& key: cache_.expiringKeys(window)) {
+            Value value{};
+            // 加载期间条目可能已经被淘汰或删除, 写回时不重新插入
+            if (loader(key, value) && cache_.refresh(key, std::move(value), ttl)) {
+                refreshed++;
+            }
+        }
+        return refreshed;
+    }
+
+private:
+    CacheType& cache_;
+    std::chrono::milliseconds interval_;    // 两次维护之间的间隔
+    std::mutex mutex_;                      // 保护下面的状态, 维护本身在锁外进行
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    bool wakeRequested_ = false;
+    Loader loader_;                         // 提前刷新的加载函数, 为空时不刷新
+    std::chrono::nanoseconds refreshWindow_{0};
+    std::chrono::nanoseconds refreshTtl_{0};
+    size_t runs_ = 0;
+    size_t refreshed_ = 0;
+    std::thread thread_;
+};
+
+} // namespace Cache
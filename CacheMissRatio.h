@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "CacheStrategy.h"
+#include "CacheHash.h"
+#include "CacheStats.h"
+#include "LruCache.h"
+
+/**
+ * 在线估计命中率曲线(miss ratio curve, MRC): 按 key 的哈希抽样, 喂给多个按比例缩小的影子缓存
+ * (Waldspurger 等人 "Efficient MRC Construction with SHARDS" 中的空间抽样, 以及
+ *  "Cache Modeling and Optimization using Miniature Simulations" 中的缩小模拟)
+ * 1. 抽样按 key 而不是按请求: 哈希值落在 [0, 采样率 * 2^24) 内的 key 的所有访问都被记录, 其余 key 的访问完全忽略,
+ *    被抽中的 key 的访问序列保持原有的复用关系, 容量为 C 的缓存的行为可以用容量为 C * 采样率 的影子缓存模拟
+ * 2. 每个待评估的容量一个影子缓存, 影子缓存的 value 只有一个字节; 影子缓存可以是任意策略(LRU/LFU/ARC...),
+ *    因此同一份抽样可以回答"换成另一种策略、给多少容量会怎样"
+ * 3. 没被抽中的访问只多一次哈希和比较; 采样率 1% 时影子缓存总共只占全部容量之和的 1%
+ * 缩小后的容量太小(几十个条目以下)时误差明显变大, 采样率应保证最小的容量 * 采样率 至少在一百左右; 本身线程安全
+*/
+
+namespace Cache {
+
+// 曲线上的一个点: 容量为 capacity 时估计的命中率
+struct MissRatioPoint {
+    size_t capacity = 0;            // 被评估的容量
+    size_t shadowCapacity = 0;      // 对应的影子缓存容量
+    uint64_t accesses = 0;          // 记录到的(被抽中的)访问次数
+    uint64_t misses = 0;            // 影子缓存的未命中次数
+
+    double missRatio() const {
+        return accesses == 0 ? 0.0 : static_cast<double>(misses) / accesses;
+    }
+
+    double hitRatio() const {
+        return accesses == 0 ? 0.0 : 1.0 - missRatio();
+    }
+};
+
+template<typename Key, typename Hash = CacheHash<Key>>
+class CacheMissRatioCurve {
+public:
+    using ShadowCache = CacheStrategy<Key, uint8_t>;
+    // 按缩小后的容量创建一个影子缓存
+    using ShadowFactory = std::function<std::unique_ptr<ShadowCache>(size_t)>;
+
+    /**
+     * capacities 为要评估的容量(或总权重预算之外的条目数), sampleRate 为 (0, 1] 内的采样率
+     * shadowFactory 为空时影子缓存使用 LruCache
+    */
+    CacheMissRatioCurve(std::vector<size_t> capacities, double sampleRate = 0.01, ShadowFactory shadowFactory = nullptr)
+        : threshold_(static_cast<uint64_t>(std::ceil(std::min(std::max(sampleRate, 0.0), 1.0) * kSampleModulus)))
+    {
+        if (!shadowFactory) {
+            shadowFactory = [](size_t capacity) { return std::make_unique<LruCache<Key, uint8_t, std::mutex, Hash>>(capacity); };
+        }
+        std::sort(capacities.begin(), capacities.end());
+        capacities.erase(std::unique(capacities.begin(), capacities.end()), capacities.end());
+        shadows_.reserve(capacities.size());
+        for (size_t capacity: capacities) {
+            size_t shadowCapacity = std::max<size_t>(1, static_cast<size_t>(std::llround(capacity * this->sampleRate())));
+            shadows_.push_back(std::make_unique<Shadow>(capacity, shadowCapacity, shadowFactory(shadowCapacity)));
+        }
+    }
+
+    // 实际使用的采样率(按 2^-24 取整)
+    double sampleRate() const {
+        return static_cast<double>(threshold_) / kSampleModulus;
+    }
+
+    bool sampled(const Key& key) const {
+        // 换一个种子重新混合, 与分片(高 32 位)和索引(低位)用到的哈希位不相关
+        return (cacheMix64(cacheHashOf(hasher_, key) ^ kSampleSeed) & (kSampleModulus - 1)) < threshold_;
+    }
+
+    // 记录一次对 key 的查找, key 被抽中时返回 true; 影子缓存未命中时把 key 放进去, 相当于回填
+    bool record(const Key& key) {
+        if (!sampled(key)) return false;
+        for (const std::unique_ptr<Shadow>& shadow: shadows_) {
+            uint8_t value = 0;
+            shadow->accesses.addShared();
+            if (!shadow->cache->get(key, value)) {
+                shadow->misses.addShared();
+                shadow->cache->put(key, value);
+            }
+        }
+        return true;
+    }
+
+    // 删除 key 时同步从影子缓存中删除, 之后的访问按未命中计
+    void remove(const Key& key) {
+        if (!sampled(key)) return;
+        for (const std::unique_ptr<Shadow>& shadow: shadows_) {
+            shadow->cache->remove(key);
+        }
+    }
+
+    // 按容量从小到大的当前曲线
+    std::vector<MissRatioPoint> curve() const {
+        std::vector<MissRatioPoint> points;
+        points.reserve(shadows_.size());
+        for (const std::unique_ptr<Shadow>& shadow: shadows_) {
+            MissRatioPoint point;
+            point.capacity = shadow->capacity;
+            point.shadowCapacity = shadow->shadowCapacity;
+            point.accesses = shadow->accesses.load();
+            point.misses = shadow->misses.load();
+            points.push_back(point);
+        }
+        return points;
+    }
+
+    /**
+     * 开始新的统计周期: 只清零计数, 影子缓存保持原有内容(已经预热), 曲线只反映之后的访问
+     * 与记录并发调用时, 正在进行的记录可能计入任意一个周期
+    */
+    void resetCounters() {
+        for (const std::unique_ptr<Shadow>& shadow: shadows_) {
+            shadow->accesses.reset();
+            shadow->misses.reset();
+        }
+    }
+
+private:
+    static constexpr uint64_t kSampleModulus = uint64_t(1) << 24;
+    static constexpr uint64_t kSampleSeed = 0x5bd1e9955bd1e995ULL;
+
+    struct Shadow {
+        Shadow(size_t capacity, size_t shadowCapacity, std::unique_ptr<ShadowCache> cache)
+            : capacity(capacity)
+            , shadowCapacity(shadowCapacity)
+            , cache(std::move(cache))
+        {}
+
+        size_t capacity;
+        size_t shadowCapacity;
+        std::unique_ptr<ShadowCache> cache;
+        StatCounter accesses;       // 多个线程同时记录, 用原子加
+        StatCounter misses;
+    };
+
+    uint64_t threshold_;            // 哈希值低 24 位小于它的 key 被抽中
+    Hash hasher_;
+    std::vector<std::unique_ptr<Shadow>> shadows_;
+};
+
+/**
+ * 给任意 CacheStrategy 套上命中率曲线估计: 所有查找(get/getMany)先交给 CacheMissRatioCurve 记录, 再转发给内部缓存
+ * 写入不记录(读未命中后的回填由影子缓存自己完成), 删除同时作用于影子缓存, 其余操作原样转发
+ * 用法: 生产环境里用采样率 0.1%~1% 包一层, 定期读取 missRatioCurve().curve(), 看增加多少容量能换来多少命中率
+*/
+template<typename Key, typename Value, typename Hash = CacheHash<Key>>
+class MissRatioCurveTracker : public CacheStrategy<Key, Value> {
+public:
+    using Curve = CacheMissRatioCurve<Key, Hash>;
+
+    MissRatioCurveTracker(std::unique_ptr<CacheStrategy<Key, Value>> cache, std::vector<size_t> capacities,
+                          double sampleRate = 0.01, typename Curve::ShadowFactory shadowFactory = nullptr)
+        : cache_(std::move(cache))
+        , curve_(std::move(capacities), sampleRate, std::move(shadowFactory))
+    {
+        this->template useLoadHash<Hash>();
+    }
+
+    ~MissRatioCurveTracker() override {
+        this->cancelLoads();
+    }
+
+    void put(const Key& key, const Value& value) override {
+        cache_->put(key, value);
+    }
+
+    void put(const Key& key, Value&& value) override {
+        cache_->put(key, std::move(value));
+    }
+
+    bool get(const Key& key, Value& value) override {
+        curve_.record(key);
+        return cache_->get(key, value);
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    bool contains(const Key& key) override {
+        return cache_->contains(key);
+    }
+
+    void remove(const Key& key) override {
+        curve_.remove(key);
+        cache_->remove(key);
+    }
+
+    size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) override {
+        for (const Key& key: keys) {
+            curve_.record(key);
+        }
+        return cache_->getMany(keys, values, found);
+    }
+
+    void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) override {
+        cache_->putMany(keys, values);
+    }
+
+    CacheStatsSnapshot getStats() override {
+        return cache_->getStats();
+    }
+
+    Curve& missRatioCurve() {
+        return curve_;
+    }
+
+private:
+    std::unique_ptr<CacheStrategy<Key, Value>> cache_;     // 被观测的内部缓存
+    Curve curve_;
+};
+
+} // namespace Cache
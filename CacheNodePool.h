@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "CacheNuma.h"
+
+namespace Cache {
+
+/**
+ * 缓存节点内存池 (slab 分配器)
+ * 1. 按块(chunk)申请节点内存, 块一旦申请就不会移动, 节点地址在其生命周期内保持稳定,
+ *    因此节点之间可以直接用裸指针做侵入式链表
+ * 2. 释放的节点串在侵入式空闲链表上, 分配/释放都是 O(1), 命中路径上不再有堆分配和引用计数
+ * 3. 首块按 (主缓存容量 + ghost容量) 预留, 之后容量不够时按块增长
+ * 4. 内存池本身不加锁, 由所属缓存的互斥锁保护
+ * 5. 内存池只管理内存, 仍存活的节点必须由所属缓存在析构前通过 deallocate() 归还
+ * 6. setNumaNode() 之后新的块分配在指定的 NUMA 节点上, 已有的块整体迁移过去(节点地址不变)
+*/
+template<typename T>
+class NodePool {
+public:
+    explicit NodePool(size_t initialCapacity = 0, size_t minChunkSize = 64)
+        : freeList_(nullptr)
+        , bumpCur_(nullptr)
+        , bumpEnd_(nullptr)
+        , minChunkSize_(minChunkSize > 0 ? minChunkSize : 1)
+        , capacity_(0)
+        , liveCount_(0)
+    {
+        if (initialCapacity > 0) {
+            addChunk(initialCapacity);
+        }
+    }
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    // 从内存池取出一个槽位并原地构造节点
+    template<typename... Args>
+    T* allocate(Args&&... args) {
+        Slot* slot = nullptr;
+        if (freeList_ != nullptr) {
+            slot = freeList_;
+            freeList_ = freeList_->next;
+        }
+        else {
+            if (bumpCur_ == bumpEnd_) {
+                // 当前块用完了, 按已有容量的一半增长, 摊还后分配次数是对数级的
+                addChunk(std::max(minChunkSize_, capacity_ / 2));
+            }
+            slot = bumpCur_++;
+        }
+        T* node = new (slot->storage) T(std::forward<Args>(args)...);
+        liveCount_++;
+        return node;
+    }
+
+    // 析构节点并把槽位挂回空闲链表
+    void deallocate(T* node) {
+        if (node == nullptr) return;
+        node->~T();
+        Slot* slot = reinterpret_cast<Slot*>(node);
+        slot->next = freeList_;
+        freeList_ = slot;
+        liveCount_--;
+    }
+
+    // 之后的块绑定到 NUMA 节点 node 并迁移已有的块; node < 0 时恢复普通分配, 已有的块不动
+    void setNumaNode(int node) {
+        numaNode_ = node;
+        if (node < 0) return;
+        for (NumaArray<Slot>& chunk: chunks_) {
+            chunk.moveToNode(node);
+        }
+    }
+
+    // 已申请的槽位总数
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    // 正在使用的节点数
+    size_t liveCount() const {
+        return liveCount_;
+    }
+
+private:
+    // 槽位: 空闲时存放空闲链表指针, 使用时存放节点本身
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    void addChunk(size_t count) {
+        // 新块通过 bump 指针按需切分, 不提前遍历串链, 避免预留阶段就把整块内存都摸一遍
+        chunks_.emplace_back(count, numaNode_);
+        bumpCur_ = chunks_.back().get();
+        bumpEnd_ = bumpCur_ + count;
+        capacity_ += count;
+    }
+
+private:
+    std::vector<NumaArray<Slot>> chunks_;           // 已申请的内存块
+    Slot* freeList_;                                // 空闲链表
+    Slot* bumpCur_;                                 // 当前块中下一个未使用的槽位
+    Slot* bumpEnd_;                                 // 当前块的末尾
+    size_t minChunkSize_;                           // 增长时的最小块大小
+    size_t capacity_;                               // 槽位总数
+    size_t liveCount_;                              // 存活节点数
+    int numaNode_ = -1;                             // 新块所在的 NUMA 节点, -1 表示不指定
+};
+
+} // namespace Cache
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// 编译期开关: 只有 Linux 并且系统调用号可用时才真正按 NUMA 节点放置内存, 其他平台上以下接口退化为普通分配
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_getcpu)
+#define CACHE_NUMA_SUPPORTED 1
+#else
+#define CACHE_NUMA_SUPPORTED 0
+#endif
+
+/**
+ * NUMA 内存放置的公共部分, 不依赖 libnuma, 直接使用 mbind/getcpu 系统调用
+ * 1. numaNodeCount()/currentNumaNode(): 系统的 NUMA 节点数和当前线程所在的节点
+ * 2. numaBindMemory(): 把一段内存的放置策略设为优先使用某个节点, 可以同时迁移已经分配的物理页
+ * 3. NumaArray: 节点内存池的块和索引数组使用的定长数组, 指定节点时单独 mmap 并绑定到该节点,
+ *    否则与 new T[] 相同; 之后仍可以通过 moveToNode() 整体迁移
+ * 单节点的机器、不支持的平台或者系统调用失败时, 分配照常进行, 只是不保证放置
+*/
+
+namespace Cache {
+
+// 系统的 NUMA 节点数, 读取 /sys/devices/system/node/online, 无法确定时返回 1
+inline size_t numaNodeCount() {
+    static const size_t count = [] {
+        size_t nodes = 1;
+#if CACHE_NUMA_SUPPORTED
+        // 文件内容形如 "0" 或 "0-1" 或 "0,2-3", 取最大的节点号 + 1
+        if (FILE* file = std::fopen("/sys/devices/system/node/online", "r")) {
+            int c = 0;
+            size_t number = 0;
+            bool inNumber = false;
+            while ((c = std::fgetc(file)) != EOF) {
+                if (c >= '0' && c <= '9') {
+                    number = (inNumber ? number * 10 : 0) + static_cast<size_t>(c - '0');
+                    inNumber = true;
+                }
+                else {
+                    if (inNumber && number + 1 > nodes) nodes = number + 1;
+                    inNumber = false;
+                }
+            }
+            if (inNumber && number + 1 > nodes) nodes = number + 1;
+            std::fclose(file);
+        }
+#endif
+        return nodes;
+    }();
+    return count;
+}
+
+/**
+ * 当前线程所在的 NUMA 节点, 无法确定时返回 0
+ * 结果按线程缓存, 每 kNumaNodeRefresh 次调用重新查询一次, 线程被迁移到其他节点后最多延迟这么多次才能感知
+*/
+constexpr unsigned kNumaNodeRefresh = 1024;
+
+inline int currentNumaNode() {
+#if CACHE_NUMA_SUPPORTED
+    static thread_local int node = 0;
+    static thread_local unsigned calls = 0;
+    if (calls++ % kNumaNodeRefresh == 0) {
+        unsigned cpu = 0;
+        unsigned current = 0;
+        if (syscall(SYS_getcpu, &cpu, &current, nullptr) == 0) {
+            node = static_cast<int>(current);
+        }
+    }
+    return node;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * 把 [addr, addr + bytes) 完整覆盖的页的放置策略设为优先使用 node(MPOL_PREFERRED, 该节点内存不足时仍可以分配到其他节点)
+ * move 为 true 时同时迁移已经分配的物理页; 首尾不满一页的部分可能和其他对象共用页, 不做处理
+ * node 无效、不支持或者系统调用失败时返回 false, 内存本身不受影响
+*/
+inline bool numaBindMemory(void* addr, size_t bytes, int node, bool move) {
+#if CACHE_NUMA_SUPPORTED
+    constexpr size_t kMaskWords = 16;
+    constexpr size_t kMaskBits = kMaskWords * sizeof(unsigned long) * 8;
+    constexpr int kMpolPreferred = 1;
+    constexpr unsigned kMpolMfMove = 1u << 1;
+    if (node < 0 || static_cast<size_t>(node) >= numaNodeCount() || static_cast<size_t>(node) >= kMaskBits) return false;
+
+    uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(addr) + page - 1) & ~(page - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(addr) + bytes) & ~(page - 1);
+    if (end <= begin) return true;
+
+    unsigned long mask[kMaskWords] = {};
+    mask[node / (sizeof(unsigned long) * 8)] = 1ul << (node % (sizeof(unsigned long) * 8));
+    // maxnode 按内核的约定多传一位
+    return syscall(SYS_mbind, begin, end - begin, kMpolPreferred, mask, kMaskBits + 1, move ? kMpolMfMove : 0u) == 0;
+#else
+    (void)addr;
+    (void)bytes;
+    (void)node;
+    (void)move;
+    return false;
+#endif
+}
+
+/**
+ * 定长数组, 只用于构造和析构平凡的 T, 内容不初始化(单独映射的内存为零)
+ * node >= 0 并且平台支持时整块 mmap(按页对齐, 不和其他对象共用页)后绑定到该节点, 物理页在第一次写入时分配在该节点上;
+ * 否则与 new T[] 相同
+*/
+template<typename T>
+class NumaArray {
+    static_assert(std::is_trivially_default_constructible<T>::value && std::is_trivially_destructible<T>::value,
+                  "NumaArray only holds trivial types");
+
+public:
+    NumaArray() = default;
+
+    explicit NumaArray(size_t count, int node = -1)
+        : count_(count)
+    {
+        if (count == 0) return;
+#if CACHE_NUMA_SUPPORTED
+        if (node >= 0 && static_cast<size_t>(node) < numaNodeCount()) {
+            void* memory = mmap(nullptr, bytes(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory != MAP_FAILED) {
+                numaBindMemory(memory, roundToPage(bytes()), node, false);
+                data_ = static_cast<T*>(memory);
+                mapped_ = true;
+                return;
+            }
+        }
+#else
+        (void)node;
+#endif
+        data_ = static_cast<T*>(::operator new(bytes(), std::align_val_t(alignof(T))));
+    }
+
+    ~NumaArray() {
+        release();
+    }
+
+    NumaArray(NumaArray&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , count_(std::exchange(other.count_, 0))
+        , mapped_(std::exchange(other.mapped_, false))
+    {}
+
+    NumaArray& operator=(NumaArray&& other) noexcept {
+        if (this != &other) {
+            release();
+            data_ = std::exchange(other.data_, nullptr);
+            count_ = std::exchange(other.count_, 0);
+            mapped_ = std::exchange(other.mapped_, false);
+        }
+        return *this;
+    }
+
+    NumaArray(const NumaArray&) = delete;
+    NumaArray& operator=(const NumaArray&) = delete;
+
+    T* get() const {
+        return data_;
+    }
+
+    T& operator[](size_t i) const {
+        return data_[i];
+    }
+
+    size_t size() const {
+        return count_;
+    }
+
+    // 把已经分配的物理页迁移到 node, 之后新分配的页也优先放在 node; 不是单独映射的数组只迁移完整覆盖的页
+    bool moveToNode(int node) {
+        if (data_ == nullptr) return true;
+        return numaBindMemory(data_, mapped_ ? roundToPage(bytes()) : bytes(), node, true);
+    }
+
+private:
+    size_t bytes() const {
+        return count_ * sizeof(T);
+    }
+
+    static size_t roundToPage(size_t bytes) {
+#if CACHE_NUMA_SUPPORTED
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return (bytes + page - 1) / page * page;
+#else
+        return bytes;
+#endif
+    }
+
+    void release() {
+        if (data_ == nullptr) return;
+#if CACHE_NUMA_SUPPORTED
+        if (mapped_) {
+            munmap(data_, roundToPage(bytes()));
+            data_ = nullptr;
+            return;
+        }
+#endif
+        ::operator delete(data_, std::align_val_t(alignof(T)));
+        data_ = nullptr;
+    }
+
+private:
+    T* data_ = nullptr;
+    size_t count_ = 0;
+    bool mapped_ = false;   // 是否单独 mmap(指定了节点)
+};
+
+} // namespace Cache
@@ -0,0 +1,626 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CacheStrategy.h"
+#include "CacheBatch.h"
+#include "CacheHash.h"
+#include "CacheStats.h"
+#include "CacheTimerWheel.h"
+#include "CacheNuma.h"
+
+namespace Cache {
+
+/**
+ * 分片层的锁策略: 各缓存实现内部已经加锁, 默认分片层不再加锁(lock/unlock 内联后什么也不做)
+ * 包装一个本身不加锁的实现时, 可以换成 std::mutex 等任何满足 BasicLockable 的类型
+*/
+struct NullShardLock {
+    void lock() {}
+    void unlock() {}
+};
+
+// 分片层的统计策略: 默认汇总所有分片的统计
+struct SumShardStats {
+    template<typename Policy>
+    void collect(Policy& shard, CacheStatsSnapshot& snapshot) {
+        snapshot += shard.Policy::getStats();
+    }
+};
+
+// 不需要统计时 getStats() 直接返回全零, 不访问任何分片
+struct NoShardStats {
+    template<typename Policy>
+    void collect(Policy&, CacheStatsSnapshot&) {}
+};
+
+/**
+ * 分片表的保护策略: 默认分片数固定, 分片表构造后不再改变, 访问分片不需要任何同步(加解锁内联后什么也不做)
+ * 需要在运行中调整分片数(resizeShards)时换成 ResizableShards
+*/
+struct FixedShards {
+    static constexpr bool kResizable = false;
+
+    void lock_shared() {}
+    void unlock_shared() {}
+};
+
+/**
+ * 可以在线调整分片数的分片表保护 (按线程分条带的读写锁, big-reader lock)
+ * 1. 每个操作只在自己线程所在条带的计数器上加一再减一, 条带各占一个缓存行, 不同线程之间几乎不争用;
+ *    另外只读一次很少改变的 resizing_ 标志
+ * 2. 调整分片数时先置位 resizing_, 新的操作在入口处等待, 再等所有条带的计数器归零, 之后独占分片表
+ * 3. 调整期间所有操作都会暂停, 直到条目迁移完成; 淘汰监听器等在分片内调用的回调不能再访问同一个缓存
+*/
+class ResizableShards {
+public:
+    static constexpr bool kResizable = true;
+
+    void lock_shared() {
+        Stripe& stripe = stripes_[threadStripe()];
+        while (true) {
+            // 与 lock() 中 "先置位再检查计数器" 配对, 两边都用 seq_cst, 保证不会同时进入
+            stripe.readers.fetch_add(1, std::memory_order_seq_cst);
+            if (!resizing_.load(std::memory_order_seq_cst)) return;
+            stripe.readers.fetch_sub(1, std::memory_order_release);
+            while (resizing_.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void unlock_shared() {
+        stripes_[threadStripe()].readers.fetch_sub(1, std::memory_order_release);
+    }
+
+    void lock() {
+        writerMutex_.lock();
+        resizing_.store(true, std::memory_order_seq_cst);
+        for (Stripe& stripe: stripes_) {
+            while (stripe.readers.load(std::memory_order_seq_cst) != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void unlock() {
+        resizing_.store(false, std::memory_order_release);
+        writerMutex_.unlock();
+    }
+
+private:
+    static constexpr size_t kStripes = 32;
+
+    struct alignas(64) Stripe {
+        std::atomic<size_t> readers{0};
+    };
+
+    static size_t threadStripe() {
+        static thread_local size_t stripe = std::hash<std::thread::id>()(std::this_thread::get_id()) % kStripes;
+        return stripe;
+    }
+
+    alignas(64) std::atomic<bool> resizing_{false};
+    std::mutex writerMutex_;    // 串行化多个同时调整分片数的调用方
+    Stripe stripes_[kStripes];
+};
+
+/**
+ * 编译期组合的分片缓存: 按 key 的哈希值把请求路由到 Policy 的某个分片
+ * 1. Policy 是具体的缓存实现(LruCache/LfuCache/LruKCache/ArcCache/TinyLfuCache...),
+ *    对分片的调用都写成 Policy::get() 这样的限定调用, 静态绑定, 编译器可以把整条查找路径内联
+ * 2. 分片由哈希值的高 32 位决定(乘法取高位, 不取模), 分片内的索引使用低位, 两者互不相关;
+ *    ShardCount 不为 0 时分片数是编译期常量, 为 2 的幂时路由折叠成一次移位; 为 0 时分片数在构造时给出
+ * 3. Hasher 决定路由用的哈希(默认 CacheHash, 未声明 is_avalanching 的哈希会先补一次混合),
+ *    Lock 是分片层额外加的锁, Stats 决定 getStats() 如何汇总, Resize 决定分片数能否在运行中调整
+ * 4. rebalanceCapacity() 按各分片的容量需求在分片之间重新分配容量, 总容量不变
+ * 5. placeShardsOnNumaNodes() 把分片按顺序均分到各个 NUMA 节点上, setNumaLocalRouting() 让线程只访问本节点的分片
+ * 本身没有虚函数; 需要通过 CacheStrategy 使用时见 ShardedCacheStrategy
+*/
+template<typename Policy,
+         size_t ShardCount = 0,
+         typename Hasher = CacheHash<typename Policy::KeyType>,
+         typename Lock = NullShardLock,
+         typename Stats = SumShardStats,
+         typename Resize = FixedShards>
+class ShardedCache {
+public:
+    using Key = typename Policy::KeyType;
+    using Value = typename Policy::ValueType;
+
+    /**
+     * 每个分片构造为 Policy(ceil(capacity / 分片数), policyArgs...), capacity 是总容量(或总权重预算)
+     * shardCount 不为正时按 CPU 核数; ShardCount 不为 0 时以编译期的分片数为准, 忽略 shardCount
+    */
+    template<typename... Args>
+    ShardedCache(size_t capacity, int shardCount, const Args&... policyArgs)
+        : capacity_(capacity)
+        , shardCount_(ShardCount != 0 ? ShardCount : defaultShardCount(shardCount))
+        , shards_(new Shard[shardCount_])
+    {
+        if constexpr (Resize::kResizable) {
+            // 调整分片数时用同样的参数构造新的分片
+            makeShard_ = [=](size_t shardCapacity) { return std::make_unique<Policy>(shardCapacity, policyArgs...); };
+        }
+        size_t shardCapacity = std::ceil(capacity / static_cast<double>(shardCount_));
+        for (size_t i = 0; i < shardCount_; i++) {
+            shards_[i].policy = std::make_unique<Policy>(shardCapacity, policyArgs...);
+        }
+    }
+
+    ShardedCache(const ShardedCache&) = delete;
+    ShardedCache& operator=(const ShardedCache&) = delete;
+
+    void put(const Key& key, const Value& value) {
+        std::shared_lock<Resize> guard(resize_);
+        callShard(shardOf(key), [&](Policy& shard) { shard.Policy::put(key, value); });
+    }
+
+    void put(const Key& key, Value&& value) {
+        std::shared_lock<Resize> guard(resize_);
+        callShard(shardOf(key), [&](Policy& shard) { shard.Policy::put(key, std::move(value)); });
+    }
+
+    // 带 TTL 的添加, 只有 Policy 支持 TTL 时才能调用
+    void put(const Key& key, const Value& value, std::chrono::nanoseconds ttl) {
+        std::shared_lock<Resize> guard(resize_);
+        callShard(shardOf(key), [&](Policy& shard) { shard.Policy::put(key, value, ttl); });
+    }
+
+    void put(const Key& key, Value&& value, std::chrono::nanoseconds ttl) {
+        std::shared_lock<Resize> guard(resize_);
+        callShard(shardOf(key), [&](Policy& shard) { shard.Policy::put(key, std::move(value), ttl); });
+    }
+
+    template<typename... Args>
+    void emplace(const Key& key, Args&&... args) {
+        std::shared_lock<Resize> guard(resize_);
+        callShard(shardOf(key), [&](Policy& shard) { shard.emplace(key, std::forward<Args>(args)...); });
+    }
+
+    bool get(const Key& key, Value& value) {
+        std::shared_lock<Resize> guard(resize_);
+        return callShard(shardOf(key), [&](Policy& shard) { return shard.Policy::get(key, value); });
+    }
+
+    Value get(const Key& key) {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    bool contains(const Key& key) {
+        std::shared_lock<Resize> guard(resize_);
+        return callShard(shardOf(key), [&](Policy& shard) { return shard.Policy::contains(key); });
+    }
+
+    void remove(const Key& key) {
+        std::shared_lock<Resize> guard(resize_);
+        callShard(shardOf(key), [&](Policy& shard) { shard.Policy::remove(key); });
+    }
+
+    // 批量查找: 先按分片分组, 每个分片只调用一次 getBatch(), 即只加一次锁
+    size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        std::shared_lock<Resize> guard(resize_);
+        ShardBatch batch(keys, keys.size(), shardCount_, [this](const Key& key) { return shardOf(key); });
+        size_t hits = 0;
+        for (size_t i = 0; i < shardCount_; i++) {
+            if (batch.size(i) == 0) continue;
+            hits += callShard(i, [&](Policy& shard) {
+                return shard.Policy::getBatch(keys, batch.indices(i), batch.size(i), values, found);
+            });
+        }
+        return hits;
+    }
+
+    void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) {
+        size_t count = std::min(keys.size(), values.size());
+        std::shared_lock<Resize> guard(resize_);
+        ShardBatch batch(keys, count, shardCount_, [this](const Key& key) { return shardOf(key); });
+        for (size_t i = 0; i < shardCount_; i++) {
+            if (batch.size(i) == 0) continue;
+            callShard(i, [&](Policy& shard) {
+                shard.Policy::putBatch(keys, values, batch.indices(i), batch.size(i));
+            });
+        }
+    }
+
+    // 每个分片只在自己被访问时回收过期条目, 这里逐个分片回收
+    void purgeExpired() {
+        forEachShard([](Policy& shard) { shard.Policy::purgeExpired(); });
+    }
+
+    // 清空所有分片
+    void purge() {
+        forEachShard([](Policy& shard) { shard.Policy::purge(); });
+    }
+
+    // 每个分片各自持有一份监听器的拷贝, 回调可能在不同分片的锁内并发调用
+    void setEvictionListener(const CacheEvictionListener<Key, Value>& listener) {
+        std::shared_lock<Resize> guard(resize_);
+        if constexpr (Resize::kResizable) listener_ = listener;
+        forEachShardLocked([&listener](Policy& shard) { shard.Policy::setEvictionListener(listener); });
+    }
+
+    // 后台维护的入口(见 CacheMaintainer), 逐个分片转发, 只有 Policy 支持时才能调用
+    void setDeferredRelease(bool enabled) {
+        std::shared_lock<Resize> guard(resize_);
+        deferredRelease_ = enabled;
+        forEachShardLocked([enabled](Policy& shard) { shard.Policy::setDeferredRelease(enabled); });
+    }
+
+    void runMaintenance() {
+        forEachShard([](Policy& shard) { shard.Policy::runMaintenance(); });
+    }
+
+    std::vector<Key> expiringKeys(std::chrono::nanoseconds window) {
+        std::vector<Key> keys;
+        forEachShard([&](Policy& shard) {
+            std::vector<Key> shardKeys = shard.Policy::expiringKeys(window);
+            keys.insert(keys.end(), shardKeys.begin(), shardKeys.end());
+        });
+        return keys;
+    }
+
+    // 提前刷新的写回, 只有 Policy 支持 TTL 时才能调用
+    template<typename V>
+    bool refresh(const Key& key, V&& value, std::chrono::nanoseconds ttl) {
+        std::shared_lock<Resize> guard(resize_);
+        return callShard(shardOf(key), [&](Policy& shard) { return shard.Policy::refresh(key, std::forward<V>(value), ttl); });
+    }
+
+    CacheStatsSnapshot getStats() {
+        CacheStatsSnapshot snapshot;
+        forEachShard([&](Policy& shard) { stats_.collect(shard, snapshot); });
+        return snapshot;
+    }
+
+    // key 所在的分片; 分片数可调整时结果只在调用方持有分片表期间有效, 外部使用时见 withShard()
+    // 开启 NUMA 本地路由时结果取决于调用线程所在的节点
+    size_t shardOf(const Key& key) const {
+        size_t count = ShardCount != 0 ? ShardCount : shardCount_;
+        uint64_t hash = cacheHashOf(hasher_, key);
+        if (numaLocalRouting_.load(std::memory_order_relaxed)) {
+            return shardOnNumaNode(hash, currentNumaNode(), count);
+        }
+        return cacheShardOf(hash, count);
+    }
+
+    // 在分片层的锁内对第 index 个分片调用 func(分片), 用于分片特有的操作
+    template<typename Func>
+    decltype(auto) withShard(size_t index, Func&& func) {
+        std::shared_lock<Resize> guard(resize_);
+        return callShard(index, std::forward<Func>(func));
+    }
+
+    template<typename Func>
+    void forEachShard(Func&& func) {
+        std::shared_lock<Resize> guard(resize_);
+        forEachShardLocked(func);
+    }
+
+    /**
+     * 分片间容量再平衡(由调用方定期调用), 总容量不变
+     * 1. demand(分片) 返回该分片上个周期的容量需求并清零, 例如 ARC 的 ghost 命中次数、LRU/LFU 的未命中次数
+     * 2. 每个分片至少保留 minShardCapacity 的容量, 其余容量按需求(+1 平滑)按比例分配
+     * 3. 新容量取目标值与当前值的平均, 避免负载抖动时分片容量来回震荡
+     * Policy 需要提供 getCapacity()/resize()
+    */
+    template<typename Demand>
+    void rebalanceCapacity(Demand&& demand, size_t minShardCapacity = 1) {
+        std::shared_lock<Resize> guard(resize_);
+        size_t minTotal = minShardCapacity * shardCount_;
+        if (capacity_ <= minTotal) return;
+
+        std::vector<size_t> weights(shardCount_);
+        size_t totalWeight = 0;
+        for (size_t i = 0; i < shardCount_; i++) {
+            weights[i] = callShard(i, [&](Policy& shard) { return static_cast<size_t>(demand(shard)); }) + 1;
+            totalWeight += weights[i];
+        }
+
+        size_t spare = capacity_ - minTotal;
+        size_t assigned = 0;
+        std::vector<size_t> targets(shardCount_);
+        for (size_t i = 0; i < shardCount_; i++) {
+            targets[i] = minShardCapacity + spare * weights[i] / totalWeight;
+            assigned += targets[i];
+        }
+        // 整除余下的容量给第一个分片
+        targets[0] += capacity_ - assigned;
+
+        // 取平均同样按整除余数修正: 少的补给第一个分片, 多的(构造时按向上取整分配)从高于目标的分片扣除, 调整后之和正好是 capacity_
+        std::vector<size_t> capacities(shardCount_);
+        size_t total = 0;
+        for (size_t i = 0; i < shardCount_; i++) {
+            capacities[i] = (callShard(i, [](Policy& shard) { return shard.Policy::getCapacity(); }) + targets[i]) / 2;
+            total += capacities[i];
+        }
+        if (total < capacity_) capacities[0] += capacity_ - total;
+        for (size_t i = 0; i < shardCount_ && total > capacity_; i++) {
+            size_t excess = capacities[i] > targets[i] ? std::min(total - capacity_, capacities[i] - targets[i]) : 0;
+            capacities[i] -= excess;
+            total -= excess;
+        }
+
+        for (size_t i = 0; i < shardCount_; i++) {
+            callShard(i, [&](Policy& shard) { shard.Policy::resize(capacities[i]); });
+        }
+    }
+
+    /**
+     * 在线调整分片数(只有 Resize 为 ResizableShards 时可用), shardCount 不为正时按 CPU 核数, 例如线程数变化之后
+     * 1. 等正在进行的操作结束后独占分片表, 期间新的操作在入口处等待
+     * 2. 按原来的构造参数创建新的分片, 总容量平均分配, 并恢复淘汰监听器和延迟释放的设置
+     * 3. 旧分片的条目按各自的淘汰顺序(最旧的先)迁移到新分片, 保留剩余 TTL;
+     *    分片之间的相对新旧顺序不保留, LFU 的访问频次从 1 重新开始
+     * Policy 需要提供 drainEntries()
+    */
+    void resizeShards(int shardCount) {
+        static_assert(Resize::kResizable && ShardCount == 0, "resizeShards() requires ResizableShards and a runtime shard count");
+        size_t newCount = defaultShardCount(shardCount);
+        std::lock_guard<Resize> guard(resize_);
+        if (newCount == shardCount_) return;
+
+        std::unique_ptr<Shard[]> shards(new Shard[newCount]);
+        size_t shardCapacity = std::ceil(capacity_ / static_cast<double>(newCount));
+        for (size_t i = 0; i < newCount; i++) {
+            shards[i].policy = makeShard_(shardCapacity);
+            if (listener_) shards[i].policy->Policy::setEvictionListener(listener_);
+            if (deferredRelease_) shards[i].policy->Policy::setDeferredRelease(true);
+            if (numaPlaced_) shards[i].policy->Policy::setNumaNode(numaNodeOfShard(i, newCount));
+        }
+        std::unique_ptr<Shard[]> old(shards_.release());
+        size_t oldCount = shardCount_;
+        shards_ = std::move(shards);
+        shardCount_ = newCount;
+
+        uint64_t now = cacheNowNanos();
+        bool local = numaLocalRouting_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < oldCount; i++) {
+            // 本地路由时条目留在原分片所在节点的新分片里
+            int node = numaNodeOfShard(i, oldCount);
+            old[i].policy->Policy::drainEntries([&](const Key& key, Value& value, uint64_t expireAt) {
+                uint64_t hash = cacheHashOf(hasher_, key);
+                Policy& shard = *shards_[local ? shardOnNumaNode(hash, node, newCount) : cacheShardOf(hash, newCount)].policy;
+                if (expireAt == 0) {
+                    shard.Policy::put(key, std::move(value));
+                }
+                else if (expireAt > now) {
+                    shard.Policy::put(key, std::move(value), std::chrono::nanoseconds(expireAt - now));
+                }
+            });
+        }
+    }
+
+    size_t shardCount() {
+        std::shared_lock<Resize> guard(resize_);
+        return shardCount_;
+    }
+
+    /**
+     * NUMA 放置: 分片按顺序均分到各个节点(第 i 个分片在节点 i * 节点数 / 分片数),
+     * 每个分片的节点内存池和索引绑定到所在节点, 已有的内存一并迁移; 之后调整分片数时新的分片同样放置
+     * 分片对象本身(锁、统计和链表头)仍在构造线程所在的节点上, 只占几个缓存行
+     * Policy 需要提供 setNumaNode()
+    */
+    void placeShardsOnNumaNodes() {
+        std::shared_lock<Resize> guard(resize_);
+        numaPlaced_ = true;
+        for (size_t i = 0; i < shardCount_; i++) {
+            callShard(i, [&](Policy& shard) { shard.Policy::setNumaNode(numaNodeOfShard(i, shardCount_)); });
+        }
+    }
+
+    /**
+     * NUMA 本地路由: 每个线程只访问自己所在节点上的分片, key 在本节点的分片之间按哈希分布
+     * 相当于每个节点一份独立的缓存, 同一个 key 从不同节点写入会各存一份并且互不失效,
+     * 只适合 key 按节点划分的场景(例如按连接或会话分配线程, 每个 key 只被同一个节点上的线程访问);
+     * 应当在写入数据之前设置, 没有分片的节点上的线程仍按全局哈希路由。通常与 placeShardsOnNumaNodes() 一起使用
+    */
+    void setNumaLocalRouting(bool enabled) {
+        numaLocalRouting_.store(enabled, std::memory_order_relaxed);
+    }
+
+    // 第 index 个分片所在的 NUMA 节点(按 placeShardsOnNumaNodes() 的划分)
+    static int numaNodeOfShard(size_t index, size_t shardCount) {
+        return static_cast<int>(index * numaNodeCount() / shardCount);
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    struct Shard {
+        Lock lock;
+        std::unique_ptr<Policy> policy;
+    };
+
+    // 以下由调用方持有分片表(resize_ 的共享锁)
+    template<typename Func>
+    decltype(auto) callShard(size_t index, Func&& func) {
+        Shard& shard = shards_[index];
+        std::lock_guard<Lock> guard(shard.lock);
+        return func(*shard.policy);
+    }
+
+    template<typename Func>
+    void forEachShardLocked(Func&& func) {
+        for (size_t i = 0; i < shardCount_; i++) {
+            callShard(i, func);
+        }
+    }
+
+    // 节点 node 的分片为 [ceil(node * count / 节点数), ceil((node + 1) * count / 节点数)), 与 numaNodeOfShard() 一致
+    static size_t shardOnNumaNode(uint64_t hash, int node, size_t count) {
+        size_t nodes = numaNodeCount();
+        size_t begin = (static_cast<size_t>(node) * count + nodes - 1) / nodes;
+        size_t end = std::min(count, ((static_cast<size_t>(node) + 1) * count + nodes - 1) / nodes);
+        if (begin >= end) return cacheShardOf(hash, count);
+        return begin + cacheShardOf(hash, end - begin);
+    }
+
+    static size_t defaultShardCount(int shardCount) {
+        if (shardCount > 0) return shardCount;
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+private:
+    size_t capacity_;                   // 缓存总容量
+    size_t shardCount_;                 // 分片数量
+    std::unique_ptr<Shard[]> shards_;
+    Hasher hasher_;
+    Stats stats_;
+    Resize resize_;                     // 分片表的保护, 分片数固定时为空操作
+    std::function<std::unique_ptr<Policy>(size_t)> makeShard_;     // 分片数可调整时用来构造新的分片
+    CacheEvictionListener<Key, Value> listener_;                    // 分片数可调整时记下, 新的分片同样设置
+    bool deferredRelease_ = false;
+    bool numaPlaced_ = false;           // 是否调用过 placeShardsOnNumaNodes(), 调整分片数时同样放置
+    std::atomic<bool> numaLocalRouting_{false};
+};
+
+/**
+ * 把 ShardedCache 包装成 CacheStrategy, 供需要运行时多态的调用方使用(基准测试里按名字选择策略等)
+ * 虚函数只在最外层分派一次, 进入分片后仍然是静态绑定的调用; HashLruCaches 等分片缓存都基于它
+*/
+template<typename Policy,
+         size_t ShardCount = 0,
+         typename Hasher = CacheHash<typename Policy::KeyType>,
+         typename Lock = NullShardLock,
+         typename Stats = SumShardStats,
+         typename Resize = FixedShards>
+class ShardedCacheStrategy : public CacheStrategy<typename Policy::KeyType, typename Policy::ValueType> {
+public:
+    using Sharded = ShardedCache<Policy, ShardCount, Hasher, Lock, Stats, Resize>;
+    using Key = typename Sharded::Key;
+    using Value = typename Sharded::Value;
+
+    template<typename... Args>
+    ShardedCacheStrategy(size_t capacity, int shardCount, const Args&... policyArgs)
+        : sharded_(capacity, shardCount, policyArgs...)
+    {
+        this->template useLoadHash<Hasher>();
+    }
+
+    ~ShardedCacheStrategy() override {
+        this->cancelLoads();
+    }
+
+    void put(const Key& key, const Value& value) override {
+        sharded_.put(key, value);
+    }
+
+    void put(const Key& key, Value&& value) override {
+        sharded_.put(key, std::move(value));
+    }
+
+    // 带 TTL 的添加, 由 key 所在分片回收
+    void put(const Key& key, const Value& value, std::chrono::nanoseconds ttl) {
+        sharded_.put(key, value, ttl);
+    }
+
+    void put(const Key& key, Value&& value, std::chrono::nanoseconds ttl) {
+        sharded_.put(key, std::move(value), ttl);
+    }
+
+    template<typename... Args>
+    void emplace(const Key& key, Args&&... args) {
+        sharded_.emplace(key, std::forward<Args>(args)...);
+    }
+
+    bool get(const Key& key, Value& value) override {
+        return sharded_.get(key, value);
+    }
+
+    Value get(const Key& key) override {
+        return sharded_.get(key);
+    }
+
+    bool contains(const Key& key) override {
+        return sharded_.contains(key);
+    }
+
+    void remove(const Key& key) override {
+        sharded_.remove(key);
+    }
+
+    size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) override {
+        return sharded_.getMany(keys, values, found);
+    }
+
+    void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) override {
+        sharded_.putMany(keys, values);
+    }
+
+    void purgeExpired() {
+        sharded_.purgeExpired();
+    }
+
+    void purge() {
+        sharded_.purge();
+    }
+
+    void setEvictionListener(const CacheEvictionListener<Key, Value>& listener) {
+        sharded_.setEvictionListener(listener);
+    }
+
+    void setDeferredRelease(bool enabled) {
+        sharded_.setDeferredRelease(enabled);
+    }
+
+    void runMaintenance() {
+        sharded_.runMaintenance();
+    }
+
+    std::vector<Key> expiringKeys(std::chrono::nanoseconds window) {
+        return sharded_.expiringKeys(window);
+    }
+
+    template<typename V>
+    bool refresh(const Key& key, V&& value, std::chrono::nanoseconds ttl) {
+        return sharded_.refresh(key, std::forward<V>(value), ttl);
+    }
+
+    // 在线调整分片数, 只有 Resize 为 ResizableShards 时可用; 见 ShardedCache::resizeShards()
+    void resizeShards(int shardCount) {
+        sharded_.resizeShards(shardCount);
+    }
+
+    size_t shardCount() {
+        return sharded_.shardCount();
+    }
+
+    // NUMA 放置和本地路由, 见 ShardedCache::placeShardsOnNumaNodes()/setNumaLocalRouting()
+    void placeShardsOnNumaNodes() {
+        sharded_.placeShardsOnNumaNodes();
+    }
+
+    void setNumaLocalRouting(bool enabled) {
+        sharded_.setNumaLocalRouting(enabled);
+    }
+
+    // 汇总所有分片的统计
+    CacheStatsSnapshot getStats() override {
+        return sharded_.getStats();
+    }
+
+protected:
+    Sharded sharded_;
+};
+
+} // namespace Cache
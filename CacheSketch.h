@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Cache {
+
+/**
+ * TinyLFU 的访问频次估计器: 4 位 count-min sketch + doorkeeper 布隆过滤器
+ * 1. count-min sketch: 4 行计数器, 每个计数器 4 位(最大 15), 16 个计数器压在一个 uint64 里
+ *    每行宽度为 2 的幂, 估计值取 4 行中的最小值; 每个 key 约占 2 字节, 而不是一个完整的哈希表节点
+ * 2. doorkeeper: 一个 key 第一次出现时只记在布隆过滤器里, 第二次出现才开始累加计数器,
+ *    只出现一次的 key(一次性访问)不会占用计数器, 估计值 = 计数器最小值 + (在 doorkeeper 中 ? 1 : 0)
+ * 3. 周期性减半: 记录的访问次数达到采样窗口(10 倍宽度)后, 所有计数器减半并清空 doorkeeper,
+ *    旧的访问频次逐渐衰减, 估计值反映的是最近一段时间内的频次
+ * 本身不加锁, 由所属缓存的锁保护
+*/
+template<typename Key, typename Hash = std::hash<Key>>
+class FrequencySketch {
+public:
+    explicit FrequencySketch(size_t expectedSize = 0) {
+        ensureCapacity(expectedSize);
+    }
+
+    // 按预计的条目数调整大小, 只会变大; 变大时已有的计数全部丢弃
+    void ensureCapacity(size_t expectedSize) {
+        size_t width = kMinWidth;
+        while (width < expectedSize && width < kMaxWidth) {
+            width <<= 1;
+        }
+        if (width <= width_) return;
+
+        width_ = width;
+        table_.assign(kDepth * width_ / kCountersPerWord, 0);
+        doorkeeper_.assign(width_ / 64 * kDoorkeeperBitsPerCounter, 0);
+        sampleSize_ = width_ * 10;
+        additions_ = 0;
+    }
+
+    // 记录一次访问
+    void increment(const Key& key) {
+        uint64_t hash = spread(Hash()(key));
+        additions_++;
+        // 第一次出现只记在 doorkeeper 里, 之后才累加计数器
+        if (doorkeeperTestAndSet(hash)) {
+            for (size_t row = 0; row < kDepth; row++) {
+                incrementAt(row, indexOf(hash, row));
+            }
+        }
+        if (additions_ >= sampleSize_) {
+            reset();
+        }
+    }
+
+    // 估计 key 最近的访问频次, 最大为 16
+    size_t frequency(const Key& key) const {
+        uint64_t hash = spread(Hash()(key));
+        size_t freq = kMaxCount;
+        for (size_t row = 0; row < kDepth; row++) {
+            freq = std::min(freq, counterAt(row, indexOf(hash, row)));
+        }
+        return freq + (doorkeeperContains(hash) ? 1 : 0);
+    }
+
+    // 清空所有记录
+    void clear() {
+        std::fill(table_.begin(), table_.end(), 0);
+        std::fill(doorkeeper_.begin(), doorkeeper_.end(), 0);
+        additions_ = 0;
+    }
+
+    // 每行的计数器个数
+    size_t width() const {
+        return width_;
+    }
+
+private:
+    static constexpr size_t kDepth = 4;                     // count-min 的行数
+    static constexpr size_t kCountersPerWord = 16;          // 每个 uint64 存 16 个 4 位计数器
+    static constexpr size_t kMaxCount = 15;
+    static constexpr size_t kDoorkeeperBitsPerCounter = 4;  // doorkeeper 每个计数器对应 4 位
+    static constexpr size_t kMinWidth = 64;
+    static constexpr size_t kMaxWidth = size_t(1) << 26;    // 设置权重函数后容量可能是字节数, 限制 sketch 的上限
+
+    // 对 std::hash 的结果再做一次混合 (splitmix64 的终结步骤), 整数 key 的 std::hash 通常是恒等映射
+    static uint64_t spread(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    // 第 row 行的计数器下标, 每行用不同的奇数乘子从同一个哈希值导出
+    size_t indexOf(uint64_t hash, size_t row) const {
+        static constexpr uint64_t kSeeds[kDepth] = {
+            0x97cb3127ULL, 0xab0d6e4dULL, 0xc2b2ae3dULL, 0x27d4eb2fULL
+        };
+        uint64_t h = (hash + kSeeds[row]) * (kSeeds[row] | 1) * 0x9e3779b97f4a7c15ULL;
+        return static_cast<size_t>(h >> 32) & (width_ - 1);
+    }
+
+    size_t counterAt(size_t row, size_t index) const {
+        size_t slot = row * width_ + index;
+        return static_cast<size_t>((table_[slot / kCountersPerWord] >> ((slot % kCountersPerWord) * 4)) & 0xf);
+    }
+
+    void incrementAt(size_t row, size_t index) {
+        size_t slot = row * width_ + index;
+        uint64_t& word = table_[slot / kCountersPerWord];
+        size_t shift = (slot % kCountersPerWord) * 4;
+        if (((word >> shift) & 0xf) != kMaxCount) {
+            word += uint64_t(1) << shift;
+        }
+    }
+
+    // doorkeeper 用两个哈希位置, 返回设置之前 key 是否已经在里面
+    bool doorkeeperTestAndSet(uint64_t hash) {
+        size_t bits = doorkeeper_.size() * 64;
+        size_t first = static_cast<size_t>(hash) & (bits - 1);
+        size_t second = static_cast<size_t>(hash >> 32) & (bits - 1);
+        uint64_t firstMask = uint64_t(1) << (first % 64);
+        uint64_t secondMask = uint64_t(1) << (second % 64);
+        bool present = (doorkeeper_[first / 64] & firstMask) && (doorkeeper_[second / 64] & secondMask);
+        doorkeeper_[first / 64] |= firstMask;
+        doorkeeper_[second / 64] |= secondMask;
+        return present;
+    }
+
+    bool doorkeeperContains(uint64_t hash) const {
+        size_t bits = doorkeeper_.size() * 64;
+        size_t first = static_cast<size_t>(hash) & (bits - 1);
+        size_t second = static_cast<size_t>(hash >> 32) & (bits - 1);
+        return (doorkeeper_[first / 64] >> (first % 64) & 1) && (doorkeeper_[second / 64] >> (second % 64) & 1);
+    }
+
+    // 所有计数器减半(每个 4 位计数器右移一位), 清空 doorkeeper
+    void reset() {
+        for (uint64_t& word: table_) {
+            word = (word >> 1) & 0x7777777777777777ULL;
+        }
+        std::fill(doorkeeper_.begin(), doorkeeper_.end(), 0);
+        additions_ /= 2;
+    }
+
+private:
+    size_t width_ = 0;                  // 每行计数器个数, 2 的幂
+    std::vector<uint64_t> table_;       // kDepth 行计数器, 连续存放
+    std::vector<uint64_t> doorkeeper_;  // doorkeeper 位图
+    size_t sampleSize_ = 0;             // 采样窗口, 记录次数达到后减半
+    size_t additions_ = 0;              // 本窗口内记录的访问次数
+};
+
+} // namespace Cache
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CACHE_SNAPSHOT_MMAP 1
+#endif
+
+namespace Cache {
+
+/**
+ * 缓存快照: 把缓存内容连同策略元数据(访问顺序/频次/分区)写进一个紧凑的二进制文件, 重启后直接载入
+ * 1. 文件 = 固定长度的文件头 + 各策略自己的记录, 记录按载入时的插入顺序排列, 载入是一次顺序扫描
+ * 2. 写入先写临时文件再 rename, 中途失败不会留下半个快照; 读取用 mmap 映射整个文件, 不经过额外的缓冲拷贝
+ * 3. key/value 的编码由 CacheSerializer 决定: 可平凡拷贝的类型按原始字节, std::string 为长度 + 字节,
+ *    其他类型特化 CacheSerializer, 或者在 saveSnapshot/loadSnapshot 的模板参数里传入自己的序列化器
+ * 4. TTL 按剩余时间保存, 载入时再扣除两次之间经过的墙上时间, 已经到期的条目不会被载入
+ * 按本机字节序存储, 快照只能在同一种架构上载入
+*/
+
+// 快照对应的缓存策略, 载入时必须与目标缓存一致
+enum class SnapshotPolicy : uint32_t {
+    Lru = 1,
+    Lfu = 2,
+    Arc = 3,
+};
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string& path)
+        : path_(path)
+        , tmpPath_(path + ".tmp")
+        , file_(std::fopen(tmpPath_.c_str(), "wb"))
+        , ok_(file_ != nullptr)
+    {
+        if (file_ != nullptr) {
+            std::setvbuf(file_, nullptr, _IOFBF, kBufferSize);
+        }
+    }
+
+    // 写入内存缓冲区(追加到 buffer 末尾), 用于在文件之外复用 CacheSerializer, 例如 TieredCache 的第二层记录
+    explicit SnapshotWriter(std::vector<char>& buffer)
+        : file_(nullptr)
+        , buffer_(&buffer)
+        , ok_(true)
+    {}
+
+    // 没有 commit() 的快照直接丢弃
+    ~SnapshotWriter() {
+        if (file_ != nullptr) {
+            std::fclose(file_);
+            std::remove(tmpPath_.c_str());
+        }
+    }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    bool ok() const {
+        return ok_;
+    }
+
+    // 写入失败后后续的写入全部忽略, 由 commit() 统一报告
+    void write(const void* data, size_t size) {
+        if (!ok_ || size == 0) return;
+        if (buffer_ != nullptr) {
+            const char* p = static_cast<const char*>(data);
+            buffer_->insert(buffer_->end(), p, p + size);
+            return;
+        }
+        if (std::fwrite(data, size, 1, file_) != 1) {
+            ok_ = false;
+        }
+    }
+
+    template<typename T>
+    void writePod(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "writePod requires a trivially copyable type");
+        write(&value, sizeof(T));
+    }
+
+    void writeHeader(SnapshotPolicy policy, uint64_t entryCount) {
+        write(kMagic, sizeof(kMagic));
+        writePod(kVersion);
+        writePod(static_cast<uint32_t>(policy));
+        writePod(wallClockNanos());
+        writePod(entryCount);
+    }
+
+    // 刷盘并把临时文件改名为目标文件, 成功返回 true
+    bool commit() {
+        if (file_ == nullptr) return false;
+        ok_ = ok_ && std::fflush(file_) == 0;
+        ok_ = (std::fclose(file_) == 0) && ok_;
+        file_ = nullptr;
+        if (ok_) {
+            ok_ = std::rename(tmpPath_.c_str(), path_.c_str()) == 0;
+        }
+        if (!ok_) {
+            std::remove(tmpPath_.c_str());
+        }
+        return ok_;
+    }
+
+    static int64_t wallClockNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    static constexpr char kMagic[8] = {'K', 'C', 'S', 'N', 'A', 'P', '\0', '\1'};
+    static constexpr uint32_t kVersion = 2;    // 2: ARC 的 ghost 列表只保存 key 的指纹
+
+private:
+    static constexpr size_t kBufferSize = 1 << 20;
+
+    std::string path_;
+    std::string tmpPath_;
+    std::FILE* file_;
+    std::vector<char>* buffer_ = nullptr;   // 内存模式的目标缓冲区, 文件模式为空
+    bool ok_;
+};
+
+class SnapshotReader {
+public:
+    explicit SnapshotReader(const std::string& path) {
+#ifdef CACHE_SNAPSHOT_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                ::madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+                data_ = static_cast<const char*>(addr);
+                size_ = static_cast<size_t>(st.st_size);
+                mapped_ = true;
+            }
+        }
+        ::close(fd);
+#else
+        // 没有 mmap 的平台整个读进内存
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) return;
+        char chunk[1 << 16];
+        size_t n;
+        while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            buffer_.insert(buffer_.end(), chunk, chunk + n);
+        }
+        std::fclose(file);
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+#endif
+    }
+
+    // 读取一段内存(不拷贝, 调用方保证读取期间有效)
+    SnapshotReader(const char* data, size_t size)
+        : data_(data)
+        , size_(size)
+    {}
+
+    ~SnapshotReader() {
+#ifdef CACHE_SNAPSHOT_MMAP
+        if (mapped_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+    }
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    bool ok() const {
+        return data_ != nullptr;
+    }
+
+    // 返回当前位置开始的 size 个字节并前进, 剩余不足时返回空(之后的读取全部失败)
+    const char* take(size_t size) {
+        if (data_ == nullptr || size > size_ - pos_) {
+            pos_ = size_;
+            failed_ = true;
+            return nullptr;
+        }
+        const char* p = data_ + pos_;
+        pos_ += size;
+        return p;
+    }
+
+    bool read(void* out, size_t size) {
+        const char* p = take(size);
+        if (p == nullptr) return false;
+        std::memcpy(out, p, size);
+        return true;
+    }
+
+    template<typename T>
+    bool readPod(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "readPod requires a trivially copyable type");
+        return read(&value, sizeof(T));
+    }
+
+    /**
+     * 校验文件头, 成功时返回记录的条目数和从保存到现在经过的墙上时间(纳秒, 时钟回拨时为 0)
+    */
+    bool readHeader(SnapshotPolicy policy, uint64_t& entryCount, uint64_t& elapsedNs) {
+        char magic[sizeof(SnapshotWriter::kMagic)];
+        uint32_t version = 0;
+        uint32_t savedPolicy = 0;
+        int64_t savedAt = 0;
+        if (!read(magic, sizeof(magic)) || !readPod(version) || !readPod(savedPolicy)
+            || !readPod(savedAt) || !readPod(entryCount)) {
+            return false;
+        }
+        if (std::memcmp(magic, SnapshotWriter::kMagic, sizeof(magic)) != 0
+            || version != SnapshotWriter::kVersion || savedPolicy != static_cast<uint32_t>(policy)) {
+            return false;
+        }
+        int64_t now = SnapshotWriter::wallClockNanos();
+        elapsedNs = now > savedAt ? static_cast<uint64_t>(now - savedAt) : 0;
+        return true;
+    }
+
+    bool failed() const {
+        return failed_;
+    }
+
+    bool atEnd() const {
+        return pos_ == size_;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t pos_ = 0;
+    bool mapped_ = false;
+    bool failed_ = false;
+#ifndef CACHE_SNAPSHOT_MMAP
+    std::vector<char> buffer_;
+#endif
+};
+
+/**
+ * key/value 的序列化器: write(out, value) 写入, read(in, value) 读出(失败返回 false)
+ * 默认只支持可平凡拷贝的类型和 std::string, 其他类型需要特化
+*/
+template<typename T, typename = void>
+struct CacheSerializer;
+
+template<typename T>
+struct CacheSerializer<T, std::enable_if_t<std::is_trivially_copyable<T>::value>> {
+    static void write(SnapshotWriter& out, const T& value) {
+        out.writePod(value);
+    }
+
+    static bool read(SnapshotReader& in, T& value) {
+        return in.readPod(value);
+    }
+};
+
+template<>
+struct CacheSerializer<std::string> {
+    static void write(SnapshotWriter& out, const std::string& value) {
+        out.writePod(static_cast<uint64_t>(value.size()));
+        out.write(value.data(), value.size());
+    }
+
+    static bool read(SnapshotReader& in, std::string& value) {
+        uint64_t size = 0;
+        if (!in.readPod(size)) return false;
+        const char* p = in.take(size);
+        if (p == nullptr) return false;
+        value.assign(p, size);
+        return true;
+    }
+};
+
+// 保存时的剩余 TTL(0 表示不过期), 已经到期返回 false, 条目不写入快照
+inline bool snapshotRemainingTtl(uint64_t expireAt, uint64_t now, uint64_t& remaining) {
+    remaining = 0;
+    if (expireAt == 0) return true;
+    if (expireAt <= now) return false;
+    remaining = expireAt - now;
+    return true;
+}
+
+// 载入时的绝对过期时间(0 表示不过期), 扣除停机时间后已经到期返回 false, 条目跳过
+inline bool snapshotRestoreExpireAt(uint64_t remaining, uint64_t elapsed, uint64_t now, uint64_t& expireAt) {
+    expireAt = 0;
+    if (remaining == 0) return true;
+    if (remaining <= elapsed) return false;
+    expireAt = now + (remaining - elapsed);
+    return true;
+}
+
+} // namespace Cache
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "CacheLock.h"
+
+// 编译期开关: 定义 CACHE_ENABLE_STATS=0 后所有计数器都变成空操作
+#ifndef CACHE_ENABLE_STATS
+#define CACHE_ENABLE_STATS 1
+#endif
+
+namespace Cache {
+
+/**
+ * 统计快照, 读取时由各缓存(各分片)的计数器汇总而成
+ * ARC 相关的字段只有 ARC 系列以及复用它们表示两个分段的 SLRU/2Q 会填写
+*/
+struct CacheStatsSnapshot {
+    uint64_t hits = 0;              // 命中次数
+    uint64_t misses = 0;            // 未命中次数
+    uint64_t inserts = 0;           // 新插入的条目数
+    uint64_t evictions = 0;         // 因容量不足被淘汰的条目数
+    uint64_t rejections = 0;        // TinyLFU: 准入过滤拒绝的新条目数
+    uint64_t expirations = 0;       // 因 TTL 到期被回收的条目数
+    uint64_t lruGhostHits = 0;      // ARC: LRU部分 ghost 命中 (B1)
+    uint64_t lfuGhostHits = 0;      // ARC: LFU部分 ghost 命中 (B2)
+    uint64_t lockWaitNs = 0;        // 等锁的总时间(只统计发生竞争的加锁)
+    size_t size = 0;                // 当前条目数
+    size_t weight = 0;              // 当前总权重(未设置权重函数时等于条目数)
+    size_t lruPartCapacity = 0;     // ARC: T1 容量
+    size_t lfuPartCapacity = 0;     // ARC: T2 容量
+    size_t lruPartSize = 0;         // ARC: T1 条目数
+    size_t lfuPartSize = 0;         // ARC: T2 条目数
+    size_t lruGhostSize = 0;        // ARC: B1 条目数
+    size_t lfuGhostSize = 0;        // ARC: B2 条目数
+
+    CacheStatsSnapshot& operator+=(const CacheStatsSnapshot& other) {
+        hits += other.hits;
+        misses += other.misses;
+        inserts += other.inserts;
+        evictions += other.evictions;
+        rejections += other.rejections;
+        expirations += other.expirations;
+        lruGhostHits += other.lruGhostHits;
+        lfuGhostHits += other.lfuGhostHits;
+        lockWaitNs += other.lockWaitNs;
+        size += other.size;
+        weight += other.weight;
+        lruPartCapacity += other.lruPartCapacity;
+        lfuPartCapacity += other.lfuPartCapacity;
+        lruPartSize += other.lruPartSize;
+        lfuPartSize += other.lfuPartSize;
+        lruGhostSize += other.lruGhostSize;
+        lfuGhostSize += other.lfuGhostSize;
+        return *this;
+    }
+
+    double hitRate() const {
+        uint64_t total = hits + misses;
+        return total == 0 ? 0.0 : static_cast<double>(hits) / total;
+    }
+};
+
+/**
+ * 热路径计数器
+ * · add(): 只允许在缓存(分片)的锁内调用, 写者已经被锁串行化, 用 relaxed 的 load + store 代替原子加,
+ *   在 x86 上就是普通的读写指令, 没有总线锁
+ * · addShared(): 可能被多个线程同时调用的场景(共享锁内, 或者锁外), 使用 relaxed 原子加
+ * · load(): 任意线程随时读取, 不需要持有锁; reset(): 任意线程清零
+*/
+class StatCounter {
+public:
+    void add(uint64_t n = 1) {
+#if CACHE_ENABLE_STATS
+        value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+#else
+        (void)n;
+#endif
+    }
+
+    void addShared(uint64_t n = 1) {
+#if CACHE_ENABLE_STATS
+        value_.fetch_add(n, std::memory_order_relaxed);
+#else
+        (void)n;
+#endif
+    }
+
+    uint64_t load() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+    // 清零, 用于按周期统计的场合(例如 CacheMissRatioCurve::resetCounters())
+    void reset() {
+        value_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+// 单个缓存(单个分片)的计数器集合
+struct CacheStats {
+    StatCounter hits;
+    StatCounter misses;
+    StatCounter inserts;
+    StatCounter evictions;
+    StatCounter rejections;
+    StatCounter expirations;
+    StatCounter lruGhostHits;
+    StatCounter lfuGhostHits;
+    StatCounter lockWaitNs;
+
+    // 把计数器的值累加进快照
+    void addTo(CacheStatsSnapshot& snapshot) const {
+        snapshot.hits += hits.load();
+        snapshot.misses += misses.load();
+        snapshot.inserts += inserts.load();
+        snapshot.evictions += evictions.load();
+        snapshot.rejections += rejections.load();
+        snapshot.expirations += expirations.load();
+        snapshot.lruGhostHits += lruGhostHits.load();
+        snapshot.lfuGhostHits += lfuGhostHits.load();
+        snapshot.lockWaitNs += lockWaitNs.load();
+    }
+};
+
+/**
+ * 带等锁时间统计的 lock_guard
+ * 先 try_lock, 成功就不读时钟; 失败说明发生了竞争, 才计时并阻塞加锁
+ * 因此无竞争时的开销和 std::lock_guard 相同
+*/
+template<typename Mutex>
+class StatsLockGuard {
+public:
+    StatsLockGuard(Mutex& mutex, StatCounter& waitNs): mutex_(mutex) {
+#if CACHE_ENABLE_STATS
+        if (!mutex_.try_lock()) {
+            auto begin = std::chrono::steady_clock::now();
+            mutex_.lock();
+            waitNs.addShared(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin).count()));
+        }
+#else
+        (void)waitNs;
+        mutex_.lock();
+#endif
+    }
+
+    ~StatsLockGuard() {
+        mutex_.unlock();
+    }
+
+    StatsLockGuard(const StatsLockGuard&) = delete;
+    StatsLockGuard& operator=(const StatsLockGuard&) = delete;
+
+private:
+    Mutex& mutex_;
+};
+
+// 共享锁版本, 用于读写锁的读路径; SharedMutex 不支持共享锁(例如 SpinLock)时退化为独占锁
+template<typename SharedMutex>
+class StatsSharedLockGuard {
+public:
+    StatsSharedLockGuard(SharedMutex& mutex, StatCounter& waitNs): mutex_(mutex) {
+#if CACHE_ENABLE_STATS
+        if (!tryLock()) {
+            auto begin = std::chrono::steady_clock::now();
+            lock();
+            waitNs.addShared(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin).count()));
+        }
+#else
+        (void)waitNs;
+        lock();
+#endif
+    }
+
+    ~StatsSharedLockGuard() {
+        if constexpr (IsSharedMutex<SharedMutex>::value) {
+            mutex_.unlock_shared();
+        }
+        else {
+            mutex_.unlock();
+        }
+    }
+
+    StatsSharedLockGuard(const StatsSharedLockGuard&) = delete;
+    StatsSharedLockGuard& operator=(const StatsSharedLockGuard&) = delete;
+
+private:
+    bool tryLock() {
+        if constexpr (IsSharedMutex<SharedMutex>::value) {
+            return mutex_.try_lock_shared();
+        }
+        else {
+            return mutex_.try_lock();
+        }
+    }
+
+    void lock() {
+        if constexpr (IsSharedMutex<SharedMutex>::value) {
+            mutex_.lock_shared();
+        }
+        else {
+            mutex_.lock();
+        }
+    }
+
+    SharedMutex& mutex_;
+};
+
+} // namespace Cache
@@ -1,19 +1,214 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "CacheStats.h"
+#include "CacheHash.h"
+#include "CacheLoader.h"
+
 namespace Cache {
 
+/**
+ * 共享的只读值句柄
+ * 大对象(例如几KB的 blob)可以用 CacheStrategy<Key, SharedValue<Blob>> 缓存,
+ * get() 时锁内只拷贝一个 shared_ptr(引用计数加一), 不拷贝对象本身; 值不可修改, 读者可以在锁外安全使用
+*/
+template<typename T>
+using SharedValue = std::shared_ptr<const T>;
+
+template<typename T, typename... Args>
+SharedValue<T> makeSharedValue(Args&&... args) {
+    return std::make_shared<const T>(std::forward<Args>(args)...);
+}
+
+/**
+ * 权重函数: 返回一个条目占用的权重(例如 value 的字节数, 或者任意代价), 缓存容量即为总权重预算
+ * 不设置时每个条目的权重为 1, 容量就是条目数; 权重至少按 1 计
+*/
+template<typename Key, typename Value>
+using CacheWeigher = std::function<size_t(const Key&, const Value&)>;
+
+/**
+ * 淘汰监听器: 条目因容量不足被淘汰时调用 listener(key, value, expireAt), expireAt 为绝对过期时间(0 表示不过期)
+ * 在缓存的锁内、旧值释放之前调用, 只应做很轻的工作(例如写入第二层存储, 见 TieredCache); 到期回收和显式删除不会触发
+*/
+template<typename Key, typename Value>
+using CacheEvictionListener = std::function<void(const Key&, const Value&, uint64_t)>;
+
 template<typename Key, typename Value>
 class CacheStrategy{
 public:
-    virtual ~CacheStrategy() {};
+    using KeyType = Key;
+    using ValueType = Value;
+
+    virtual ~CacheStrategy() {
+        delete loadGroup_.load(std::memory_order_acquire);
+    };
 
     // 添加缓存接口
-    virtual void put(Key key, Value value) = 0;
+    virtual void put(const Key& key, const Value& value) = 0;
+    // 右值版本, 值直接移动进缓存节点; 默认实现退化为拷贝
+    virtual void put(const Key& key, Value&& value) {
+        put(key, static_cast<const Value&>(value));
+    }
+
+    // 原地构造值再插入, 省去调用方构造临时对象再拷贝; 派生类可以提供直接在节点里构造的版本
+    template<typename... Args>
+    void emplace(const Key& key, Args&&... args) {
+        put(key, Value(std::forward<Args>(args)...));
+    }
 
     // key是传入的参数 访问到的值以传出参数的形式返回|访问成功返回true
-    virtual bool get(Key key, Value& value) = 0;
+    virtual bool get(const Key& key, Value& value) = 0;
     // 如果缓存中能找到key, 则直接返回value
-    virtual Value get(Key key) = 0;
+    virtual Value get(const Key& key) = 0;
+
+    // 删除 key, key 不在缓存中时什么也不做; 不触发淘汰监听器. 默认实现为空, 各缓存实现会覆盖
+    virtual void remove(const Key& key) {
+        (void)key;
+    }
+
+    // key 是否在缓存中; 默认实现借助 get(), 会计入统计并调整访问顺序, 各缓存实现会覆盖为只查索引的版本
+    virtual bool contains(const Key& key) {
+        Value value{};
+        return get(key, value);
+    }
+
+    /**
+     * 批量查找: values/found 会被调整为与 keys 等长, keys[i] 命中时写入 values[i] 并置 found[i] 为 true
+     * 返回命中个数; 默认实现逐个调用 get(), 各缓存实现会在整批内只加一次锁
+    */
+    virtual size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        size_t hits = 0;
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (get(keys[i], values[i])) {
+                found[i] = true;
+                hits++;
+            }
+        }
+        return hits;
+    }
+
+    // 批量添加: 按 keys 和 values 中较短的长度, 依次 put(keys[i], values[i])
+    virtual void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) {
+        size_t count = std::min(keys.size(), values.size());
+        for (size_t i = 0; i < count; i++) {
+            put(keys[i], values[i]);
+        }
+    }
+
+    /**
+     * 读穿透: 命中直接返回; 未命中时调用 loader(key, value) 从后端加载, 加载成功(返回 true)的值写入缓存
+     * 同一个 key 并发未命中时只有一个线程调用 loader, 其余线程等待它的结果(见 LoadCoalescer)
+     * loader 返回 false 表示后端没有数据, 不缓存, getOrLoad() 也返回 false; loader 抛出的异常传给所有等待者
+    */
+    template<typename Loader>
+    bool getOrLoad(const Key& key, Value& value, Loader&& loader) {
+        if (get(key, value)) return true;
+        std::optional<Value> result = loadGroup().run(key, [&]() -> std::optional<Value> {
+            Value loaded{};
+            if (!loader(key, loaded)) return std::nullopt;
+            put(key, loaded);
+            return std::optional<Value>(std::move(loaded));
+        });
+        if (!result) return false;
+        value = std::move(*result);
+        return true;
+    }
+
+    // loader(key) 直接返回值的版本, 加载结果总是写入缓存
+    template<typename Loader>
+    Value getOrLoad(const Key& key, Loader&& loader) {
+        Value value{};
+        getOrLoad(key, value, [&](const Key& k, Value& out) {
+            out = loader(k);
+            return true;
+        });
+        return value;
+    }
+
+    /**
+     * 异步读穿透: loader(key) 发起加载并返回一个 future, 其 get() 得到 Value 或者 std::optional<Value>(nullopt 表示没有数据)
+     * 命中时返回已经就绪的 future; 未命中时不阻塞, 同一个 key 的并发调用拿到同一个 future,
+     * 结果就绪时由完成线程写入缓存, 不需要有人等待 future(可以用于只预取不读取)
+     * 缓存析构时还没有完成的加载不再写回, 它们的 future 以 std::future_error(broken_promise) 结束
+    */
+    template<typename Loader>
+    std::shared_future<std::optional<Value>> getOrLoadAsync(const Key& key, Loader&& loader) {
+        Value value{};
+        if (get(key, value)) {
+            std::promise<std::optional<Value>> ready;
+            ready.set_value(std::move(value));
+            return ready.get_future().share();
+        }
+        return loadGroup().runAsync(key,
+            [&]() { return loader(key); },
+            [this, key](const std::optional<Value>& result) {
+                if (result) put(key, *result);
+            });
+    }
+
+    // 统计信息快照(命中/未命中/插入/淘汰/ghost命中/分区大小/等锁时间), 不支持统计的实现返回全零
+    virtual CacheStatsSnapshot getStats() { return CacheStatsSnapshot(); }
+
+protected:
+    /**
+     * 停止异步加载的写回(见 LoadCoalescer::cancelLoads()), 返回后完成线程不会再调用 put()
+     * 缓存实现必须在自己的析构函数开头调用: 基类析构时派生类的成员已经析构, 这时再写回就是访问已经销毁的对象
+     * 继承链上的每一层都调用, 最外层的先生效, 重复调用没有影响
+    */
+    void cancelLoads() {
+        LoadCoalescer<Key, Value>* group = loadGroup_.load(std::memory_order_acquire);
+        if (group != nullptr) {
+            group->cancelLoads();
+        }
+    }
+
+    /**
+     * 合并加载的登记表改用 Hash: 带 Hash 模板参数的缓存在构造函数里调用, 自定义 key 类型不需要 std::hash
+     * 没有调用时使用 CacheHash<Key>; CacheHash<Key> 也不可用时登记表退化为单个桶, 结果正确但并发加载会互相等锁
+    */
+    template<typename Hash>
+    void useLoadHash() {
+        loadHash_ = [](const Key& key) { return static_cast<size_t>(cacheHashOf(Hash(), key)); };
+    }
+
+private:
+    // 合并加载的登记表, 第一次未命中加载时才创建, 不使用 getOrLoad() 的缓存没有额外开销
+    LoadCoalescer<Key, Value>& loadGroup() {
+        LoadCoalescer<Key, Value>* group = loadGroup_.load(std::memory_order_acquire);
+        if (group == nullptr) {
+            typename LoadCoalescer<Key, Value>::HashFunction hash = loadHash_;
+            if (hash == nullptr) {
+                if constexpr (HasCacheHash<Key>::value) {
+                    hash = [](const Key& key) { return static_cast<size_t>(cacheHashOf(CacheHash<Key>(), key)); };
+                }
+                else {
+                    hash = [](const Key&) { return size_t(0); };
+                }
+            }
+            auto created = std::make_unique<LoadCoalescer<Key, Value>>(hash);
+            if (loadGroup_.compare_exchange_strong(group, created.get(), std::memory_order_acq_rel)) {
+                group = created.release();
+            }
+        }
+        return *group;
+    }
+
+private:
+    std::atomic<LoadCoalescer<Key, Value>*> loadGroup_{nullptr};
+    typename LoadCoalescer<Key, Value>::HashFunction loadHash_ = nullptr;    // 为空时使用 CacheHash<Key>
 };
 
 }// namespace Cache
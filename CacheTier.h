@@ -0,0 +1,399 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CacheFlatIndex.h"
+#include "CacheHash.h"
+#include "CacheSnapshot.h"
+#include "CacheStrategy.h"
+#include "CacheTimerWheel.h"
+
+namespace Cache {
+
+// 第二层存储的统计
+struct TierStats {
+    size_t entries = 0;         // 当前有效的条目数
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t writes = 0;        // 写入的记录数(包括覆盖)
+    uint64_t rejected = 0;      // 超过一个段大小、没有写入的记录数
+    uint64_t reclaimed = 0;     // 段被循环复用时丢弃的有效记录数
+};
+
+/**
+ * 日志结构的第二层存储: 一个内存映射文件, 按段循环追加写入
+ * 1. 文件分成若干个固定大小的段, 记录(头部 + key + value)只在当前段的末尾追加, 写满后切换到下一个段;
+ *    下一个段里的旧记录整体作废(FIFO), 没有随机写和碎片整理, 适合 SSD
+ * 2. 索引只放在内存里, 每个条目 16 字节: key 哈希值 + 记录偏移, 不保存 key 本身;
+ *    读取时用记录里的 key 校验, 哈希值相同的另一个 key 写入时直接覆盖(缓存语义, 只会丢一条记录)
+ * 3. 覆盖写入追加新记录并更新索引, 旧记录留在原地, 段被复用时回收
+ * 4. 文件创建后即被删除(unlink), 只在进程内有效, 进程退出后空间自动释放; 页面由内核按需写回磁盘
+ * key/value 的编码复用 CacheSerializer, 记录大小不能超过一个段; 所有操作由一把锁保护
+*/
+template<typename Key, typename Value,
+         typename KeySerializer = CacheSerializer<Key>,
+         typename ValueSerializer = CacheSerializer<Value>>
+class LogStructuredTier {
+public:
+    static constexpr size_t kDefaultSegmentBytes = 4 << 20;
+
+    LogStructuredTier(const std::string& path, size_t capacityBytes, size_t segmentBytes = kDefaultSegmentBytes) {
+        segmentBytes_ = alignUp(std::max<size_t>(kHeaderBytes * 2, std::min(segmentBytes, capacityBytes)));
+        segmentCount_ = std::max<size_t>(1, capacityBytes / segmentBytes_);
+        mapBytes_ = segmentBytes_ * segmentCount_;
+        segmentUsed_.assign(segmentCount_, 0);
+        map(path);
+    }
+
+    ~LogStructuredTier() {
+        unmap();
+    }
+
+    LogStructuredTier(const LogStructuredTier&) = delete;
+    LogStructuredTier& operator=(const LogStructuredTier&) = delete;
+
+    // 文件创建或映射失败时为 false, 此时所有写入被忽略, 读取都未命中
+    bool ok() const {
+        return data_ != nullptr;
+    }
+
+    // 写入一条记录, expireAt 为绝对过期时间(0 表示不过期); 已经到期或者超过一个段大小时返回 false
+    bool put(const Key& key, const Value& value, uint64_t expireAt) {
+        if (expireAt != 0 && expireAt <= cacheNowNanos()) return false;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (data_ == nullptr) return false;
+        scratch_.assign(kHeaderBytes, 0);
+        SnapshotWriter out(scratch_);
+        KeySerializer::write(out, key);
+        size_t keyBytes = scratch_.size() - kHeaderBytes;
+        ValueSerializer::write(out, value);
+        size_t recordBytes = alignUp(scratch_.size());
+        if (recordBytes > segmentBytes_ || keyBytes > UINT32_MAX) {
+            stats_.rejected++;
+            return false;
+        }
+
+        RecordHeader header;
+        header.size = static_cast<uint32_t>(recordBytes);
+        header.keyBytes = static_cast<uint32_t>(keyBytes);
+        header.hash = hashOf(key);
+        header.expireAt = expireAt;
+        std::memcpy(scratch_.data(), &header, sizeof(header));
+
+        uint64_t offset = allocate(recordBytes);
+        std::memcpy(data_ + offset, scratch_.data(), scratch_.size());
+        index_.insert(header.hash, offset);
+        stats_.writes++;
+        return true;
+    }
+
+    // 读出 key 的值和过期时间, 不存在或者已经到期返回 false
+    bool get(const Key& key, Value& value, uint64_t& expireAt) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return readLocked(key, value, expireAt, false);
+    }
+
+    // 读出并删除, 用于把条目提升回内存层
+    bool take(const Key& key, Value& value, uint64_t& expireAt) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return readLocked(key, value, expireAt, true);
+    }
+
+    void erase(const Key& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t offset = 0;
+        size_t hash = hashOf(key);
+        if (index_.find(hash, offset) && matches(offset, key)) {
+            index_.erase(hash);
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        index_.clear();
+        std::fill(segmentUsed_.begin(), segmentUsed_.end(), 0);
+        current_ = 0;
+    }
+
+    // 文件的总大小(段大小 * 段数)
+    size_t capacityBytes() const {
+        return mapBytes_;
+    }
+
+    TierStats getStats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        TierStats stats = stats_;
+        stats.entries = index_.size();
+        return stats;
+    }
+
+private:
+    struct RecordHeader {
+        uint32_t size;          // 整条记录的字节数(按 8 字节对齐), 0 表示段在此结束
+        uint32_t keyBytes;      // 编码后的 key 字节数, value 紧跟其后
+        uint64_t hash;
+        uint64_t expireAt;
+    };
+
+    static constexpr size_t kHeaderBytes = sizeof(RecordHeader);
+
+    static size_t alignUp(size_t size) {
+        return (size + 7) & ~static_cast<size_t>(7);
+    }
+
+    static uint64_t hashOf(const Key& key) {
+        return static_cast<uint64_t>(cacheHashOf(CacheHash<Key>(), key));
+    }
+
+    RecordHeader headerAt(uint64_t offset) const {
+        RecordHeader header;
+        std::memcpy(&header, data_ + offset, sizeof(header));
+        return header;
+    }
+
+    // offset 处的记录是否属于 key(哈希值相同的不同 key 也会指向这里)
+    bool matches(uint64_t offset, const Key& key) const {
+        RecordHeader header = headerAt(offset);
+        SnapshotReader in(data_ + offset + kHeaderBytes, header.keyBytes);
+        Key stored{};
+        return KeySerializer::read(in, stored) && stored == key;
+    }
+
+    bool readLocked(const Key& key, Value& value, uint64_t& expireAt, bool erase) {
+        uint64_t offset = 0;
+        size_t hash = hashOf(key);
+        if (data_ == nullptr || !index_.find(hash, offset) || !matches(offset, key)) {
+            stats_.misses++;
+            return false;
+        }
+        RecordHeader header = headerAt(offset);
+        if (header.expireAt != 0 && header.expireAt <= cacheNowNanos()) {
+            index_.erase(hash);
+            stats_.misses++;
+            return false;
+        }
+        SnapshotReader in(data_ + offset + kHeaderBytes + header.keyBytes, header.size - kHeaderBytes - header.keyBytes);
+        if (!ValueSerializer::read(in, value)) {
+            index_.erase(hash);
+            stats_.misses++;
+            return false;
+        }
+        expireAt = header.expireAt;
+        if (erase) index_.erase(hash);
+        stats_.hits++;
+        return true;
+    }
+
+    // 在当前段末尾分配 size 字节, 放不下时切换到下一个段并作废其中的旧记录
+    uint64_t allocate(size_t size) {
+        if (segmentUsed_[current_] + size > segmentBytes_) {
+            uint64_t end = current_ * segmentBytes_ + segmentUsed_[current_];
+            if (segmentUsed_[current_] + kHeaderBytes <= segmentBytes_) {
+                RecordHeader terminator{};
+                std::memcpy(data_ + end, &terminator, sizeof(terminator));
+            }
+            current_ = (current_ + 1) % segmentCount_;
+            reclaim(current_);
+        }
+        uint64_t offset = current_ * segmentBytes_ + segmentUsed_[current_];
+        segmentUsed_[current_] += size;
+        return offset;
+    }
+
+    // 逐条扫描将被复用的段, 仍被索引引用的记录从索引中删除
+    void reclaim(size_t segment) {
+        uint64_t begin = segment * segmentBytes_;
+        uint64_t end = begin + segmentUsed_[segment];
+        for (uint64_t offset = begin; offset + kHeaderBytes <= end;) {
+            RecordHeader header = headerAt(offset);
+            if (header.size == 0) break;
+            uint64_t indexed = 0;
+            if (index_.find(header.hash, indexed) && indexed == offset) {
+                index_.erase(header.hash);
+                stats_.reclaimed++;
+            }
+            offset += header.size;
+        }
+        segmentUsed_[segment] = 0;
+    }
+
+    void map(const std::string& path) {
+#ifdef CACHE_SNAPSHOT_MMAP
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0) return;
+        if (::ftruncate(fd, static_cast<off_t>(mapBytes_)) == 0) {
+            void* addr = ::mmap(nullptr, mapBytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (addr != MAP_FAILED) {
+                ::madvise(addr, mapBytes_, MADV_RANDOM);
+                data_ = static_cast<char*>(addr);
+            }
+        }
+        ::close(fd);
+        ::unlink(path.c_str());
+#else
+        // 没有 mmap 的平台退化为进程内的内存缓冲区
+        (void)path;
+        buffer_.reset(new char[mapBytes_]);
+        data_ = buffer_.get();
+#endif
+    }
+
+    void unmap() {
+#ifdef CACHE_SNAPSHOT_MMAP
+        if (data_ != nullptr) {
+            ::munmap(data_, mapBytes_);
+        }
+#endif
+        data_ = nullptr;
+    }
+
+private:
+    size_t segmentBytes_ = 0;
+    size_t segmentCount_ = 0;
+    size_t mapBytes_ = 0;
+    char* data_ = nullptr;              // 映射的文件内容
+    size_t current_ = 0;                // 正在追加写入的段
+    std::vector<size_t> segmentUsed_;   // 每个段已经写入的字节数
+    FingerprintIndex index_;        // key 哈希值 -> 记录偏移
+    std::vector<char> scratch_;         // 编码记录用的缓冲区, 在锁内复用
+    TierStats stats_;
+    std::mutex mutex_;
+#ifndef CACHE_SNAPSHOT_MMAP
+    std::unique_ptr<char[]> buffer_;
+#endif
+};
+
+/**
+ * 两层缓存: 内存中的缓存策略在前, LogStructuredTier 在后
+ * 1. 前一层因容量不足淘汰的条目通过淘汰监听器写入第二层(到期的不写), 过期时间一并保存
+ * 2. get() 前一层未命中时查第二层, 命中的条目从第二层取出并以剩余的 TTL 提升回前一层, 两层之间不重复保存
+ * 3. put() 先写入前一层再作废第二层里的旧值: 旧值一旦被新值覆盖就不会再被淘汰进第二层,
+ *    写入之前被淘汰进去的旧值由随后的作废删除, 提升不会读到比前一层更旧的值;
+ *    代价是新值恰好在两步之间被淘汰时会连同第二层的记录一起丢掉(只多一次未命中)
+ * 4. remove() 同时删除两层中的 key; 同一个 key 的提升、写入和删除用条带锁串行, 提升不会覆盖更新的值
+ * 5. getOrLoad() 两层都未命中时才调用 loader, 并发未命中按前一层的合并加载处理
+ * CacheType 需要提供 setEvictionListener、remove 和带 TTL 的 put(): LruCache/LfuCache/ArcCache 以及对应的 Hash* 分片缓存;
+ * 写入和删除应当都经过 TieredCache, 直接写前一层不会作废第二层里的旧值; 前一层必须比它活得久
+*/
+template<typename CacheType,
+         typename KeySerializer = CacheSerializer<typename CacheType::KeyType>,
+         typename ValueSerializer = CacheSerializer<typename CacheType::ValueType>>
+class TieredCache {
+public:
+    using Key = typename CacheType::KeyType;
+    using Value = typename CacheType::ValueType;
+    using Tier = LogStructuredTier<Key, Value, KeySerializer, ValueSerializer>;
+
+    TieredCache(CacheType& front, const std::string& path, size_t tierBytes,
+                size_t segmentBytes = Tier::kDefaultSegmentBytes)
+        : front_(front)
+        , tier_(path, tierBytes, segmentBytes)
+        , stripes_(new Stripe[kStripeCount])
+    {
+        if (tier_.ok()) {
+            front_.setEvictionListener([this](const Key& key, const Value& value, uint64_t expireAt) {
+                tier_.put(key, value, expireAt);
+            });
+        }
+    }
+
+    ~TieredCache() {
+        front_.setEvictionListener(nullptr);
+    }
+
+    TieredCache(const TieredCache&) = delete;
+    TieredCache& operator=(const TieredCache&) = delete;
+
+    // 第二层是否可用; 不可用时退化为只有前一层
+    bool ok() const {
+        return tier_.ok();
+    }
+
+    void put(const Key& key, const Value& value) {
+        std::lock_guard<std::mutex> lock(stripeOf(key));
+        front_.put(key, value);
+        tier_.erase(key);
+    }
+
+    void put(const Key& key, const Value& value, std::chrono::nanoseconds ttl) {
+        std::lock_guard<std::mutex> lock(stripeOf(key));
+        front_.put(key, value, ttl);
+        tier_.erase(key);
+    }
+
+    // 从两层中删除 key; 先删前一层, 删除之前被淘汰进第二层的值随后一并删除
+    void remove(const Key& key) {
+        std::lock_guard<std::mutex> lock(stripeOf(key));
+        front_.remove(key);
+        tier_.erase(key);
+    }
+
+    bool get(const Key& key, Value& value) {
+        if (front_.get(key, value)) return true;
+        return promote(key, value);
+    }
+
+    Value get(const Key& key) {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 两层都未命中时调用 loader(key, value) 加载, 见 CacheStrategy::getOrLoad
+    template<typename Loader>
+    bool getOrLoad(const Key& key, Value& value, Loader&& loader) {
+        if (get(key, value)) return true;
+        return front_.getOrLoad(key, value, std::forward<Loader>(loader));
+    }
+
+    CacheType& front() {
+        return front_;
+    }
+
+    Tier& tier() {
+        return tier_;
+    }
+
+private:
+    static constexpr size_t kStripeCount = 16;
+
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+    };
+
+    std::mutex& stripeOf(const Key& key) {
+        return stripes_[cacheShardOf(cacheHashOf(CacheHash<Key>(), key), kStripeCount)].mutex;
+    }
+
+    // 从第二层取出并写回前一层; 持有条带锁后先再查一次前一层, 其他线程可能刚刚提升或写入过
+    bool promote(const Key& key, Value& value) {
+        if (!tier_.ok()) return false;
+        std::lock_guard<std::mutex> lock(stripeOf(key));
+        if (front_.get(key, value)) return true;
+        uint64_t expireAt = 0;
+        if (!tier_.take(key, value, expireAt)) return false;
+        if (expireAt == 0) {
+            front_.put(key, value);
+            return true;
+        }
+        uint64_t now = cacheNowNanos();
+        if (expireAt <= now) return false;
+        front_.put(key, value, std::chrono::nanoseconds(expireAt - now));
+        return true;
+    }
+
+private:
+    CacheType& front_;
+    Tier tier_;
+    std::unique_ptr<Stripe[]> stripes_;
+};
+
+} // namespace Cache
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Cache {
+
+// 过期时间统一用 steady_clock 的纳秒数表示, 0 表示永不过期
+inline uint64_t cacheNowNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// 把 ttl 换算成绝对过期时间, ttl 不为正时按 1 纳秒计(下一次访问就已过期)
+inline uint64_t cacheExpireAt(std::chrono::nanoseconds ttl) {
+    return cacheNowNanos() + static_cast<uint64_t>(ttl.count() > 0 ? ttl.count() : 1);
+}
+
+/**
+ * 定时轮中的条目, 缓存节点继承它即可被定时轮管理
+ * 指针由定时轮维护, 未调度时两个指针都为空
+ * readSinceWrite_ 记录上次写入之后是否被读过, 提前刷新只刷新读过的条目; 读路径可能只持有共享锁, 所以是原子的
+*/
+struct TimerEntry {
+    uint64_t expireAt_ = 0;             // 绝对过期时间, 0 表示永不过期
+    TimerEntry* timerPrev_ = nullptr;
+    TimerEntry* timerNext_ = nullptr;
+    std::atomic<bool> readSinceWrite_{false};
+
+    bool isExpired(uint64_t now) const {
+        return expireAt_ != 0 && expireAt_ <= now;
+    }
+
+    // 命中时调用, 共享锁内也可以调用; 不过期的条目不会被刷新, 不写节点
+    void markRead() {
+        if (expireAt_ != 0 && !readSinceWrite_.load(std::memory_order_relaxed)) {
+            readSinceWrite_.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // 写入(put 或刷新写回)时调用, 调用方持有独占锁
+    void markWritten() {
+        readSinceWrite_.store(false, std::memory_order_relaxed);
+    }
+
+    bool readSinceWrite() const {
+        return readSinceWrite_.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * 分层定时轮 (Varghese & Lauck "Hashed and Hierarchical Timing Wheels")
+ * 1. 共 5 层, 每层 64 个槽, 第 i 层一个槽的跨度是 2^kShifts[i] 纳秒:
+ *    约 1ms / 67ms / 4.3s / 4.6min / 4.9h, 最上层一圈约 13 天
+ * 2. 条目按距离过期的时间放进能容纳它的最低一层, 每个槽是侵入式双向循环链表, 调度和取消都是 O(1)
+ * 3. advance(now) 只处理时间推进跨过的槽: 已经过期的条目交给回调, 未过期的重新调度到更低的层,
+ *    每个条目最多下沉 5 次, 均摊每个过期条目 O(1), 不需要扫描整个缓存
+ * 4. 回收最多比过期时间晚最低层的一个槽(约 1ms, 前提是缓存持续有访问),
+ *    缓存在读取时还会用 isExpired() 精确判断, 不会读到过期数据
+ * 本身不加锁, 由所属缓存的锁保护
+*/
+class TimerWheel {
+public:
+    TimerWheel(): time_(cacheNowNanos()), size_(0) {
+        clear();
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // 调度一个条目, 条目必须有过期时间且当前未被调度
+    void schedule(TimerEntry* entry) {
+        link(findSlot(entry->expireAt_), entry);
+        size_++;
+    }
+
+    // 取消调度, 未被调度的条目直接忽略
+    void deschedule(TimerEntry* entry) {
+        if (entry->timerNext_ == nullptr) return;
+        unlink(entry);
+        size_--;
+    }
+
+    // 过期时间改变后重新调度, expireAt 为 0 时只取消调度
+    void reschedule(TimerEntry* entry, uint64_t expireAt) {
+        deschedule(entry);
+        entry->expireAt_ = expireAt;
+        if (expireAt != 0) schedule(entry);
+    }
+
+    /**
+     * 推进到 now, 对每个已经过期的条目调用 onExpire(entry)
+     * 回调被调用时条目已经从定时轮中移除, 回调可以直接释放它
+    */
+    template<typename OnExpire>
+    void advance(uint64_t now, OnExpire&& onExpire) {
+        if (now <= time_) return;
+        uint64_t previous = time_;
+        time_ = now;
+        for (int level = 0; level < kLevels; level++) {
+            uint64_t previousTicks = previous >> kShifts[level];
+            uint64_t currentTicks = now >> kShifts[level];
+            if (currentTicks == previousTicks) break;
+            expireLevel(level, previousTicks, currentTicks - previousTicks, now, onExpire);
+        }
+    }
+
+    /**
+     * 对每个在 deadline 之前(含)到期、还没有被回收的条目调用 func(entry), 不修改定时轮
+     * 每层只遍历 [上次推进的时间, deadline] 覆盖的槽(超过一圈时遍历整层), 用于提前刷新即将到期的条目
+    */
+    template<typename Func>
+    void forEachExpiringBefore(uint64_t deadline, Func&& func) {
+        if (size_ == 0) return;
+        for (int level = 0; level < kLevels; level++) {
+            uint64_t from = time_ >> kShifts[level];
+            uint64_t to = (deadline > time_ ? deadline : time_) >> kShifts[level];
+            uint64_t count = to - from + 1 < kSlots ? to - from + 1 : kSlots;
+            for (uint64_t i = 0; i < count; i++) {
+                TimerEntry& head = wheel_[level][(from + i) & (kSlots - 1)];
+                for (TimerEntry* entry = head.timerNext_; entry != &head; entry = entry->timerNext_) {
+                    if (entry->expireAt_ <= deadline) func(entry);
+                }
+            }
+        }
+    }
+
+    // 清空所有槽, 用于缓存整体清空时(条目本身由缓存直接释放)
+    void clear() {
+        for (auto& level: wheel_) {
+            for (TimerEntry& head: level) {
+                head.timerPrev_ = &head;
+                head.timerNext_ = &head;
+            }
+        }
+        size_ = 0;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+private:
+    static constexpr int kLevels = 5;
+    static constexpr uint64_t kSlots = 64;
+    static constexpr int kShifts[kLevels] = {20, 26, 32, 38, 44};
+
+    // 处理第 level 层从 previousTicks 开始的 delta 个槽(超过一圈就处理整层)
+    template<typename OnExpire>
+    void expireLevel(int level, uint64_t previousTicks, uint64_t delta, uint64_t now, OnExpire& onExpire) {
+        uint64_t count = delta < kSlots ? delta : kSlots;
+        for (uint64_t i = 0; i < count; i++) {
+            TimerEntry& head = wheel_[level][(previousTicks + i) & (kSlots - 1)];
+            if (head.timerNext_ == &head) continue;
+            // 先把整个槽摘下来再逐个处理, 重新调度的条目可能落回同一个槽
+            TimerEntry* entry = head.timerNext_;
+            head.timerPrev_->timerNext_ = nullptr;
+            head.timerPrev_ = &head;
+            head.timerNext_ = &head;
+            while (entry != nullptr) {
+                TimerEntry* next = entry->timerNext_;
+                entry->timerPrev_ = nullptr;
+                entry->timerNext_ = nullptr;
+                if (entry->expireAt_ <= now) {
+                    size_--;
+                    onExpire(entry);
+                }
+                else {
+                    link(findSlot(entry->expireAt_), entry);
+                }
+                entry = next;
+            }
+        }
+    }
+
+    /**
+     * 能容纳 expireAt 的最低一层中对应的槽, 超出最上层一圈的条目先放在最上层, 轮到时再重新调度
+     * 第 0 层放在过期时间所在的槽; 更高的层放在前一个槽, 在过期时间所在的槽开始时就下沉到更低的层,
+     * 这样回收最多比过期时间晚第 0 层的一个槽, 而不是所在层的一个槽
+    */
+    TimerEntry* findSlot(uint64_t expireAt) {
+        uint64_t duration = expireAt > time_ ? expireAt - time_ : 0;
+        if (duration < (kSlots << kShifts[0])) {
+            return &wheel_[0][(expireAt >> kShifts[0]) & (kSlots - 1)];
+        }
+        for (int level = 1; level < kLevels - 1; level++) {
+            if (duration < (kSlots << kShifts[level])) {
+                return &wheel_[level][((expireAt >> kShifts[level]) - 1) & (kSlots - 1)];
+            }
+        }
+        uint64_t maxSpan = (kSlots << kShifts[kLevels - 1]) - 1;
+        uint64_t clamped = duration < maxSpan ? expireAt : time_ + maxSpan;
+        return &wheel_[kLevels - 1][((clamped >> kShifts[kLevels - 1]) - 1) & (kSlots - 1)];
+    }
+
+    static void link(TimerEntry* head, TimerEntry* entry) {
+        entry->timerPrev_ = head->timerPrev_;
+        entry->timerNext_ = head;
+        head->timerPrev_->timerNext_ = entry;
+        head->timerPrev_ = entry;
+    }
+
+    static void unlink(TimerEntry* entry) {
+        entry->timerPrev_->timerNext_ = entry->timerNext_;
+        entry->timerNext_->timerPrev_ = entry->timerPrev_;
+        entry->timerPrev_ = nullptr;
+        entry->timerNext_ = nullptr;
+    }
+
+private:
+    TimerEntry wheel_[kLevels][kSlots];     // 每个槽的虚拟头节点
+    uint64_t time_;                         // 上次推进到的时间
+    size_t size_;                           // 已调度的条目数
+};
+
+} // namespace Cache
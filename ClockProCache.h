@@ -0,0 +1,443 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+#include "CacheStrategy.h"
+#include "CacheBatch.h"
+#include "CacheSharded.h"
+#include "CacheNodePool.h"
+#include "CacheFlatIndex.h"
+#include "CacheLock.h"
+
+/**
+ * CLOCK-Pro (Jiang, Chen, Zhang "CLOCK-Pro: An Effective Improvement of the CLOCK Replacement")
+ * 1. 所有条目挂在同一个环上, 分为三类: 热条目(hot)、冷条目(cold)、已经淘汰只保留 key 的测试条目(test)
+ * 2. 命中只置位条目的引用位, 不移动任何节点; 查找只持有共享锁, 多个读者可以同时命中
+ * 3. 三根指针在独占锁内沿环转动:
+ *    · handCold: 淘汰时转动, 置位的冷条目提升为热条目, 未置位的冷条目被淘汰, 变为测试条目
+ *    · handHot:  热条目超出配额时转动, 清除热条目的引用位, 未置位的降级为冷条目; 经过的测试条目删除
+ *    · handTest: 测试条目超出容量时转动, 删除最早的测试条目
+ * 4. 测试条目再次被 put() 说明它的重用距离只比缓存大一点, 直接作为热条目插入, 并扩大冷条目的配额;
+ *    测试条目过期说明冷条目配额过大, 配额随之缩小. 一次性扫描的条目只会以冷条目进出, 不会冲掉热条目
+ * 和 ArcCache 相比只有一个链表和一个索引, 命中不需要独占锁
+*/
+
+namespace Cache {
+
+template<typename Key, typename Value, typename Mutex = std::shared_mutex, typename Hash = CacheHash<Key>> class ClockProCache;
+
+template<typename Key, typename Value>
+class ClockProNode {
+private:
+    enum class State : uint8_t {
+        Cold,
+        Hot,
+        Test,
+    };
+
+    Key key_;
+    Value value_;
+    size_t weight_;                     // 条目权重, 成为测试条目后保留, 用于调整冷条目配额
+    std::atomic<bool> referenced_;      // 引用位, 共享锁内的命中只写入它
+    State state_;
+    ClockProNode<Key, Value>* prev_;    // 侵入式循环链表(时钟环)指针, 节点内存由 NodePool 管理
+    ClockProNode<Key, Value>* next_;
+
+public:
+    template<typename... Args>
+    explicit ClockProNode(const Key& key, Args&&... args)
+        : key_(key)
+        , value_(std::forward<Args>(args)...)
+        , weight_(1)
+        , referenced_(false)
+        , state_(State::Cold)
+        , prev_(this)
+        , next_(this)
+    {}
+
+    const Key& getKey() const {
+        return key_;
+    }
+    const Value& getValue() const {
+        return value_;
+    }
+
+    template<typename, typename, typename, typename> friend class ClockProCache;
+};
+
+
+// Mutex 为锁策略, 见 CacheLock.h
+template<typename Key, typename Value, typename Mutex, typename Hash>
+class ClockProCache : public CacheStrategy<Key, Value> {
+public:
+    using NodeType = ClockProNode<Key, Value>;
+    using NodePtr = NodeType*;
+    using NodeMap = FlatNodeIndex<Key, NodeType, Hash>;
+    using Weigher = CacheWeigher<Key, Value>;
+
+    // 设置 weigher 后 capacity 为总权重预算, 热/冷/测试三类条目也都按权重计算
+    explicit ClockProCache(size_t capacity, Weigher weigher = nullptr)
+        : capacity_(capacity)
+        , weigher_(std::move(weigher))
+        , nodePool_(weigher_ ? 0 : capacity * 2)
+        , nodeMap_(weigher_ ? 0 : capacity * 2)
+        , coldTarget_(capacity)
+    {
+        this->template useLoadHash<Hash>();
+    }
+
+    ~ClockProCache() override {
+        this->cancelLoads();
+        clearLocked();
+    }
+
+    void put(const Key& key, const Value& value) override {
+        putImpl(key, value);
+    }
+
+    void put(const Key& key, Value&& value) override {
+        putImpl(key, std::move(value));
+    }
+
+    // key 不在缓存中时直接在新节点里构造值; key 已存在时构造新值并移动赋值
+    template<typename... Args>
+    void emplace(const Key& key, Args&&... args) {
+        if (capacity_ == 0) return;
+
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        putLocked(key, nodeMap_.find(key), std::forward<Args>(args)...);
+    }
+
+    // 只持有共享锁: 命中时置位引用位并拷贝值, 测试条目按未命中处理
+    bool get(const Key& key, Value& value) override {
+        StatsSharedLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        if (!getShared(nodeMap_.find(key), value)) {
+            stats_.misses.addShared();
+            return false;
+        }
+        stats_.hits.addShared();
+        return true;
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 只查索引, 不置位引用位
+    bool contains(const Key& key) override {
+        SharedLockGuard<Mutex> lock(mutex_);
+        NodePtr node = nodeMap_.find(key);
+        return node != nullptr && node->state_ != State::Test;
+    }
+
+    // 删除常驻条目, 不留下测试条目, 冷条目配额不变; 已经是测试条目的 key 不处理
+    void remove(const Key& key) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        NodePtr node = nodeMap_.find(key);
+        if (node == nullptr || node->state_ == State::Test) return;
+        (node->state_ == State::Hot ? hotWeight_ : coldWeight_) -= node->weight_;
+        residentCount_--;
+        nodeMap_.erase(key);
+        unlink(node);
+        nodePool_.deallocate(node);
+    }
+
+    size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) override {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        return getBatch(keys, nullptr, keys.size(), values, found);
+    }
+
+    void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) override {
+        putBatch(keys, values, nullptr, std::min(keys.size(), values.size()));
+    }
+
+    /**
+     * 批量查找的分片入口: 只处理 indices 指定的 count 个下标(indices 为空表示 0..count-1), 整批只持有一次共享锁
+     * values/found 由调用方预先调整好大小, 返回命中个数
+    */
+    size_t getBatch(const std::vector<Key>& keys, const size_t* indices, size_t count,
+                    std::vector<Value>& values, std::vector<bool>& found) {
+        size_t hits = 0;
+        StatsSharedLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            if (getShared(nodeMap_.find(keys[i], hash), values[i])) {
+                found[i] = true;
+                hits++;
+            }
+        });
+        stats_.hits.addShared(hits);
+        stats_.misses.addShared(count - hits);
+        return hits;
+    }
+
+    // 批量添加的分片入口, 下标含义同 getBatch()
+    void putBatch(const std::vector<Key>& keys, const std::vector<Value>& values, const size_t* indices, size_t count) {
+        if (capacity_ == 0) return;
+
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            putLocked(keys[i], nodeMap_.find(keys[i], hash), values[i]);
+        });
+    }
+
+    // 清空缓存(包括测试条目), 冷条目配额恢复初始值
+    void purge() {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        clearLocked();
+    }
+
+    CacheStatsSnapshot getStats() override {
+        CacheStatsSnapshot snapshot;
+        stats_.addTo(snapshot);
+        SharedLockGuard<Mutex> lock(mutex_);
+        snapshot.size = residentCount_;
+        snapshot.weight = hotWeight_ + coldWeight_;
+        return snapshot;
+    }
+
+private:
+    using State = typename NodeType::State;
+
+    // 共享锁内的命中路径, 引用位可能被多个读者同时置位, 用 relaxed 原子写
+    bool getShared(NodePtr node, Value& value) const {
+        if (node == nullptr || node->state_ == State::Test) {
+            return false;
+        }
+        if (!node->referenced_.load(std::memory_order_relaxed)) {
+            node->referenced_.store(true, std::memory_order_relaxed);
+        }
+        value = node->value_;
+        return true;
+    }
+
+    template<typename V>
+    void putImpl(const Key& key, V&& value) {
+        if (capacity_ == 0) return;
+
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        putLocked(key, nodeMap_.find(key), std::forward<V>(value));
+    }
+
+    // node 为 key 在索引中查到的节点(可能为空), args 为值本身或值的构造参数
+    template<typename... Args>
+    void putLocked(const Key& key, NodePtr node, Args&&... args) {
+        if (node != nullptr && node->state_ != State::Test) {
+            // 更新值算一次访问, 权重变化后可能需要淘汰
+            node->value_ = Value(std::forward<Args>(args)...);
+            size_t weight = weigh(node);
+            adjustWeight(node, weight);
+            node->referenced_.store(true, std::memory_order_relaxed);
+            evictEntries(0);
+            return;
+        }
+
+        bool reused = node != nullptr;
+        if (reused) {
+            // 测试期内被再次访问: 冷条目配额不够, 扩大配额, 条目直接作为热条目重新插入
+            coldTarget_ = std::min(capacity_, coldTarget_ + node->weight_);
+            removeTest(node);
+        }
+        node = nodePool_.allocate(key, std::forward<Args>(args)...);
+        node->weight_ = weigh(node);
+        if (node->weight_ > capacity_) {
+            // 单个条目就超过总预算, 不缓存
+            nodePool_.deallocate(node);
+            return;
+        }
+        evictEntries(node->weight_);
+        node->state_ = reused ? State::Hot : State::Cold;
+        (reused ? hotWeight_ : coldWeight_) += node->weight_;
+        residentCount_++;
+        nodeMap_.insert(key, node);
+        linkBeforeHotHand(node);
+        stats_.inserts.add();
+        balanceHot();
+    }
+
+    /**
+     * 为 incoming 的权重腾出位置: 转动 handCold 直到常驻条目的总权重放得下
+     * 按权重计算时热条目可能没有超出配额而冷条目已经淘汰光, 这时由 handHot 先降级出冷条目
+    */
+    void evictEntries(size_t incoming) {
+        while (residentCount_ > 0 && hotWeight_ + coldWeight_ + incoming > capacity_) {
+            if (coldWeight_ == 0) {
+                runHandHot();
+            }
+            else {
+                runHandCold();
+            }
+        }
+    }
+
+    // 指针先前进再处理节点, 节点变成测试条目后可能被 handTest 立即删除
+    void runHandCold() {
+        NodePtr node = handCold_;
+        handCold_ = handCold_->next_;
+        if (node->state_ == State::Cold) {
+            if (node->referenced_.load(std::memory_order_relaxed)) {
+                // 冷条目在测试期内被访问, 提升为热条目
+                node->referenced_.store(false, std::memory_order_relaxed);
+                node->state_ = State::Hot;
+                coldWeight_ -= node->weight_;
+                hotWeight_ += node->weight_;
+            }
+            else {
+                evict(node);
+            }
+        }
+        balanceHot();
+    }
+
+    // 热条目超出配额(capacity - 冷条目配额)时转动 handHot
+    void balanceHot() {
+        while (hotWeight_ > 0 && hotWeight_ + coldTarget_ > capacity_) {
+            runHandHot();
+        }
+    }
+
+    void runHandHot() {
+        NodePtr node = handHot_;
+        handHot_ = handHot_->next_;
+        if (node->state_ == State::Hot) {
+            if (node->referenced_.load(std::memory_order_relaxed)) {
+                node->referenced_.store(false, std::memory_order_relaxed);
+            }
+            else {
+                node->state_ = State::Cold;
+                hotWeight_ -= node->weight_;
+                coldWeight_ += node->weight_;
+            }
+        }
+        else if (node->state_ == State::Test) {
+            // handHot 经过的测试条目测试期结束
+            expireTest(node);
+        }
+    }
+
+    // 测试条目的总权重不超过容量, 超出时由 handTest 删除最早的测试条目
+    void runHandTest() {
+        NodePtr node = handTest_;
+        handTest_ = handTest_->next_;
+        if (node->state_ == State::Test) {
+            expireTest(node);
+        }
+    }
+
+    // 淘汰冷条目: 释放值, 节点作为测试条目留在环上
+    void evict(NodePtr node) {
+        node->state_ = State::Test;
+        node->value_ = Value();
+        coldWeight_ -= node->weight_;
+        residentCount_--;
+        testWeight_ += node->weight_;
+        stats_.evictions.add();
+        while (testWeight_ > capacity_) {
+            runHandTest();
+        }
+    }
+
+    // 测试期结束时没有被访问, 冷条目配额过大, 缩小配额
+    void expireTest(NodePtr node) {
+        coldTarget_ = coldTarget_ > node->weight_ ? coldTarget_ - node->weight_ : 1;
+        removeTest(node);
+    }
+
+    void removeTest(NodePtr node) {
+        testWeight_ -= node->weight_;
+        nodeMap_.erase(node->key_);
+        unlink(node);
+        nodePool_.deallocate(node);
+    }
+
+    void adjustWeight(NodePtr node, size_t weight) {
+        size_t& total = node->state_ == State::Hot ? hotWeight_ : coldWeight_;
+        total = total - node->weight_ + weight;
+        node->weight_ = weight;
+    }
+
+    // 新条目插入到 handHot 之前, 即环上最新的位置, 三根指针都要转一整圈才会再经过它
+    void linkBeforeHotHand(NodePtr node) {
+        if (handHot_ == nullptr) {
+            handHot_ = handCold_ = handTest_ = node;
+            return;
+        }
+        node->prev_ = handHot_->prev_;
+        node->next_ = handHot_;
+        handHot_->prev_->next_ = node;
+        handHot_->prev_ = node;
+    }
+
+    // 从环上摘下节点, 指向它的指针前进到它的后继
+    void unlink(NodePtr node) {
+        if (node->next_ == node) {
+            handHot_ = handCold_ = handTest_ = nullptr;
+            return;
+        }
+        if (handHot_ == node) handHot_ = node->next_;
+        if (handCold_ == node) handCold_ = node->next_;
+        if (handTest_ == node) handTest_ = node->next_;
+        node->prev_->next_ = node->next_;
+        node->next_->prev_ = node->prev_;
+        node->prev_ = node;
+        node->next_ = node;
+    }
+
+    void clearLocked() {
+        NodePtr node = handHot_;
+        if (node != nullptr) {
+            do {
+                NodePtr next = node->next_;
+                nodePool_.deallocate(node);
+                node = next;
+            } while (node != handHot_);
+        }
+        handHot_ = handCold_ = handTest_ = nullptr;
+        nodeMap_.clear();
+        hotWeight_ = coldWeight_ = testWeight_ = 0;
+        residentCount_ = 0;
+        coldTarget_ = capacity_;
+    }
+
+    size_t weigh(NodePtr node) const {
+        return weigher_ ? std::max<size_t>(1, weigher_(node->key_, node->value_)) : 1;
+    }
+
+private:
+    size_t capacity_;               // 缓存容量(设置权重函数时为总权重预算)
+    Weigher weigher_;               // 权重函数, 为空时每个条目权重为 1
+    NodePool<NodeType> nodePool_;   // 节点内存池(常驻条目 + 测试条目)
+    NodeMap nodeMap_;               // key -> node, 包括测试条目
+    NodePtr handHot_ = nullptr;     // 时钟环上的三根指针, 环为空时都为空
+    NodePtr handCold_ = nullptr;
+    NodePtr handTest_ = nullptr;
+    size_t coldTarget_;             // 冷条目配额, 随测试条目的命中/过期自适应调整
+    size_t hotWeight_ = 0;          // 热条目总权重
+    size_t coldWeight_ = 0;         // 冷条目总权重
+    size_t testWeight_ = 0;         // 测试条目总权重
+    size_t residentCount_ = 0;      // 常驻(热 + 冷)条目数
+    mutable Mutex mutex_;
+    CacheStats stats_;              // 统计计数器
+};
+
+
+// 对缓存空间切片, 实现 HashClockPro, 每个分片有独立的时钟环和冷条目配额
+template<typename Key, typename Value, typename Hash = CacheHash<Key>, typename Mutex = std::shared_mutex>
+class HashClockProCache : public ShardedCacheStrategy<ClockProCache<Key, Value, Mutex, Hash>, 0, Hash> {
+public:
+    // 设置 weigher 后 capacity 为总权重预算, 平均分给各分片
+    HashClockProCache(size_t capacity, int sliceNum, CacheWeigher<Key, Value> weigher = nullptr)
+        : ShardedCacheStrategy<ClockProCache<Key, Value, Mutex, Hash>, 0, Hash>(capacity, sliceNum, weigher)
+    {}
+};
+
+} // namespace Cache
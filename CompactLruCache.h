@@ -0,0 +1,434 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CacheStrategy.h"
+#include "CacheBatch.h"
+#include "CacheSharded.h"
+#include "CacheFlatIndex.h"
+#include "CacheNuma.h"
+#include "CacheLock.h"
+
+/**
+ * 紧凑布局的 LRU (struct-of-arrays), 用于 uint64_t 这类小 key 和小 value
+ * 1. 条目不再是单独的节点, 而是固定容量数组里的一个槽位: key 数组、LRU 链接数组(两个 32 位下标)、value 数组分开存放,
+ *    淘汰链表的遍历只读 8 字节一项的链接数组, 查找时只碰 key 和索引
+ * 2. key 只存一份: 索引(FlatNodeIndex)的槽位直接指向 key 数组中的元素, 槽位号由指针减去数组首地址得到
+ * 3. value 可平凡拷贝并且不超过 kCompactInlineValueSize 字节时内联放在 value 数组里;
+ *    否则每个条目单独分配, value 数组只存指针, key 和链接数组仍然紧凑
+ * 4. 以 uint64_t -> uint64_t 为例, 每个条目约 8(key) + 8(value) + 8(链接) + 约 10(索引槽位和控制字节 / 负载因子) 字节,
+ *    LruCache 的节点本身就有一百字节左右
+ * key 必须是平凡类型(构造、拷贝、析构都是平凡的), 不支持 TTL、权重函数、快照和后台维护, 需要这些功能时使用 LruCache
+*/
+
+namespace Cache {
+
+constexpr size_t kCompactInlineValueSize = 24;
+
+// value 的存放方式: 内联在数组里, 或者每个条目单独分配
+template<typename Value,
+         bool Inline = std::is_trivial<Value>::value && sizeof(Value) <= kCompactInlineValueSize>
+class CompactValueArray;
+
+template<typename Value>
+class CompactValueArray<Value, true> {
+public:
+    CompactValueArray() = default;
+
+    CompactValueArray(size_t count, int numaNode)
+        : values_(count, numaNode)
+    {}
+
+    Value& at(size_t i) {
+        return values_[i];
+    }
+
+    template<typename V>
+    void set(size_t i, V&& value) {
+        values_[i] = std::forward<V>(value);
+    }
+
+    // 槽位被释放; 平凡类型没有资源需要归还
+    void release(size_t) {}
+
+    void moveToNode(int node) {
+        values_.moveToNode(node);
+    }
+
+private:
+    NumaArray<Value> values_;
+};
+
+template<typename Value>
+class CompactValueArray<Value, false> {
+public:
+    CompactValueArray() = default;
+
+    CompactValueArray(size_t count, int)
+        : values_(count)
+    {}
+
+    Value& at(size_t i) {
+        return *values_[i];
+    }
+
+    // 槽位上已经有分配好的值(淘汰后立即复用的槽位)时直接赋值, 省掉一次释放和分配
+    template<typename V>
+    void set(size_t i, V&& value) {
+        if (values_[i]) {
+            *values_[i] = std::forward<V>(value);
+        }
+        else {
+            values_[i] = std::make_unique<Value>(std::forward<V>(value));
+        }
+    }
+
+    void release(size_t i) {
+        values_[i].reset();
+    }
+
+    // value 本身在各自的堆分配里, 只迁移指针数组
+    void moveToNode(int node) {
+        numaBindMemory(values_.data(), values_.size() * sizeof(values_[0]), node, true);
+    }
+
+    // 不同大小的数组之间搬移槽位, 只移动指针
+    std::unique_ptr<Value>& slot(size_t i) {
+        return values_[i];
+    }
+
+private:
+    std::vector<std::unique_ptr<Value>> values_;
+};
+
+template<typename Key, typename Value, typename Mutex = std::mutex, typename Hash = CacheHash<Key>>
+class CompactLruCache : public CacheStrategy<Key, Value> {
+    static_assert(std::is_trivial<Key>::value, "CompactLruCache requires a trivial key type, use LruCache otherwise");
+
+public:
+    CompactLruCache(size_t capacity)
+        : capacity_(std::min<size_t>(capacity, kMaxCapacity))
+    {
+        this->template useLoadHash<Hash>();
+        allocate(capacity_);
+    }
+
+    ~CompactLruCache() override {
+        this->cancelLoads();
+    }
+
+    void put(const Key& key, const Value& value) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        putLocked(key, value, index_.hash(key));
+    }
+
+    void put(const Key& key, Value&& value) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        putLocked(key, std::move(value), index_.hash(key));
+    }
+
+    bool get(const Key& key, Value& value) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        return getLocked(key, value, index_.hash(key));
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 只查索引, 不调整访问顺序
+    bool contains(const Key& key) override {
+        SharedLockGuard<Mutex> lock(mutex_);
+        return index_.find(key) != nullptr;
+    }
+
+    size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) override {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        return getBatch(keys, nullptr, keys.size(), values, found);
+    }
+
+    void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) override {
+        putBatch(keys, values, nullptr, std::min(keys.size(), values.size()));
+    }
+
+    // 批量查找的分片入口, 参数含义同 LruCache::getBatch()
+    size_t getBatch(const std::vector<Key>& keys, const size_t* indices, size_t count,
+                    std::vector<Value>& values, std::vector<bool>& found) {
+        size_t hits = 0;
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        forEachBatched(index_, keys, indices, count, [&](size_t i, size_t hash) {
+            if (getLocked(keys[i], values[i], hash)) {
+                found[i] = true;
+                hits++;
+            }
+        });
+        return hits;
+    }
+
+    void putBatch(const std::vector<Key>& keys, const std::vector<Value>& values, const size_t* indices, size_t count) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        forEachBatched(index_, keys, indices, count, [&](size_t i, size_t hash) {
+            putLocked(keys[i], values[i], hash);
+        });
+    }
+
+    void remove(const Key& key) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        KeySlot* found = index_.find(key);
+        if (found == nullptr) return;
+        uint32_t slot = slotOf(found);
+        unlink(slot);
+        index_.erase(key);
+        freeSlot(slot);
+    }
+
+    void purge() {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        for (uint32_t slot = links_[kHead].next; slot != kHead; slot = links_[slot].next) {
+            values_.release(slot);
+        }
+        index_.clear();
+        resetSlots();
+    }
+
+    /**
+     * 调整容量, 变小时从最久未访问的一端淘汰; 超过已分配的槽位数时重新分配数组,
+     * 存活的条目按访问顺序搬到新数组并重建索引, 变小时不释放数组
+    */
+    void resize(size_t capacity) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        capacity = std::min<size_t>(capacity, kMaxCapacity);
+        while (size_ > capacity) {
+            evictLeastRecent();
+        }
+        if (capacity > slotCount_) grow(capacity);
+        capacity_ = capacity;
+    }
+
+    size_t getCapacity() {
+        SharedLockGuard<Mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    // 返回并清零上次调用以来的未命中次数, 用于分片间的容量再平衡
+    size_t takeMisses() {
+        return recentMisses_.exchange(0, std::memory_order_relaxed);
+    }
+
+    // 淘汰监听器, expireAt 总是 0; 传入空函数时取消
+    void setEvictionListener(CacheEvictionListener<Key, Value> listener) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        evictionListener_ = std::move(listener);
+    }
+
+    // 各个数组和索引绑定到 NUMA 节点 node, 已有的内存一并迁移
+    void setNumaNode(int node) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        numaNode_ = node;
+        keys_.moveToNode(node);
+        links_.moveToNode(node);
+        values_.moveToNode(node);
+        index_.setNumaNode(node);
+    }
+
+    CacheStatsSnapshot getStats() override {
+        CacheStatsSnapshot snapshot;
+        stats_.addTo(snapshot);
+        SharedLockGuard<Mutex> lock(mutex_);
+        snapshot.size = size_;
+        snapshot.weight = size_;
+        return snapshot;
+    }
+
+private:
+    // 索引指向的 key 槽位, FlatNodeIndex 通过 getKey() 比较
+    struct KeySlot {
+        Key key;
+
+        const Key& getKey() const {
+            return key;
+        }
+    };
+
+    // LRU 双向链表的链接, 用槽位号代替指针; 0 号槽位是链表头, 不存放条目
+    struct Link {
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    static constexpr uint32_t kHead = 0;
+    static constexpr size_t kMaxCapacity = UINT32_MAX - 1;
+
+    uint32_t slotOf(const KeySlot* keySlot) const {
+        return static_cast<uint32_t>(keySlot - keys_.get());
+    }
+
+    bool getLocked(const Key& key, Value& value, size_t hash) {
+        KeySlot* found = index_.find(key, hash);
+        if (found == nullptr) {
+            stats_.misses.add();
+            recentMisses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        uint32_t slot = slotOf(found);
+        moveToBack(slot);
+        value = values_.at(slot);
+        stats_.hits.add();
+        return true;
+    }
+
+    template<typename V>
+    void putLocked(const Key& key, V&& value, size_t hash) {
+        KeySlot* found = index_.find(key, hash);
+        if (found != nullptr) {
+            uint32_t slot = slotOf(found);
+            values_.set(slot, std::forward<V>(value));
+            moveToBack(slot);
+            return;
+        }
+        if (capacity_ == 0) return;
+        if (size_ >= capacity_) evictLeastRecent();
+        uint32_t slot = allocateSlot();
+        keys_[slot].key = key;
+        values_.set(slot, std::forward<V>(value));
+        index_.insert(key, &keys_[slot]);
+        pushBack(slot);
+        stats_.inserts.add();
+    }
+
+    // 淘汰最久未访问的条目, 槽位挂回空闲链表; value 留在槽位上, 由下一次 set() 覆盖
+    void evictLeastRecent() {
+        uint32_t slot = links_[kHead].next;
+        if (slot == kHead) return;
+        if (evictionListener_) evictionListener_(keys_[slot].key, values_.at(slot), 0);
+        unlink(slot);
+        index_.erase(keys_[slot].key);
+        links_[slot].next = freeHead_;
+        freeHead_ = slot;
+        stats_.evictions.add();
+    }
+
+    // 显式删除的槽位同时归还 value 占用的资源
+    void freeSlot(uint32_t slot) {
+        values_.release(slot);
+        links_[slot].next = freeHead_;
+        freeHead_ = slot;
+    }
+
+    // 优先复用空闲链表上的槽位, 否则取下一个从未使用过的槽位
+    uint32_t allocateSlot() {
+        if (freeHead_ != kHead) {
+            uint32_t slot = freeHead_;
+            freeHead_ = links_[slot].next;
+            return slot;
+        }
+        return ++usedSlots_;
+    }
+
+    void pushBack(uint32_t slot) {
+        uint32_t tail = links_[kHead].prev;
+        links_[slot].prev = tail;
+        links_[slot].next = kHead;
+        links_[tail].next = slot;
+        links_[kHead].prev = slot;
+        size_++;
+    }
+
+    void unlink(uint32_t slot) {
+        Link link = links_[slot];
+        links_[link.prev].next = link.next;
+        links_[link.next].prev = link.prev;
+        size_--;
+    }
+
+    void moveToBack(uint32_t slot) {
+        if (links_[kHead].prev == slot) return;
+        unlink(slot);
+        pushBack(slot);
+    }
+
+    void allocate(size_t slotCount) {
+        slotCount_ = slotCount;
+        keys_ = NumaArray<KeySlot>(slotCount + 1, numaNode_);
+        links_ = NumaArray<Link>(slotCount + 1, numaNode_);
+        values_ = CompactValueArray<Value>(slotCount + 1, numaNode_);
+        index_.reserve(slotCount);
+        resetSlots();
+    }
+
+    void resetSlots() {
+        links_[kHead] = Link{kHead, kHead};
+        freeHead_ = kHead;
+        usedSlots_ = 0;
+        size_ = 0;
+    }
+
+    // 数组扩大到 slotCount 个槽位: 存活的条目从最久未访问的开始依次放到 1..size_, 索引重新指向新的 key 数组
+    void grow(size_t slotCount) {
+        NumaArray<KeySlot> oldKeys = std::move(keys_);
+        NumaArray<Link> oldLinks = std::move(links_);
+        CompactValueArray<Value> oldValues = std::move(values_);
+        index_.clear();
+        allocate(slotCount);
+        for (uint32_t old = oldLinks[kHead].next; old != kHead; old = oldLinks[old].next) {
+            uint32_t slot = ++usedSlots_;
+            keys_[slot] = oldKeys[old];
+            moveValue(oldValues, old, slot);
+            index_.insert(keys_[slot].key, &keys_[slot]);
+            pushBack(slot);
+        }
+    }
+
+    void moveValue(CompactValueArray<Value>& from, uint32_t oldSlot, uint32_t newSlot) {
+        if constexpr (std::is_trivial<Value>::value && sizeof(Value) <= kCompactInlineValueSize) {
+            values_.set(newSlot, from.at(oldSlot));
+        }
+        else {
+            values_.slot(newSlot) = std::move(from.slot(oldSlot));
+        }
+    }
+
+private:
+    size_t capacity_;                   // 缓存容量
+    size_t slotCount_ = 0;              // 已分配的槽位数(不含链表头), 不小于 capacity_
+    size_t size_ = 0;                   // 条目数
+    uint32_t freeHead_ = kHead;         // 空闲槽位链表(借用 Link::next), kHead 表示为空
+    uint32_t usedSlots_ = 0;            // 用过的最大槽位号, 之后的槽位从未使用
+    int numaNode_ = -1;                 // 数组所在的 NUMA 节点, -1 表示不指定
+    NumaArray<KeySlot> keys_;
+    NumaArray<Link> links_;
+    CompactValueArray<Value> values_;
+    FlatNodeIndex<Key, KeySlot, Hash> index_;   // key -> key 数组中的槽位
+    Mutex mutex_;
+    CacheStats stats_;
+    CacheEvictionListener<Key, Value> evictionListener_;
+    std::atomic<size_t> recentMisses_{0};   // 上次 takeMisses() 以来的未命中次数
+};
+
+// 紧凑 LRU 的分片版本
+template<typename Key, typename Value, typename Hash = CacheHash<Key>, typename Mutex = std::mutex>
+class HashCompactLruCache : public ShardedCacheStrategy<CompactLruCache<Key, Value, Mutex, Hash>, 0, Hash> {
+public:
+    HashCompactLruCache(size_t capacity, int sliceNum)
+        : ShardedCacheStrategy<CompactLruCache<Key, Value, Mutex, Hash>, 0, Hash>(capacity, sliceNum)
+    {}
+
+    // 分片间容量再平衡, 按各分片上个周期的未命中次数分配, 见 ShardedCache::rebalanceCapacity()
+    void rebalanceCapacity(size_t minSliceCapacity = 1) {
+        this->sharded_.rebalanceCapacity([](CompactLruCache<Key, Value, Mutex, Hash>& slice) { return slice.takeMisses(); },
+                                         minSliceCapacity);
+    }
+};
+
+} // namespace Cache
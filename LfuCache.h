@@ -1,14 +1,24 @@
 #pragma once
 
+#include <chrono>
 #include <cmath>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
-#include <unordered_map>
-#include <climits>
+#include <utility>
+#include <algorithm>
 #include <vector>
 
 #include "CacheStrategy.h"
+#include "CacheBatch.h"
+#include "CacheSharded.h"
+#include "CacheNodePool.h"
+#include "CacheFlatIndex.h"
+#include "CacheTimerWheel.h"
+#include "CacheSnapshot.h"
+#include "CacheMaintenance.h"
+#include "CacheLock.h"
 
 // 最近使用频率高的数据很大概率将会再次被使用, 而最近使用频率低的数据, 将来大概率不会再使用
 /**
@@ -35,56 +45,70 @@
  * 引入访问次数平均值概念
  * 当平均值大于最大平均值限制时将所有结点的访问次数减去最大平均值限制的一半或者一个固定值
  * 相当于热点数据“老化”了, 这样可以避免频次计数溢出, 也可以缓解缓存污染
+ * 老化不逐个修改节点: 链表上记录的是原始频次, 缓存维护一个全局老化偏移量, 有效频次 = max(1, 原始频次 - 偏移量)
+ * 老化时只增加偏移量, 所有节点的有效频次同时减少, 频次链表之间的顺序不变, 因此不需要遍历整个缓存
 */
 
 // LFU算法中不同频率有不同频率的列表: 频率为1有维护频率为1的列表, 频率为2有维护频率为2的链表 
+// 频次链表按原始频次从小到大串成一条链, 第一个链表就是最小频次链表
 namespace Cache {
 // 使用前声明
-template<typename Key, typename Value> class LfuCache;
+template<typename Key, typename Value, typename Mutex = std::mutex, typename Hash = CacheHash<Key>> class LfuCache;
 
 template<typename Key, typename Value>
 class FreqList {
 private:
-    struct Node {
-        int freq;   // 访问频次, 一个列表维护一个频次
+    // 继承 TimerEntry, 设置了 TTL 的节点挂在所属缓存的定时轮上
+    struct Node : TimerEntry {
+        FreqList* list; // 节点所在的频次链表, 频次记录在链表上
+        size_t weight;  // 条目权重, 插入和更新值时由缓存计算
         Key key;
         Value value;
-        std::shared_ptr<Node> prev;     // 前一个节点
-        std::shared_ptr<Node> next;     // 后一个节点
+        Node* prev;     // 前一个节点(侵入式链表, 节点内存由 NodePool 管理)
+        Node* next;     // 后一个节点
 
-        Node(): freq(1), prev(nullptr), next(nullptr) {}
-        Node(Key key, Value value): key(key), value(value), freq(1), prev(nullptr), next(nullptr) {}
+        Node(): list(nullptr), weight(1), prev(nullptr), next(nullptr) {}
+        // 值用剩余参数原地构造, 可以传入已有的值(拷贝/移动)或者值的构造参数
+        template<typename... Args>
+        explicit Node(const Key& key, Args&&... args)
+            : list(nullptr), weight(1), key(key), value(std::forward<Args>(args)...), prev(nullptr), next(nullptr) {}
+
+        const Key& getKey() const { return key; }
     };
 
-    using NodePtr = std::shared_ptr<Node>;
-    int freq_;      // 访问频率
-    NodePtr head_;  // 虚拟头节点
-    NodePtr tail_;  // 虚拟尾节点
+    using NodePtr = Node*;
+    size_t freq_;       // 原始访问频率(未扣除老化偏移量)
+    Node head_;         // 虚拟头节点(内嵌在链表对象中, 不单独分配)
+    Node tail_;         // 虚拟尾节点
+    FreqList* prev_;    // 频次更小的相邻链表
+    FreqList* next_;    // 频次更大的相邻链表
 
 public:
-    explicit FreqList(int n): freq_(n) {
-        head_ = std::make_shared<Node>();
-        tail_ = std::make_shared<Node>();
-        head_->next = tail_;
-        tail_->prev = head_; 
+    explicit FreqList(size_t n): freq_(n), prev_(nullptr), next_(nullptr) {
+        head_.next = &tail_;
+        tail_.prev = &head_; 
     }
 
+    FreqList(const FreqList&) = delete;
+    FreqList& operator=(const FreqList&) = delete;
+
     bool isEmpty() const {
-        return head_->next == tail_;
+        return head_.next == &tail_;
     }
 
-    // 添加节点到尾部的方法, 于是head_->next的节点是最不常访问的节点
+    // 添加节点到尾部的方法, 于是head_.next的节点是最不常访问的节点
     void addNode(NodePtr node) {
-        if (!node || !head_ || !tail_) return;
-        node->prev = tail_->prev;
-        tail_->prev = node;
+        if (!node) return;
+        node->list = this;
+        node->prev = tail_.prev;
+        tail_.prev = node;
         node->prev->next = node;
-        node->next = tail_;
+        node->next = &tail_;
     }
 
     // 删除表中节点的方法
     void removeNode(NodePtr node) {
-        if (!node || !head_ || !tail_) return;
+        if (!node) return;
         if (!node->next || !node->prev) return;
 
         node->prev->next = node->next;
@@ -95,165 +119,644 @@ public:
     }
 
     NodePtr getFirstNode() const {
-        return head_->next;
+        return head_.next;
     }
 
-    friend class LfuCache<Key, Value>;
+    template<typename, typename, typename, typename> friend class LfuCache;
 };
 
-template<typename Key, typename Value>
+// Mutex 为锁策略, 见 CacheLock.h
+template<typename Key, typename Value, typename Mutex, typename Hash>
 class LfuCache: public CacheStrategy<Key, Value> {
 public:
     using Node = typename FreqList<Key, Value>::Node;
-    using NodePtr = std::shared_ptr<Node>;
-    using NodeMap = std::unordered_map<Key, NodePtr>;
-
-    LfuCache(int capacity, int maxAverageNum = 10)
-        : capacity_(capacity), minFreq_(INT_MAX), maxAverageNum_(maxAverageNum)
-        , curAverageNum_(0), curTotalNum_(0)
-    {}
+    using NodePtr = Node*;
+    using NodeMap = FlatNodeIndex<Key, Node, Hash>;
+    using List = FreqList<Key, Value>;
+
+    using Weigher = CacheWeigher<Key, Value>;
+
+    // 设置 weigher 后 capacity 表示总权重预算, 内存池和索引不再按容量预留
+    LfuCache(size_t capacity, int maxAverageNum = 10, Weigher weigher = nullptr)
+        : capacity_(capacity), usedWeight_(0), maxAverageNum_(maxAverageNum)
+        , curAverageNum_(0), curTotalNum_(0), agingOffset_(0)
+        , weigher_(std::move(weigher))
+        , nodePool_(weigher_ ? 0 : capacity)
+        , listPool_(16)
+        , nodeMap_(weigher_ ? 0 : capacity)
+        , minList_(nullptr), floorList_(nullptr)
+    {
+        this->template useLoadHash<Hash>();
+    }
 
-    ~LfuCache() override = default;
+    ~LfuCache() override {
+        this->cancelLoads();
+        purge();
+    }
 
     // 在LFU中, put()和get()都会增加缓存已有节点的频次并将其移动到新的频次列表
-    void put(Key key, Value value) override {
-        if (capacity_ == 0) return;
-
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = nodeMap_.find(key);
-        if (it != nodeMap_.end()) {
-            // 在缓存中更改其value
-            it->second->value = value;
-            // 用getInternal()增加node的频率并移动到新的频率列表
-            getInternal(it->second, value);
+    void put(const Key& key, const Value& value) override {
+        putImpl(key, value);
+    }
+
+    void put(const Key& key, Value&& value) override {
+        putImpl(key, std::move(value));
+    }
+
+    // 带 TTL 的添加: ttl 之后条目失效, 由定时轮回收; 不带 ttl 的 put()/emplace() 会清除已有的过期时间
+    void put(const Key& key, const Value& value, std::chrono::nanoseconds ttl) {
+        putImpl(key, value, cacheExpireAt(ttl));
+    }
+
+    void put(const Key& key, Value&& value, std::chrono::nanoseconds ttl) {
+        putImpl(key, std::move(value), cacheExpireAt(ttl));
+    }
+
+    // key 不存在时直接在新节点里构造值; key 已存在时构造新值并移动赋值
+    template<typename... Args>
+    void emplace(const Key& key, Args&&... args) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        NodePtr node = nodeMap_.find(key);
+        if (node != nullptr) {
+            retired_.retire(node->value);
+            node->value = Value(std::forward<Args>(args)...);
+            updateExisting(node, 0);
         }
         else {
-            // 不在缓存中就加入
-            putInternal(key, value);
+            putInternal(key, 0, std::forward<Args>(args)...);
         }
     }
 
+    // 删除指定元素
+    void remove(const Key& key) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        NodePtr node = nodeMap_.find(key);
+        if (node != nullptr) {
+            removeEntry(node);
+        }
+    }
+
+    // 只查索引(已过期的不算), 不增加访问频次
+    bool contains(const Key& key) override {
+        std::lock_guard<Mutex> lock(mutex_);
+        NodePtr node = nodeMap_.find(key);
+        return node != nullptr && (node->expireAt_ == 0 || !node->isExpired(cacheNowNanos()));
+    }
+
     // value值为传出参数
-    bool get(Key key, Value& value) override {
+    bool get(const Key& key, Value& value) override {
         bool flag = false;
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = nodeMap_.find(key);
-        if (it != nodeMap_.end()) {
-            getInternal(it->second, value);
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        NodePtr node = findLive(key, nodeMap_.hash(key));
+        if (node != nullptr) {
+            getInternal(node, value);
             flag = true;
+            stats_.hits.add();
+        }
+        else {
+            stats_.misses.add();
+            recentMisses_++;
         }
         return flag;
     }
 
-    Value get(Key key) override {
-        Value value;
+    Value get(const Key& key) override {
+        Value value{};
         get(key, value);
         return value;
     }
 
+    size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) override {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        return getBatch(keys, nullptr, keys.size(), values, found);
+    }
+
+    void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) override {
+        putBatch(keys, values, nullptr, std::min(keys.size(), values.size()));
+    }
+
+    // 批量查找的分片入口: 只处理 indices 指定的 count 个下标(indices 为空表示 0..count-1), 整批只加一次锁
+    size_t getBatch(const std::vector<Key>& keys, const size_t* indices, size_t count,
+                    std::vector<Value>& values, std::vector<bool>& found) {
+        size_t hits = 0;
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            NodePtr node = findLive(keys[i], hash);
+            if (node != nullptr) {
+                getInternal(node, values[i]);
+                found[i] = true;
+                hits++;
+            }
+        });
+        stats_.hits.add(hits);
+        stats_.misses.add(count - hits);
+        recentMisses_ += count - hits;
+        return hits;
+    }
+
+    // 批量添加的分片入口, 下标含义同 getBatch()
+    void putBatch(const std::vector<Key>& keys, const std::vector<Value>& values, const size_t* indices, size_t count) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            NodePtr node = nodeMap_.find(keys[i], hash);
+            if (node != nullptr) {
+                retired_.retire(node->value);
+                node->value = values[i];
+                updateExisting(node, 0);
+            }
+            else {
+                putInternal(keys[i], 0, values[i]);
+            }
+        });
+    }
+
     // 清空缓存, 回收资源
     void purge() {
-        nodeMap_.clear();
-        freqToFreqList_.clear();
+        std::lock_guard<Mutex> lock(mutex_);
+        purgeLocked();
+    }
+
+    /**
+     * 保存快照: 按有效频次从小到大(同频次内从最早进入到最近进入)写出每个条目的 key、value、有效频次和剩余 TTL
+     * 保存期间持有锁; 成功返回 true
+    */
+    template<typename KeySerializer = CacheSerializer<Key>, typename ValueSerializer = CacheSerializer<Value>>
+    bool saveSnapshot(const std::string& path) {
+        SnapshotWriter out(path);
+        if (!out.ok()) return false;
+        {
+            StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+            expireEntries();
+            uint64_t now = timerWheel_.empty() ? 0 : now_;
+            uint64_t count = 0;
+            forEachInOrder([&](NodePtr node) {
+                if (!node->isExpired(now)) count++;
+            });
+            out.writeHeader(SnapshotPolicy::Lfu, count);
+            forEachInOrder([&](NodePtr node) {
+                uint64_t remaining = 0;
+                if (!snapshotRemainingTtl(node->expireAt_, now, remaining)) return;
+                KeySerializer::write(out, node->key);
+                ValueSerializer::write(out, node->value);
+                out.writePod(static_cast<uint64_t>(effectiveFreq(node->list)));
+                out.writePod(remaining);
+            });
+        }
+        return out.commit();
+    }
+
+    /**
+     * 载入快照: 先清空缓存, 再按快照顺序直接挂到对应频次的链表末尾, 恢复频次和同频次内的先后顺序
+     * 快照按频次升序排列, 新链表总是追加在链的末尾, 每个条目 O(1); 超出容量时按 LFU 规则淘汰
+     * 文件不存在、格式不对或者被截断时返回 false, 截断前的条目会保留在缓存中
+    */
+    template<typename KeySerializer = CacheSerializer<Key>, typename ValueSerializer = CacheSerializer<Value>>
+    bool loadSnapshot(const std::string& path) {
+        SnapshotReader in(path);
+        uint64_t count = 0;
+        uint64_t elapsed = 0;
+        if (!in.ok() || !in.readHeader(SnapshotPolicy::Lfu, count, elapsed)) return false;
+
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        purgeLocked();
+        if (!weigher_) nodeMap_.reserve(std::min<uint64_t>(count, capacity_));
+        uint64_t now = cacheNowNanos();
+        List* last = nullptr;       // 链上的最后一个链表, 即最近一次恢复的条目所在的链表
+        bool ok = true;
+        for (uint64_t i = 0; i < count; i++) {
+            Key key{};
+            Value value{};
+            uint64_t freq = 0;
+            uint64_t remaining = 0;
+            if (!KeySerializer::read(in, key) || !ValueSerializer::read(in, value)
+                || !in.readPod(freq) || !in.readPod(remaining)) {
+                ok = false;
+                break;
+            }
+            uint64_t expireAt = 0;
+            if (capacity_ == 0 || !snapshotRestoreExpireAt(remaining, elapsed, now, expireAt)) continue;
+            if (nodeMap_.find(key) != nullptr) continue;
+            last = restoreEntry(last, key, std::move(value), std::max<uint64_t>(1, freq), expireAt);
+        }
+        curAverageNum_ = nodeMap_.empty() ? 0 : curTotalNum_ / nodeMap_.size();
+        return ok;
+    }
+
+    // 立即回收所有已经到期的条目; 读写操作本身也会顺带回收, 这里用于长时间没有写入的缓存
+    void purgeExpired() {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+    }
+
+    // 调整容量(设置权重函数时为总权重预算), 变小时按 LFU 规则淘汰
+    void resize(size_t capacity) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        capacity_ = capacity;
+        makeRoom(0);
+    }
+
+    size_t getCapacity() {
+        std::lock_guard<Mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    // 返回并清零上次调用以来的未命中次数, 用于分片间的容量再平衡; 不受 CACHE_ENABLE_STATS 影响
+    size_t takeMisses() {
+        std::lock_guard<Mutex> lock(mutex_);
+        size_t misses = recentMisses_;
+        recentMisses_ = 0;
+        return misses;
+    }
+
+    /**
+     * 取出所有未过期的条目: 按淘汰顺序(频次从小到大)调用 func(key, value, expireAt), value 可以被移走, 之后缓存为空
+     * 用于调整分片数时把条目迁移到新的分片, 迁移后频次从 1 重新开始; func 在锁内调用, 不能再访问这个缓存
+    */
+    template<typename Func>
+    void drainEntries(Func&& func) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        forEachInOrder([&](NodePtr node) {
+            func(node->key, node->value, node->expireAt_);
+        });
+        purgeLocked();
+    }
+
+    // 淘汰监听器, 传入空函数时取消; 见 CacheEvictionListener
+    void setEvictionListener(CacheEvictionListener<Key, Value> listener) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        evictionListener_ = std::move(listener);
+    }
+
+    // 延迟释放: 开启后淘汰、过期和覆盖的旧值移进待释放列表, 由 runMaintenance() 在锁外析构
+    void setDeferredRelease(bool enabled) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        retired_.setEnabled(enabled);
+    }
+
+    // 节点内存池和索引绑定到 NUMA 节点 node, 已有的内存一并迁移; 通常由分片缓存的 placeShardsOnNumaNodes() 调用
+    void setNumaNode(int node) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        nodePool_.setNumaNode(node);
+        nodeMap_.setNumaNode(node);
+    }
+
+    // 一次后台维护: 回收到期条目, 待释放的旧值在锁外析构
+    void runMaintenance() {
+        std::vector<Value> retired;
+        {
+            StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+            expireEntries();
+            retired = retired_.take();
+        }
+    }
+
+    // window 之内到期、并且上次写入之后被读过的条目的 key, 用于提前刷新
+    std::vector<Key> expiringKeys(std::chrono::nanoseconds window) {
+        std::vector<Key> keys;
+        std::lock_guard<Mutex> lock(mutex_);
+        if (timerWheel_.empty()) return keys;
+        timerWheel_.forEachExpiringBefore(cacheNowNanos() + static_cast<uint64_t>(window.count()), [&](TimerEntry* entry) {
+            if (entry->readSinceWrite()) keys.push_back(static_cast<NodePtr>(entry)->key);
+        });
+        return keys;
+    }
+
+    // 提前刷新的写回: 只替换已有条目的值并以 ttl 续期, 不增加访问频次; 条目已经不在缓存中时返回 false
+    template<typename V>
+    bool refresh(const Key& key, V&& value, std::chrono::nanoseconds ttl) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        NodePtr node = findLive(key, nodeMap_.hash(key));
+        if (node == nullptr) return false;
+        retired_.retire(node->value);
+        node->value = std::forward<V>(value);
+        node->markWritten();
+        timerWheel_.reschedule(node, cacheExpireAt(ttl));
+        reweigh(node);
+        return true;
+    }
+
+    CacheStatsSnapshot getStats() override {
+        CacheStatsSnapshot snapshot;
+        stats_.addTo(snapshot);
+        std::lock_guard<Mutex> lock(mutex_);
+        snapshot.size = nodeMap_.size();
+        snapshot.weight = usedWeight_;
+        return snapshot;
     }
           
 private:
-    void putInternal(Key key, Value value);             // 添加缓存
-    void getInternal(NodePtr node, Value& value);       // 获取缓存
+    // 清空缓存, 调用方持有锁
+    void purgeLocked() {
+        // 节点归还内存池, 频次链表由缓存自己创建, 也需要一并释放
+        nodeMap_.forEach([this](NodePtr node) {
+            retired_.retire(node->value);
+            nodePool_.deallocate(node);
+        });
+        nodeMap_.clear();
+        timerWheel_.clear();
+        while (minList_ != nullptr) {
+            FreqList<Key, Value>* next = minList_->next_;
+            listPool_.deallocate(minList_);
+            minList_ = next;
+        }
+        floorList_ = nullptr;
+        usedWeight_ = 0;
+        curAverageNum_ = 0;
+        curTotalNum_ = 0;
+        agingOffset_ = 0;
+    }
+
+    // 按频次链表从小到大、链表内从头到尾遍历所有节点, 即淘汰顺序
+    template<typename Func>
+    void forEachInOrder(Func&& func) {
+        for (List* list = minList_; list != nullptr; list = list->next_) {
+            for (NodePtr node = list->head_.next; node != &list->tail_; node = node->next) {
+                func(node);
+            }
+        }
+    }
+
+    /**
+     * 载入快照时恢复一个条目, 缓存刚被清空(老化偏移量为 0, 原始频次即有效频次)
+     * last 是链上的最后一个链表, 频次不小于它时直接追加; 返回新的最后一个链表
+    */
+    List* restoreEntry(List* last, const Key& key, Value&& value, size_t freq, uint64_t expireAt) {
+        NodePtr node = nodePool_.allocate(key, std::move(value));
+        node->weight = weigh(node);
+        if (node->weight > capacity_) {
+            nodePool_.deallocate(node);
+            return last;
+        }
+        makeRoom(node->weight);
+        // 淘汰只发生在最小频次链表, 它被清空回收时 last 只可能是唯一的链表
+        if (minList_ == nullptr) last = nullptr;
+        if (last != nullptr && freq < last->freq_) {
+            // 快照不是按频次升序排列的(被改动过), 退化为并入最后一个链表, 保证链的有序性
+            freq = last->freq_;
+        }
+        if (last == nullptr || last->freq_ != freq) {
+            last = insertListAfter(last, freq);
+        }
+        last->addNode(node);
+        nodeMap_.insert(key, node);
+        usedWeight_ += node->weight;
+        if (expireAt != 0) {
+            timerWheel_.reschedule(node, expireAt);
+        }
+        curTotalNum_ += freq;
+        stats_.inserts.add();
+        return last;
+    }
+
+    // expireAt 为绝对过期时间, 0 表示不过期
+    template<typename V>
+    void putImpl(const Key& key, V&& value, uint64_t expireAt = 0) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        NodePtr node = nodeMap_.find(key);
+        if (node != nullptr) {
+            // 在缓存中更改其value, 再增加node的频率并移动到新的频率列表
+            retired_.retire(node->value);
+            node->value = std::forward<V>(value);
+            updateExisting(node, expireAt);
+        }
+        else {
+            // 不在缓存中就加入
+            putInternal(key, expireAt, std::forward<V>(value));
+        }
+    }
+
+    // 值已经更新: 访问频次+1, 更新过期时间, 重新计算权重
+    void updateExisting(NodePtr node, uint64_t expireAt) {
+        touchNode(node);
+        node->markWritten();
+        if (node->expireAt_ != expireAt) {
+            timerWheel_.reschedule(node, expireAt);
+        }
+        reweigh(node);
+    }
+
+    // 回收定时轮中已经到期的节点, 没有设置过 TTL 的节点时不读时钟
+    void expireEntries() {
+        if (timerWheel_.empty()) return;
+        now_ = cacheNowNanos();
+        timerWheel_.advance(now_, [this](TimerEntry* entry) {
+            removeEntry(static_cast<NodePtr>(entry));
+            stats_.expirations.add();
+        });
+    }
 
-    void kickOut();                                     // 移除缓存中的过期数据
+    // 查找未过期的节点, 定时轮精度内还没回收的过期节点在这里回收; 调用方刚调用过 expireEntries()
+    NodePtr findLive(const Key& key, size_t hash) {
+        NodePtr node = nodeMap_.find(key, hash);
+        if (node != nullptr && node->isExpired(now_)) {
+            removeEntry(node);
+            stats_.expirations.add();
+            return nullptr;
+        }
+        return node;
+    }
+
+    template<typename... Args>
+    void putInternal(const Key& key, uint64_t expireAt, Args&&... args);   // 添加缓存, args 为值或值的构造参数
+    void getInternal(NodePtr node, Value& value);       // 获取缓存
+    void touchNode(NodePtr node);                       // 访问频次+1并移动到新的频次链表
+
+    void removeEntry(NodePtr node);                     // 从频次链表、索引和定时轮中移除节点并释放
+    void kickOut();                                     // 淘汰最小频次链表中最不常访问的节点
+    void makeRoom(size_t weight);                       // 淘汰节点直到能再放下 weight 的权重
+    void reweigh(NodePtr node);                         // 节点的值更新后重新计算权重
+    size_t weigh(NodePtr node) const {
+        return weigher_ ? std::max<size_t>(1, weigher_(node->key, node->value)) : 1;
+    }
 
-    void removeFromFreqList(NodePtr node);              // 从频率列表中移除节点
-    void addToFreqList(NodePtr node);                   // 添加到频率列表
+    List* insertListAfter(List* prev, size_t freq);     // 在 prev 之后插入新的频次链表, prev 为空表示插到最前面
+    void removeList(List* list);                        // 回收空的频次链表
+    // 链表的有效频次: 扣除老化偏移量, 最小为 1
+    size_t effectiveFreq(const List* list) const {
+        return list->freq_ > agingOffset_ ? list->freq_ - agingOffset_ : 1;
+    }
     
     void addFreqNum();                                  // 添加平均访问频率
-    void decreaseFreqNum(int num);                      // 减少平均访问频率
+    void decreaseFreqNum(size_t num);                   // 减少平均访问频率
     void handleOverMaxAverageNum();                     // 处理当前平均访问频率超过上限的情况
-    void updateMinFreq();
 
 private:
-    int capacity_;                                                      // 缓存容量
-    int minFreq_;                                                       // 最小访问频次(用于找到最小访问频次结点)
+    size_t capacity_;                                                   // 缓存容量(设置权重函数时为总权重预算)
+    size_t usedWeight_;                                                 // 当前所有条目的权重之和
     int maxAverageNum_;                                                 // 最大平均访问频次
-    int curAverageNum_;                                                 // 当前平均访问频次
-    int curTotalNum_;                                                   // 当前访问所有缓存次数总数
-    std::mutex mutex_;                                                  // 互斥锁
+    size_t curAverageNum_;                                              // 当前平均访问频次
+    size_t curTotalNum_;                                                // 当前所有缓存有效频次总数(老化后为估计值)
+    size_t agingOffset_;                                                // 老化偏移量, 每次老化增加 maxAverageNum_ / 2
+    Weigher weigher_;                                                   // 权重函数, 为空时每个条目权重为 1
+    Mutex mutex_;                                                       // 互斥锁
+    CacheStats stats_;                                                  // 统计计数器(锁内更新)
+    NodePool<Node> nodePool_;                                           // 节点内存池
+    NodePool<List> listPool_;                                           // 频次链表内存池
     NodeMap nodeMap_;                                                   // key 到 缓存节点的映射
-    std::unordered_map<int, FreqList<Key, Value>*> freqToFreqList_;      // 访问频次搭配频次链表的映射
+    List* minList_;                                                     // 频次链表链的头, 即最小频次链表
+    List* floorList_;                                                   // 有效频次为 1 的链表中原始频次最大的一个, 没有时为空
+    TimerWheel timerWheel_;                                             // 设置了 TTL 的节点
+    RetireList<Value> retired_;                                         // 延迟释放的旧值
+    CacheEvictionListener<Key, Value> evictionListener_;                // 容量淘汰时的回调, 可以为空
+    uint64_t now_ = 0;                                                  // 最近一次读取的时间, 只在定时轮非空时更新
+    size_t recentMisses_ = 0;                                           // 上次 takeMisses() 以来的未命中次数
 };
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::getInternal(NodePtr node, Value& value) {
+template<typename Key, typename Value, typename Mutex, typename Hash>
+void LfuCache<Key, Value, Mutex, Hash>::getInternal(NodePtr node, Value& value) {
     // 找到之后需要将其从低访问频次链表移动到 +1 的访问频次链表中
     // 访问频次+1, 然后返回value值
     value = node->value;
-    // 从原有访问频次链表中删除节点
-    removeFromFreqList(node);
-    node->freq++;
-    addToFreqList(node);
-    // 如果当前node的访问频次等于minFreq + 1, 并且其前驱节点为空
-    // 则说明freqToFreqList_[node->freq - 1]的频次链表已经没有节点, 需要更新最小访问频次
-    if (node->freq - 1 == minFreq_ && freqToFreqList_[node->freq - 1]->isEmpty()) {
-        minFreq_++;
+    touchNode(node);
+    node->markRead();
+}
+
+/**
+ * 节点访问频次+1, O(1)
+ * · 有效频次大于 1 的链表, 原始频次 +1 的链表只可能是链上的下一个
+ * · 有效频次为 1 的链表(老化后可能有多个, 原始频次不同), 目标有效频次为 2, 对应 floorList_ 的下一个
+*/
+template<typename Key, typename Value, typename Mutex, typename Hash>
+void LfuCache<Key, Value, Mutex, Hash>::touchNode(NodePtr node) {
+    List* oldList = node->list;
+    List* prev = (effectiveFreq(oldList) == 1) ? floorList_ : oldList;
+    size_t newFreq = (effectiveFreq(oldList) == 1) ? agingOffset_ + 2 : oldList->freq_ + 1;
+
+    // 相邻的链表频次不对就在它前面创建一个新的链表
+    List* newList = prev->next_;
+    if (newList == nullptr || newList->freq_ != newFreq) {
+        newList = insertListAfter(prev, newFreq);
+    }
+
+    // 从原有访问频次链表中删除节点, 空链表直接回收
+    oldList->removeNode(node);
+    if (oldList->isEmpty()) {
+        removeList(oldList);
     }
+    newList->addNode(node);
 
     // 总访问频次和当前平均访问频次也增加
     addFreqNum();
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::putInternal(Key key, Value value) {
-    // 如果不在缓存中, 则需要判断缓存是否已满
-    if (nodeMap_.size() == capacity_) {
-        // 缓存已满, 删除最小频次列表的最不常访问节点, 并更新当前平均访问频次和总访问频次
-        kickOut();
+template<typename Key, typename Value, typename Mutex, typename Hash>
+template<typename... Args>
+void LfuCache<Key, Value, Mutex, Hash>::putInternal(const Key& key, uint64_t expireAt, Args&&... args) {
+    // 创建新节点, 单个条目就超过总预算时不缓存
+    NodePtr node = nodePool_.allocate(key, std::forward<Args>(args)...);
+    node->weight = weigh(node);
+    if (node->weight > capacity_) {
+        nodePool_.deallocate(node);
+        return;
     }
+    // 缓存放不下时, 删除最小频次列表的最不常访问节点, 并更新当前平均访问频次和总访问频次
+    makeRoom(node->weight);
 
-    // 创建新节点, 添加新节点, 更新最小访问频次
-    NodePtr node = std::make_shared<Node>(key, value);
     // 加入 key -> node 映射
-    nodeMap_[key] = node;
-    addToFreqList(node);
+    nodeMap_.insert(key, node);
+    usedWeight_ += node->weight;
+    // 新节点有效频次为 1, 放进 floorList_, 没有时在最前面创建一个
+    List* list = floorList_;
+    if (list == nullptr) {
+        list = insertListAfter(nullptr, agingOffset_ + 1);
+    }
+    list->addNode(node);
+    if (expireAt != 0) {
+        timerWheel_.reschedule(node, expireAt);
+    }
     addFreqNum();
-    minFreq_ = std::min(minFreq_, 1);
+    stats_.inserts.add();
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::kickOut() {
-    // 删掉最小访问频次列表的最不常访问节点
-    NodePtr node = freqToFreqList_[minFreq_]->getFirstNode();
-    removeFromFreqList(node);
+template<typename Key, typename Value, typename Mutex, typename Hash>
+void LfuCache<Key, Value, Mutex, Hash>::removeEntry(NodePtr node) {
+    List* list = node->list;
+    size_t freq = effectiveFreq(list);
+    list->removeNode(node);
+    if (list->isEmpty()) {
+        removeList(list);
+    }
     // 清空这个节点的映射
     nodeMap_.erase(node->key);
-    decreaseFreqNum(node->freq);
+    usedWeight_ -= node->weight;
+    decreaseFreqNum(freq);
+    timerWheel_.deschedule(node);
+    retired_.retire(node->value);
+    nodePool_.deallocate(node);
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::removeFromFreqList(NodePtr node) {
-    // 检查节点是否为空
-    if (node == nullptr) return;
-    // 从频次链表中删掉一个节点
-    auto freq = node->freq;
-    freqToFreqList_[freq]->removeNode(node);
+template<typename Key, typename Value, typename Mutex, typename Hash>
+void LfuCache<Key, Value, Mutex, Hash>::kickOut() {
+    // 删掉最小访问频次列表的最不常访问节点
+    NodePtr node = minList_->getFirstNode();
+    if (evictionListener_) evictionListener_(node->key, node->value, node->expireAt_);
+    removeEntry(node);
+    stats_.evictions.add();
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::addToFreqList(NodePtr node) {
-    // 检查节点是否为空
-    if (node == nullptr) return;
-    
-    // 添加进入相应的频次链表前需要判断该频次链表是否存在
-    auto freq = node->freq;
-    if (freqToFreqList_.find(node->freq) == freqToFreqList_.end()) {
-        //不存在则创建链表
-        freqToFreqList_[node->freq] = new FreqList<Key, Value>(node->freq);
+template<typename Key, typename Value, typename Mutex, typename Hash>
+void LfuCache<Key, Value, Mutex, Hash>::makeRoom(size_t weight) {
+    while (usedWeight_ + weight > capacity_ && !nodeMap_.empty()) {
+        kickOut();
     }
+}
 
-    freqToFreqList_[freq]->addNode(node);
+template<typename Key, typename Value, typename Mutex, typename Hash>
+void LfuCache<Key, Value, Mutex, Hash>::reweigh(NodePtr node) {
+    size_t weight = weigh(node);
+    usedWeight_ = usedWeight_ - node->weight + weight;
+    node->weight = weight;
+    // 新值变重后可能超出预算, 必要时连同这个节点本身一起淘汰
+    makeRoom(0);
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::addFreqNum() {
+template<typename Key, typename Value, typename Mutex, typename Hash>
+typename LfuCache<Key, Value, Mutex, Hash>::List* LfuCache<Key, Value, Mutex, Hash>::insertListAfter(List* prev, size_t freq) {
+    List* list = listPool_.allocate(freq);
+    List* next = (prev == nullptr) ? minList_ : prev->next_;
+    list->prev_ = prev;
+    list->next_ = next;
+    if (next != nullptr) next->prev_ = list;
+    if (prev != nullptr) {
+        prev->next_ = list;
+    }
+    else {
+        minList_ = list;
+    }
+    // 只会在 floorList_ 之后(或者最前面)插入有效频次为 1 的链表
+    if (effectiveFreq(list) == 1) {
+        floorList_ = list;
+    }
+    return list;
+}
+
+template<typename Key, typename Value, typename Mutex, typename Hash>
+void LfuCache<Key, Value, Mutex, Hash>::removeList(List* list) {
+    if (list == floorList_) {
+        // 前一个链表的原始频次更小, 有效频次同样为 1
+        floorList_ = list->prev_;
+    }
+    if (list->prev_ != nullptr) {
+        list->prev_->next_ = list->next_;
+    }
+    else {
+        minList_ = list->next_;
+    }
+    if (list->next_ != nullptr) list->next_->prev_ = list->prev_;
+    listPool_.deallocate(list);
+}
+
+template<typename Key, typename Value, typename Mutex, typename Hash>
+void LfuCache<Key, Value, Mutex, Hash>::addFreqNum() {
     // 每次curTotalNum + 1, 表示又有一个节点被访问了
     curTotalNum_++;
     if (nodeMap_.empty()) {
@@ -263,59 +766,45 @@ void LfuCache<Key, Value>::addFreqNum() {
         curAverageNum_ = curTotalNum_ / nodeMap_.size();
     }
 
-    if (curAverageNum_ > maxAverageNum_) {
+    if (curAverageNum_ > static_cast<size_t>(maxAverageNum_)) {
         handleOverMaxAverageNum();
     }
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::decreaseFreqNum(int num) {
+template<typename Key, typename Value, typename Mutex, typename Hash>
+void LfuCache<Key, Value, Mutex, Hash>::decreaseFreqNum(size_t num) {
     // 最小频次列表里最不常访问的节点被踢掉了, curTotalNum要减去它的频次
     // 减少平均访问频次和总访问频次
-    curTotalNum_ -= num;
+    curTotalNum_ -= std::min(curTotalNum_, num);
     if (nodeMap_.empty()) {
         curAverageNum_ = 0;
     }
     else {
-        curAverageNum_ -= curTotalNum_ / nodeMap_.size();
+        curAverageNum_ = curTotalNum_ / nodeMap_.size();
     }
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::handleOverMaxAverageNum() {
+/**
+ * 当前平均访问频次已经超过了最大平均访问频次, 所有节点的访问频次 - (maxAverage_ / 2)
+ * · 只增加老化偏移量, 再把 floorList_ 向后推进到新的有效频次为 1 的位置
+ * · floorList_ 只会向后移动, 每个链表最多被越过一次, 均摊 O(1)
+ * · 频次被截断到 1 的节点实际减少得更少, 这里按全部减少估计总访问频次, 平均值偏低只会让下次老化稍晚一些
+*/
+template<typename Key, typename Value, typename Mutex, typename Hash>
+void LfuCache<Key, Value, Mutex, Hash>::handleOverMaxAverageNum() {
     if (nodeMap_.empty()) return;
 
-    // 当前平均访问频次已经超过了最大平均访问频次, 所有节点的访问频次 - (maxAverage_ / 2)
-    for (auto it = nodeMap_.begin(); it != nodeMap_.end(); it++) {
-        // 检查节点是否为空
-        if (it->second == nullptr) continue;
-
-        NodePtr node = it->second;
-
-        // 先从当前频率列表中移除
-        removeFromFreqList(node);
-
-        // 减少频率
-        node->freq -= maxAverageNum_ / 2;
-        if (node->freq < 1) node->freq = 1;
-
-        // 添加到新的频率列表
-        addToFreqList(node);
+    size_t delta = std::max(1, maxAverageNum_ / 2);
+    agingOffset_ += delta;
+    List* list = (floorList_ == nullptr) ? minList_ : floorList_->next_;
+    while (list != nullptr && effectiveFreq(list) == 1) {
+        floorList_ = list;
+        list = list->next_;
     }
-    // 处理完最大访问频次溢出后根据频次列表更新最小访问频次
-    updateMinFreq();
-}
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::updateMinFreq() {
-    minFreq_ = INT8_MAX;
-    // 根据频次列表来更新最小访问频次
-    for (const auto& pair: freqToFreqList_) {
-        if (pair.second && !pair.second->isEmpty()) {
-            minFreq_ = std::min(minFreq_, pair.first);
-        }
-    }
-    if (minFreq_ == INT8_MAX) minFreq_ = 1;
+    size_t size = nodeMap_.size();
+    curTotalNum_ = (curTotalNum_ > delta * size + size) ? curTotalNum_ - delta * size : size;
+    curAverageNum_ = curTotalNum_ / size;
 }
 
 /**
@@ -327,47 +816,20 @@ void LfuCache<Key, Value>::updateMinFreq() {
 
 
 // 对缓存空间切片, 实现hashLFU
-template<typename Key, typename Value>
-class HashLfuCache {
+template<typename Key, typename Value, typename Hash = CacheHash<Key>, typename Resize = FixedShards, typename Mutex = std::mutex>
+class HashLfuCache : public ShardedCacheStrategy<LfuCache<Key, Value, Mutex, Hash>, 0, Hash, NullShardLock, SumShardStats, Resize> {
 public:
-    HashLfuCache(size_t capacity, int sliceNum, int maxAverageNum = 10) 
-        : sliceNum_(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency())
-        , capacity_(capacity) {
-        size_t sliceSize = std::ceil(capacity_ / static_cast<double>(sliceNum_));     // 切片容量
-        for (int i = 0; i < sliceNum; i++) {
-            lfuSliceCaches_.emplace_back(new LfuCache<Key, Value>(sliceSize, maxAverageNum));
-        }
-    }
+    using Base = ShardedCacheStrategy<LfuCache<Key, Value, Mutex, Hash>, 0, Hash, NullShardLock, SumShardStats, Resize>;
 
-    void put(Key key, Value value) {
-        size_t sliceIndex = Hash(key) % sliceNum_;
-        return lfuSliceCaches_[sliceIndex]->get(key, value);
-    }
-
-    Value get(Key key) {
-        Value value;
-        get(key, value);
-        return value;
-    }
-
-    // 清除缓存
-    void purge() {
-        for (auto& lfuSliceCache: lfuSliceCaches_) {
-            lfuSliceCache.purge();
-        }
-    }
+    // 设置 weigher 后 capacity 为总权重预算, 平均分给各分片
+    HashLfuCache(size_t capacity, int sliceNum, int maxAverageNum = 10, CacheWeigher<Key, Value> weigher = nullptr)
+        : Base(capacity, sliceNum, maxAverageNum, weigher)
+    {}
 
-private:
-    // hash映射
-    size_t Hash(Key key) {
-        std::hash<Key> hashFunc;
-        return hashFunc(key);
+    // 分片间容量再平衡(由调用方定期调用), 按各分片上个周期的未命中次数分配, 见 ShardedCache::rebalanceCapacity()
+    void rebalanceCapacity(size_t minSliceCapacity = 1) {
+        this->sharded_.rebalanceCapacity([](LfuCache<Key, Value, Mutex, Hash>& slice) { return slice.takeMisses(); }, minSliceCapacity);
     }
-
-private:
-    size_t capacity_;       // 缓存总容量
-    int sliceNum_;          // 切片数量
-    std::vector<std::unique_ptr<LfuCache<Key, Value>>> lfuSliceCaches_; //保存切片的容器
 };
 
 } // namespace Cache
\ No newline at end of file
@@ -1,48 +1,76 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstring>
+#include <functional>
 #include <thread>
+#include <utility>
 #include <cmath>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <string>
 #include <vector>
-#include <unordered_map>
 
 #include "CacheStrategy.h"
+#include "CacheBatch.h"
+#include "CacheSharded.h"
+#include "CacheNodePool.h"
+#include "CacheFlatIndex.h"
+#include "CacheTimerWheel.h"
+#include "CacheSnapshot.h"
+#include "CacheMaintenance.h"
+#include "CacheLock.h"
+#include "ArcCache/ArcGhostList.h"
 
 namespace Cache {
 
-template<typename Key, typename Value> class LruCache;
+template<typename Key, typename Value, typename Mutex = std::mutex, typename Hash = CacheHash<Key>> class LruCache;
+template<typename Key, typename Value> class LruList;
+template<typename Key, typename Value, typename Derived, typename Mutex, typename Hash> class SegmentedLruBase;
+template<typename Key, typename Value, typename Mutex = std::mutex, typename Hash = CacheHash<Key>> class SlruCache;
+template<typename Key, typename Value, typename Mutex = std::mutex, typename Hash = CacheHash<Key>> class TwoQueueCache;
 
+// 继承 TimerEntry, 设置了 TTL 的节点挂在所属缓存的定时轮上
 template<typename Key, typename Value>
-class LruNode {
+class LruNode : public TimerEntry {
 private:
     Key key_;
     Value value_;
     size_t accessCount_; //访问次数
-    std::shared_ptr<LruNode<Key, Value>> prev_;
-    std::shared_ptr<LruNode<Key, Value>> next_;
+    size_t weight_;      // 条目权重, 插入和更新值时由缓存计算
+    LruNode<Key, Value>* prev_;     // 侵入式链表指针, 节点内存由 NodePool 管理
+    LruNode<Key, Value>* next_;
 
 public:
-    LruNode(Key key, Value value)
+    // 值用剩余参数原地构造, 可以传入已有的值(拷贝/移动)或者值的构造参数
+    template<typename... Args>
+    explicit LruNode(const Key& key, Args&&... args)
         : key_(key)
-        , value_(value)
+        , value_(std::forward<Args>(args)...)
         , accessCount_(1)
+        , weight_(1)
         , prev_(nullptr)
         , next_(nullptr)
     {}
 
     // 提供必要的访问器
-    Key getKey() const { 
+    const Key& getKey() const { 
         return key_; 
     }
-    Value getValue() const { 
+    // 返回引用, 调用方在锁内只做一次拷贝
+    const Value& getValue() const { 
         return  value_; 
     }
     void setValue(const Value& value) { 
         value_ = value; 
     }
+    void setValue(Value&& value) {
+        value_ = std::move(value);
+    }
     size_t getAccessCount() const { 
         return accessCount_; 
     }
@@ -50,129 +78,790 @@ public:
         accessCount_++; 
     }
 
-    friend class LruCache<Key, Value>;
+    template<typename, typename, typename, typename> friend class LruCache;
+    friend class LruList<Key, Value>;
+    template<typename, typename, typename, typename, typename> friend class SegmentedLruBase;
+    template<typename, typename, typename, typename> friend class SlruCache;
+    template<typename, typename, typename, typename> friend class TwoQueueCache;
 };
 
 
+/**
+ * LRU 系列策略共用的侵入式双向链表: 头部是最久未访问的一端, 尾部是最近访问的一端
+ * 首尾虚拟节点内嵌在链表对象里, 其余节点的内存由所属缓存的 NodePool 管理
+ * 同时维护链表上的节点数和权重之和, LruCache 用它作为总权重, SLRU/2Q 用它控制各分段的大小
+ * 本身不加锁, 由所属缓存的锁保护
+*/
 template<typename Key, typename Value>
+class LruList {
+public:
+    using NodePtr = LruNode<Key, Value>*;
+
+    LruList()
+        : head_(Key(), Value())
+        , tail_(Key(), Value())
+    {
+        reset();
+    }
+
+    LruList(const LruList&) = delete;
+    LruList& operator=(const LruList&) = delete;
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    // 链表上所有节点的权重之和, 节点在链表上时不能修改它的 weight_
+    size_t weight() const {
+        return weight_;
+    }
+
+    // 最久未访问的节点, 链表为空时返回空
+    NodePtr front() const {
+        return size_ == 0 ? nullptr : head_.next_;
+    }
+
+    // 插入到最近访问的一端
+    void pushBack(NodePtr node) {
+        node->next_ = &tail_;
+        node->prev_ = tail_.prev_;
+        tail_.prev_->next_ = node;
+        tail_.prev_ = node;
+        size_++;
+        weight_ += node->weight_;
+    }
+
+    void remove(NodePtr node) {
+        node->prev_->next_ = node->next_;
+        node->next_->prev_ = node->prev_;
+        size_--;
+        weight_ -= node->weight_;
+    }
+
+    // 链表上的节点权重改变时调用, 不调整位置
+    void reweigh(NodePtr node, size_t weight) {
+        weight_ = weight_ - node->weight_ + weight;
+        node->weight_ = weight;
+    }
+
+    // 移动到最近访问的一端
+    void moveToBack(NodePtr node) {
+        node->prev_->next_ = node->next_;
+        node->next_->prev_ = node->prev_;
+        node->next_ = &tail_;
+        node->prev_ = tail_.prev_;
+        tail_.prev_->next_ = node;
+        tail_.prev_ = node;
+    }
+
+    // 从最久未访问到最近访问遍历; 先取出后继再调用 func, func 可以直接释放节点(之后必须调用 reset())
+    template<typename Func>
+    void forEach(Func&& func) {
+        NodePtr node = head_.next_;
+        while (node != &tail_) {
+            NodePtr next = node->next_;
+            func(node);
+            node = next;
+        }
+    }
+
+    // 清空链表但不释放节点
+    void reset() {
+        head_.next_ = &tail_;
+        tail_.prev_ = &head_;
+        size_ = 0;
+        weight_ = 0;
+    }
+
+private:
+    LruNode<Key, Value> head_;  // 虚拟头节点
+    LruNode<Key, Value> tail_;  // 虚拟尾节点
+    size_t size_ = 0;
+    size_t weight_ = 0;
+};
+
+
+/**
+ * Mutex 为锁策略, 见 CacheLock.h, 默认 std::mutex; 不使用读优化时 get() 需要独占锁, Mutex 支持共享锁时 contains() 等只读操作共享
+ * 读优化模式需要读写锁: Mutex 本身不支持共享锁时由 OptionalSharedMutex 自带一把, 只在这个模式下启用
+*/
+template<typename Key, typename Value, typename Mutex, typename Hash>
 class LruCache : public CacheStrategy<Key, Value> {
     public:
     using LruNodeType = LruNode<Key, Value>;
-    using NodePtr = std::shared_ptr<LruNodeType>;
-    using NodeMap = std::unordered_map<Key, NodePtr>;
+    using NodePtr = LruNodeType*;
+    using NodeMap = FlatNodeIndex<Key, LruNodeType, Hash>;
+
+    using Weigher = CacheWeigher<Key, Value>;
+    // 实际使用的锁: Mutex 不支持共享锁时自带一把读写锁, 只在读优化模式下启用
+    using LockType = CacheSharedCapableMutex<Mutex>;
 
-    LruCache(int capacity): capacity_(capacity) {
-        initializeList();
+    // 内存池预留 capacity 个节点, 首尾虚拟节点内嵌在链表里
+    // readOptimized 为 true 时开启读优化模式: get() 只持有共享锁, 访问记录先缓冲再批量提升
+    // 设置 weigher 后 capacity 表示总权重预算, 条目数未知, 内存池和索引不再按容量预留
+    LruCache(size_t capacity, bool readOptimized = false, Weigher weigher = nullptr)
+        : capacity_(capacity)
+        , readOptimized_(readOptimized)
+        , weigher_(std::move(weigher))
+        , nodePool_(weigher_ ? 0 : capacity)
+        , nodeMap_(weigher_ ? 0 : capacity)
+    {
+        this->template useLoadHash<Hash>();
+        if constexpr (!IsSharedMutex<Mutex>::value) {
+            mutex_.setShared(readOptimized_);
+        }
     }
 
-    ~LruCache() override = default;
+    ~LruCache() override {
+        this->cancelLoads();
+        // 归还链表上的所有节点
+        list_.forEach([this](NodePtr node) { nodePool_.deallocate(node); });
+    }
 
     // 在LRU中, put()和get()都会把节点移到到最常访问的位置
     // 添加缓存
-    void put(Key key, Value value) override {
-        if (capacity_ <= 0) return;
+    void put(const Key& key, const Value& value) override {
+        putImpl(key, value);
+    }
 
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = nodeMap_.find(key);
-        if (it != nodeMap_.end()) {
-            // 如果key在当前容器中则更新value, 并调用get()方法, 代表该数据刚被访问
-            updateExistingNode(it->second, value);
+    void put(const Key& key, Value&& value) override {
+        putImpl(key, std::move(value));
+    }
+
+    // 带 TTL 的添加: ttl 之后条目失效, 由定时轮回收; 不带 ttl 的 put()/emplace() 会清除已有的过期时间
+    void put(const Key& key, const Value& value, std::chrono::nanoseconds ttl) {
+        putImpl(key, value, cacheExpireAt(ttl));
+    }
+
+    void put(const Key& key, Value&& value, std::chrono::nanoseconds ttl) {
+        putImpl(key, std::move(value), cacheExpireAt(ttl));
+    }
+
+    // key 不存在时直接在新节点里构造值; key 已存在时构造新值并移动赋值
+    template<typename... Args>
+    void emplace(const Key& key, Args&&... args) {
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        drainReadBuffers();
+        expireEntries();
+        NodePtr node = findLive(key, nodeMap_.hash(key));
+        if (node != nullptr) {
+            updateExistingNode(node, Value(std::forward<Args>(args)...), 0);
         }
         else {
-            addNewNode(key, value);
+            addNewNode(key, 0, std::forward<Args>(args)...);
         }
-        return;
     }
     
-    bool get(Key key, Value& value) override {
-        std:: lock_guard<std::mutex> lock(mutex_);     
-        auto it = nodeMap_.find(key);
-        bool flag = false;
-        if (it != nodeMap_.end()) {
-            moveToMostRecent(it->second);
-            value = it->second->getValue();
-            flag = true;
+    bool get(const Key& key, Value& value) override {
+        if (readOptimized_) return getShared(key, value);
+        if constexpr (SkipsContendedPromotion<Mutex>::value) {
+            if (!mutex_.try_lock()) return getWithoutPromotion(key, value);
+            std::lock_guard<LockType> lock(mutex_, std::adopt_lock);
+            return getLocked(key, value);
+        }
+        else {
+            StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+            return getLocked(key, value);
         }
-        return flag;
     }
 
-    Value get(Key key) override {
+    Value get(const Key& key) override {
         Value value{};
         // memset(& value, 0, sizeof(value)); memset是按字节设置内存的，对于复杂类型（如 string）使用 memset 可能会破坏对象的内部结构
         get(key, value);
         return value;
     }
 
+    size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) override {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        return getBatch(keys, nullptr, keys.size(), values, found);
+    }
+
+    void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) override {
+        putBatch(keys, values, nullptr, std::min(keys.size(), values.size()));
+    }
+
+    /**
+     * 批量查找的分片入口: 只处理 indices 指定的 count 个下标(indices 为空表示 0..count-1), 整批只加一次锁
+     * values/found 由调用方预先调整好大小, 返回命中个数
+    */
+    size_t getBatch(const std::vector<Key>& keys, const size_t* indices, size_t count,
+                    std::vector<Value>& values, std::vector<bool>& found) {
+        if (readOptimized_) return getBatchShared(keys, indices, count, values, found);
+        if constexpr (SkipsContendedPromotion<Mutex>::value) {
+            if (!mutex_.try_lock()) return getBatchWithoutPromotion(keys, indices, count, values, found);
+            std::lock_guard<LockType> lock(mutex_, std::adopt_lock);
+            return getBatchLocked(keys, indices, count, values, found);
+        }
+        else {
+            StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+            return getBatchLocked(keys, indices, count, values, found);
+        }
+    }
+
+    // 批量添加的分片入口, 下标含义同 getBatch()
+    void putBatch(const std::vector<Key>& keys, const std::vector<Value>& values, const size_t* indices, size_t count) {
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        drainReadBuffers();
+        expireEntries();
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            NodePtr node = nodeMap_.find(keys[i], hash);
+            if (node != nullptr) {
+                updateExistingNode(node, values[i], 0);
+            }
+            else {
+                addNewNode(keys[i], 0, values[i]);
+            }
+        });
+    }
+
+    // 只判断 key 是否在缓存中(已过期的不算), 不调整访问顺序也不拷贝值
+    bool contains(const Key& key) override {
+        SharedLockGuard<LockType> lock(mutex_);
+        NodePtr node = nodeMap_.find(key);
+        return node != nullptr && !expiredUnderSharedLock(node);
+    }
+
     // 删除指定元素
-    void remove(Key key) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = nodeMap_.find(key);
-        if (it != nodeMap_.end()) {
-            removeNode(it->second);
-            nodeMap_.erase(it);
+    void remove(const Key& key) override {
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        drainReadBuffers();
+        NodePtr node = nodeMap_.find(key);
+        if (node != nullptr) {
+            list_.remove(node);
+            nodeMap_.erase(key);
+            timerWheel_.deschedule(node);
+            retired_.retire(node->value_);
+            nodePool_.deallocate(node);
+        }
+    }
+
+    // 立即回收所有已经到期的条目; 读写操作本身也会顺带回收, 这里用于长时间没有写入的缓存
+    void purgeExpired() {
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        drainReadBuffers();
+        expireEntries();
+    }
+
+    // 清空缓存
+    void purge() {
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        drainReadBuffers();
+        clearLocked();
+    }
+
+    // 调整容量(设置权重函数时为总权重预算), 变小时从最久未访问的一端淘汰
+    void resize(size_t capacity) {
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        drainReadBuffers();
+        expireEntries();
+        capacity_ = capacity;
+        while (list_.weight() > capacity_) {
+            evictLeastRecent();
+        }
+    }
+
+    size_t getCapacity() {
+        SharedLockGuard<LockType> lock(mutex_);
+        return capacity_;
+    }
+
+    // 返回并清零上次调用以来的未命中次数, 用于分片间的容量再平衡; 不受 CACHE_ENABLE_STATS 影响
+    size_t takeMisses() {
+        return recentMisses_.exchange(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * 取出所有未过期的条目: 按最久未访问到最近访问的顺序调用 func(key, value, expireAt), value 可以被移走, 之后缓存为空
+     * 用于调整分片数时把条目迁移到新的分片; func 在锁内调用, 不能再访问这个缓存
+    */
+    template<typename Func>
+    void drainEntries(Func&& func) {
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        drainReadBuffers();
+        expireEntries();
+        list_.forEach([&](NodePtr node) {
+            func(node->key_, node->value_, node->expireAt_);
+        });
+        clearLocked();
+    }
+
+    // 淘汰监听器, 传入空函数时取消; 见 CacheEvictionListener
+    void setEvictionListener(CacheEvictionListener<Key, Value> listener) {
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        evictionListener_ = std::move(listener);
+    }
+
+    /**
+     * 延迟释放: 开启后淘汰、过期、覆盖和删除的旧值不在锁内析构, 而是移进待释放列表(RetireList),
+     * 由 runMaintenance() 在锁外统一析构; 通常由 CacheMaintainer 开启和关闭
+    */
+    void setDeferredRelease(bool enabled) {
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        retired_.setEnabled(enabled);
+    }
+
+    // 节点内存池和索引绑定到 NUMA 节点 node, 已有的内存一并迁移; 通常由分片缓存的 placeShardsOnNumaNodes() 调用
+    void setNumaNode(int node) {
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        nodePool_.setNumaNode(node);
+        nodeMap_.setNumaNode(node);
+    }
+
+    // 一次后台维护: 排空读缓冲区、回收到期条目, 待释放的旧值在锁外析构
+    void runMaintenance() {
+        std::vector<Value> retired;
+        {
+            StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+            drainReadBuffers();
+            expireEntries();
+            retired = retired_.take();
+        }
+    }
+
+    // window 之内到期、并且上次写入之后被读过的条目的 key, 用于提前刷新; 只持有共享锁
+    std::vector<Key> expiringKeys(std::chrono::nanoseconds window) {
+        std::vector<Key> keys;
+        SharedLockGuard<LockType> lock(mutex_);
+        if (timerWheel_.empty()) return keys;
+        timerWheel_.forEachExpiringBefore(cacheNowNanos() + static_cast<uint64_t>(window.count()), [&](TimerEntry* entry) {
+            if (entry->readSinceWrite()) keys.push_back(static_cast<NodePtr>(entry)->key_);
+        });
+        return keys;
+    }
+
+    /**
+     * 提前刷新的写回: 只替换已有条目的值并以 ttl 续期, 不调整访问顺序, 也不算一次访问
+     * 条目已经被淘汰或过期时不重新插入, 返回 false
+    */
+    template<typename V>
+    bool refresh(const Key& key, V&& value, std::chrono::nanoseconds ttl) {
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        drainReadBuffers();
+        expireEntries();
+        NodePtr node = findLive(key, nodeMap_.hash(key));
+        if (node == nullptr) return false;
+        retired_.retire(node->value_);
+        node->setValue(std::forward<V>(value));
+        node->markWritten();
+        timerWheel_.reschedule(node, cacheExpireAt(ttl));
+        list_.reweigh(node, weigh(node));
+        while (list_.weight() > capacity_) {
+            evictLeastRecent();
+        }
+        return true;
+    }
+
+    /**
+     * 保存快照: 按最久未访问到最近访问的顺序写出每个条目的 key、value、访问次数和剩余 TTL
+     * 保存期间持有独占锁; 成功返回 true
+    */
+    template<typename KeySerializer = CacheSerializer<Key>, typename ValueSerializer = CacheSerializer<Value>>
+    bool saveSnapshot(const std::string& path) {
+        SnapshotWriter out(path);
+        if (!out.ok()) return false;
+        {
+            StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+            drainReadBuffers();
+            expireEntries();
+            uint64_t now = timerWheel_.empty() ? 0 : now_;
+            uint64_t count = 0;
+            list_.forEach([&](NodePtr node) {
+                if (!node->isExpired(now)) count++;
+            });
+            out.writeHeader(SnapshotPolicy::Lru, count);
+            list_.forEach([&](NodePtr node) {
+                uint64_t remaining = 0;
+                if (!snapshotRemainingTtl(node->expireAt_, now, remaining)) return;
+                KeySerializer::write(out, node->key_);
+                ValueSerializer::write(out, node->value_);
+                out.writePod(static_cast<uint64_t>(node->accessCount_));
+                out.writePod(remaining);
+            });
         }
+        return out.commit();
+    }
+
+    /**
+     * 载入快照: 先清空缓存, 再按快照中的顺序插入, 恢复访问顺序和访问次数; 快照超出容量时最久未访问的被淘汰
+     * 文件不存在、格式不对或者被截断时返回 false, 截断前的条目会保留在缓存中
+    */
+    template<typename KeySerializer = CacheSerializer<Key>, typename ValueSerializer = CacheSerializer<Value>>
+    bool loadSnapshot(const std::string& path) {
+        SnapshotReader in(path);
+        uint64_t count = 0;
+        uint64_t elapsed = 0;
+        if (!in.ok() || !in.readHeader(SnapshotPolicy::Lru, count, elapsed)) return false;
+
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        drainReadBuffers();
+        clearLocked();
+        if (!weigher_) nodeMap_.reserve(std::min<uint64_t>(count, capacity_));
+        uint64_t now = cacheNowNanos();
+        for (uint64_t i = 0; i < count; i++) {
+            Key key{};
+            Value value{};
+            uint64_t accessCount = 0;
+            uint64_t remaining = 0;
+            if (!KeySerializer::read(in, key) || !ValueSerializer::read(in, value)
+                || !in.readPod(accessCount) || !in.readPod(remaining)) {
+                return false;
+            }
+            uint64_t expireAt = 0;
+            if (capacity_ == 0 || !snapshotRestoreExpireAt(remaining, elapsed, now, expireAt)) continue;
+            NodePtr node = nodeMap_.find(key);
+            if (node != nullptr) {
+                updateExistingNode(node, std::move(value), expireAt);
+                continue;
+            }
+            node = addNewNode(key, expireAt, std::move(value));
+            if (node != nullptr) {
+                node->accessCount_ = std::max<uint64_t>(1, accessCount);
+            }
+        }
+        return true;
+    }
+
+    // 计数器无锁读取, 只有当前条目数需要在锁内读
+    CacheStatsSnapshot getStats() override {
+        CacheStatsSnapshot snapshot;
+        stats_.addTo(snapshot);
+        for (const ReadBuffer& buffer: readBuffers_) {
+            snapshot.hits += buffer.hits.load();
+            snapshot.misses += buffer.misses.load();
+        }
+        SharedLockGuard<LockType> lock(mutex_);
+        snapshot.size = nodeMap_.size();
+        snapshot.weight = list_.weight();
+        return snapshot;
     }
 
 private:
-    int capacity_;          //缓存容量
+    /**
+     * 读优化模式下的访问缓冲区
+     * · 按线程分条带, 每个线程只往自己条带对应的缓冲区里追加本次命中的节点
+     * · 读者只在共享锁内写缓冲区, 写者持有独占锁时先把缓冲区里的访问记录批量应用到LRU链表,
+     *   因为节点只会在独占锁内被释放, 缓冲区里的节点指针在排空之前一定有效
+     * · 缓冲区写满后的访问记录直接丢弃, 相当于对LRU提升做采样, 只影响近似程度, 不影响正确性
+    */
+    static constexpr size_t kReadBufferStripes = 16;
+    static constexpr size_t kReadBufferSize = 64;
+
+    struct alignas(64) ReadBuffer {
+        std::atomic<size_t> writeCount{0};
+        StatCounter hits;       // 共享锁内(读优化或跳过提升)的命中/未命中也按条带计数, 避免所有读者争同一个计数器
+        StatCounter misses;
+        NodePtr nodes[kReadBufferSize];
+    };
+
+    size_t capacity_;       //缓存容量(设置权重函数时为总权重预算)
+    bool readOptimized_;    // 是否开启读优化模式
+    Weigher weigher_;       // 权重函数, 为空时每个条目权重为 1
+    NodePool<LruNodeType> nodePool_;    // 节点内存池
     NodeMap nodeMap_;       // key -> node
-    std::mutex mutex_;
-    NodePtr dummyHead_;     // 虚拟头节点
-    NodePtr dummyTail_;
+    LockType mutex_;
+    CacheStats stats_;      // 统计计数器(锁内更新)
+    ReadBuffer readBuffers_[kReadBufferStripes];
+    TimerWheel timerWheel_; // 设置了 TTL 的节点
+    RetireList<Value> retired_;     // 延迟释放的旧值
+    CacheEvictionListener<Key, Value> evictionListener_;   // 容量淘汰时的回调, 可以为空
+    uint64_t now_ = 0;      // 独占锁内最近一次读取的时间, 只在定时轮非空时更新
+    std::atomic<size_t> recentMisses_{0};   // 上次 takeMisses() 以来的未命中次数
+    LruList<Key, Value> list_;  // 访问顺序, 权重之和即当前总权重
 
 private:
-    void initializeList() {
-        // 创建首尾虚拟节点
-        dummyHead_ = std::make_shared<LruNodeType>(Key(), Value());
-        dummyTail_ = std::make_shared<LruNodeType>(Key(), Value());
-        dummyHead_->next_ = dummyTail_;
-        dummyTail_->prev_ = dummyHead_;
+    // expireAt 为绝对过期时间, 0 表示不过期
+    template<typename V>
+    void putImpl(const Key& key, V&& value, uint64_t expireAt = 0) {
+        StatsLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        drainReadBuffers();
+        expireEntries();
+        NodePtr node = nodeMap_.find(key);
+        if (node != nullptr) {
+            // 如果key在当前容器中则更新value, 并调用get()方法, 代表该数据刚被访问
+            updateExistingNode(node, std::forward<V>(value), expireAt);
+        }
+        else {
+            addNewNode(key, expireAt, std::forward<V>(value));
+        }
     }
 
-    void updateExistingNode(NodePtr node, const Value& value) {
-        node->setValue(value);
-        moveToMostRecent(node);
+    /**
+     * 回收定时轮中已经到期的节点, 调用方必须持有独占锁, 并且已经排空读缓冲区
+     * 没有设置过 TTL 的节点时只比较一次定时轮大小, 不读时钟
+    */
+    void expireEntries() {
+        if (timerWheel_.empty()) return;
+        now_ = cacheNowNanos();
+        timerWheel_.advance(now_, [this](TimerEntry* entry) {
+            removeExpired(static_cast<NodePtr>(entry));
+        });
     }
 
-    void addNewNode(const Key& key, const Value& value) {
-        if (nodeMap_.size() >= capacity_) {
-            evictLeastRecent();
+    // 查找未过期的节点; 定时轮精度内还没回收的过期节点在这里回收, 调用方持有独占锁并且刚调用过 expireEntries()
+    NodePtr findLive(const Key& key, size_t hash) {
+        NodePtr node = nodeMap_.find(key, hash);
+        if (node != nullptr && node->isExpired(now_)) {
+            removeExpired(node);
+            return nullptr;
         }
+        return node;
+    }
 
-        NodePtr newNode = std::make_shared<LruNodeType>(key, value);
-        insertNode(newNode);
-        nodeMap_[key] = newNode;
+    // 共享锁内只能判断是否过期, 回收留给下一次持有独占锁的操作
+    bool expiredUnderSharedLock(NodePtr node) const {
+        return node->expireAt_ != 0 && node->isExpired(cacheNowNanos());
     }
 
-    // 移动节点到最新位置
-    void moveToMostRecent(NodePtr node) {
-        removeNode(node);
-        insertNode(node);
+    void removeExpired(NodePtr node) {
+        list_.remove(node);
+        nodeMap_.erase(node->getKey());
+        timerWheel_.deschedule(node);
+        retired_.retire(node->value_);
+        nodePool_.deallocate(node);
+        stats_.expirations.add();
     }
 
-    void removeNode(NodePtr node) {
-        node->prev_->next_ = node->next_;
-        node->next_->prev_ = node->prev_;
+    // 持有独占锁的查找: 命中时移动到最近访问端
+    bool getLocked(const Key& key, Value& value) {
+        expireEntries();
+        NodePtr node = findLive(key, nodeMap_.hash(key));
+        bool flag = false;
+        if (node != nullptr) {
+            moveToMostRecent(node);
+            node->markRead();
+            value = node->getValue();
+            flag = true;
+            stats_.hits.add();
+        }
+        else {
+            stats_.misses.add();
+            recentMisses_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return flag;
     }
 
-    // 从尾部插入节点
-    void insertNode(NodePtr node) {
-        node->next_ = dummyTail_;
-        dummyTail_->prev_->next_ = node;
-        node->prev_ = dummyTail_->prev_;
-        dummyHead_->prev_ = node;
+    // 持有独占锁的批量查找
+    size_t getBatchLocked(const std::vector<Key>& keys, const size_t* indices, size_t count,
+                          std::vector<Value>& values, std::vector<bool>& found) {
+        size_t hits = 0;
+        expireEntries();
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            NodePtr node = findLive(keys[i], hash);
+            if (node != nullptr) {
+                moveToMostRecent(node);
+                node->markRead();
+                values[i] = node->getValue();
+                found[i] = true;
+                hits++;
+            }
+        });
+        stats_.hits.add(hits);
+        stats_.misses.add(count - hits);
+        if (hits != count) recentMisses_.fetch_add(count - hits, std::memory_order_relaxed);
+        return hits;
+    }
+
+    /**
+     * 争用时跳过提升(SkipPromotionOnContention): 独占锁被占用时只在共享锁内查找并拷贝值, 不调整链表
+     * 过期判断与读优化模式相同, 回收留给下一次持有独占锁的操作
+    */
+    bool getWithoutPromotion(const Key& key, Value& value) {
+        static_assert(IsSharedMutex<Mutex>::value, "SkipPromotionOnContention requires a shared mutex");
+        StatsSharedLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        ReadBuffer& buffer = readBuffers_[threadStripe()];
+        NodePtr node = nodeMap_.find(key);
+        if (node == nullptr || expiredUnderSharedLock(node)) {
+            buffer.misses.addShared();
+            recentMisses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        node->markRead();
+        value = node->getValue();
+        buffer.hits.addShared();
+        return true;
+    }
+
+    size_t getBatchWithoutPromotion(const std::vector<Key>& keys, const size_t* indices, size_t count,
+                                    std::vector<Value>& values, std::vector<bool>& found) {
+        static_assert(IsSharedMutex<Mutex>::value, "SkipPromotionOnContention requires a shared mutex");
+        size_t hits = 0;
+        StatsSharedLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+        ReadBuffer& buffer = readBuffers_[threadStripe()];
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            NodePtr node = nodeMap_.find(keys[i], hash);
+            if (node != nullptr && !expiredUnderSharedLock(node)) {
+                node->markRead();
+                values[i] = node->getValue();
+                found[i] = true;
+                hits++;
+            }
+        });
+        buffer.hits.addShared(hits);
+        buffer.misses.addShared(count - hits);
+        if (hits != count) recentMisses_.fetch_add(count - hits, std::memory_order_relaxed);
+        return hits;
+    }
+
+    // 读优化模式的 get(): 查找和拷贝值只持有共享锁, 不直接调整链表
+    bool getShared(const Key& key, Value& value) {
+        bool shouldDrain = false;
+        {
+            StatsSharedLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+            ReadBuffer& buffer = readBuffers_[threadStripe()];
+            NodePtr node = nodeMap_.find(key);
+            if (node == nullptr || expiredUnderSharedLock(node)) {
+                buffer.misses.addShared();
+                recentMisses_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            node->markRead();
+            value = node->getValue();
+            buffer.hits.addShared();
+            shouldDrain = recordRead(buffer, node);
+        }
+        // 缓冲区刚好写满, 尝试排空; 拿不到锁说明有其他线程正在写, 交给它在独占锁内排空
+        if (shouldDrain && mutex_.try_lock()) {
+            drainReadBuffers();
+            mutex_.unlock();
+        }
+        return true;
+    }
+
+    // 读优化模式的批量查找, 整批只持有一次共享锁
+    size_t getBatchShared(const std::vector<Key>& keys, const size_t* indices, size_t count,
+                          std::vector<Value>& values, std::vector<bool>& found) {
+        size_t hits = 0;
+        bool shouldDrain = false;
+        {
+            StatsSharedLockGuard<LockType> lock(mutex_, stats_.lockWaitNs);
+            ReadBuffer& buffer = readBuffers_[threadStripe()];
+            forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+                NodePtr node = nodeMap_.find(keys[i], hash);
+                if (node != nullptr && !expiredUnderSharedLock(node)) {
+                    node->markRead();
+                    values[i] = node->getValue();
+                    found[i] = true;
+                    hits++;
+                    shouldDrain |= recordRead(buffer, node);
+                }
+            });
+            buffer.hits.addShared(hits);
+            buffer.misses.addShared(count - hits);
+            if (hits != count) recentMisses_.fetch_add(count - hits, std::memory_order_relaxed);
+        }
+        if (shouldDrain && mutex_.try_lock()) {
+            drainReadBuffers();
+            mutex_.unlock();
+        }
+        return hits;
+    }
+
+    // 记录一次命中, 返回当前条带的缓冲区是否刚好被写满
+    bool recordRead(ReadBuffer& buffer, NodePtr node) {
+        size_t index = buffer.writeCount.fetch_add(1, std::memory_order_relaxed);
+        if (index < kReadBufferSize) {
+            buffer.nodes[index] = node;
+        }
+        return index + 1 == kReadBufferSize;
+    }
+
+    // 把缓冲区中的访问记录批量应用到LRU链表, 调用方必须持有独占锁
+    void drainReadBuffers() {
+        if (!readOptimized_) return;
+        for (ReadBuffer& buffer: readBuffers_) {
+            size_t count = std::min(buffer.writeCount.load(std::memory_order_relaxed), kReadBufferSize);
+            for (size_t i = 0; i < count; i++) {
+                list_.moveToBack(buffer.nodes[i]);
+            }
+            buffer.writeCount.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static size_t threadStripe() {
+        static thread_local size_t stripe = std::hash<std::thread::id>()(std::this_thread::get_id()) % kReadBufferStripes;
+        return stripe;
+    }
+
+    size_t weigh(NodePtr node) const {
+        return weigher_ ? std::max<size_t>(1, weigher_(node->key_, node->value_)) : 1;
+    }
+
+    template<typename V>
+    void updateExistingNode(NodePtr node, V&& value, uint64_t expireAt) {
+        retired_.retire(node->value_);
+        node->setValue(std::forward<V>(value));
+        node->markWritten();
+        if (node->expireAt_ != expireAt) {
+            timerWheel_.reschedule(node, expireAt);
+        }
+        list_.reweigh(node, weigh(node));
+        moveToMostRecent(node);
+        // 新值变重后可能超出预算, 从最久未访问的一端淘汰, 必要时连同这个节点本身
+        while (list_.weight() > capacity_) {
+            evictLeastRecent();
+        }
+    }
+
+    // args 为值本身或值的构造参数, 直接转发给节点构造; 返回新节点, 没有缓存时返回空
+    template<typename... Args>
+    NodePtr addNewNode(const Key& key, uint64_t expireAt, Args&&... args) {
+        NodePtr newNode = nodePool_.allocate(key, std::forward<Args>(args)...);
+        newNode->weight_ = weigh(newNode);
+        if (newNode->weight_ > capacity_) {
+            // 单个条目就超过总预算, 不缓存
+            nodePool_.deallocate(newNode);
+            return nullptr;
+        }
+        while (list_.weight() + newNode->weight_ > capacity_) {
+            evictLeastRecent();
+        }
+
+        list_.pushBack(newNode);
+        nodeMap_.insert(key, newNode);
+        if (expireAt != 0) {
+            timerWheel_.reschedule(newNode, expireAt);
+        }
+        stats_.inserts.add();
+        return newNode;
+    }
+
+    // 释放所有节点, 调用方持有独占锁并且已经排空读缓冲区
+    void clearLocked() {
+        list_.forEach([this](NodePtr node) {
+            retired_.retire(node->value_);
+            nodePool_.deallocate(node);
+        });
+        list_.reset();
+        nodeMap_.clear();
+        timerWheel_.clear();
+    }
+
+    // 移动节点到最新位置
+    void moveToMostRecent(NodePtr node) {
+        list_.moveToBack(node);
     }
 
     // 去除最近最少访问节点
     void evictLeastRecent() {
-        NodePtr leastRecent = dummyHead_->next_;
-        removeNode(leastRecent);
+        NodePtr leastRecent = list_.front();
+        list_.remove(leastRecent);
         nodeMap_.erase(leastRecent->getKey());
+        timerWheel_.deschedule(leastRecent);
+        if (evictionListener_) evictionListener_(leastRecent->getKey(), leastRecent->value_, leastRecent->expireAt_);
+        retired_.retire(leastRecent->value_);
+        nodePool_.deallocate(leastRecent);
+        stats_.evictions.add();
     }
 };
 
 
-// LRU优化: LRU-K | 通过继承的方式再优化
+// LRU优化: LRU-K | 通过组合的方式再优化
 /**
  * LRU-k 算法是对 LRU 算法的改进
  * 基础的 LRU 算法被访问数据进入缓存队列只需要访问(put, get)一次就行
@@ -180,96 +869,658 @@ private:
  * 常见的k=2
  * 访问历史队列中的数据也不是一直保留的, 也是需要按照LRU的规则进行淘汰
 */
-template<typename Key, typename Value>
+template<typename Key, typename Value, typename Hash = CacheHash<Key>>
 class LruKCache: public CacheStrategy<Key, Value> {
 public:
-    LruKCache(int capacity, int historyCapacity, int k)
-        : LruCache<Key, Value>(capacity) // 调整基类构造
-        , historyList_(std::make_unique<LruCache<Key, size_t>>(historyCapacity))
-        , k_(k)
-    {}
+    // weigher 只作用于主缓存, 历史记录始终按条目数计
+    LruKCache(int capacity, int historyCapacity, int k, CacheWeigher<Key, Value> weigher = nullptr)
+        : k_(k)
+        , lruCache_(std::make_unique<LruCache<Key, Value, std::mutex, Hash>>(capacity, false, std::move(weigher)))
+        , historyList_(std::make_unique<LruCache<Key, size_t, std::mutex, Hash>>(historyCapacity))
+    {
+        this->template useLoadHash<Hash>();
+    }
+
+    ~LruKCache() override {
+        this->cancelLoads();
+    }
 
-    Value get(Key key) {
+    bool get(const Key& key, Value& value) override {
         // 获取该数据访问次数
-        int historyCount = historyList_->get(key);
+        size_t historyCount = historyList_->get(key);
         // 如果访问到数据, 则更新历史访问记录节点值 count++
         historyList_->put(key, ++historyCount);
 
         // 从缓存中获取数据, 不一定能获取到, 因为可能不在缓存中
-        return LruCache<Key, Value>::get(key);
+        bool found = lruCache_->get(key, value);
+        if (found) {
+            stats_.hits.addShared();
+        }
+        else {
+            stats_.misses.addShared();
+        }
+        return found;
+    }
+
+    // 只查主缓存, 不记录访问历史
+    bool contains(const Key& key) override {
+        return lruCache_->contains(key);
     }
 
-    void put(Key key, Value value) {
+    // 只删除主缓存中的条目, 访问历史保留
+    void remove(const Key& key) override {
+        lruCache_->remove(key);
+    }
+
+    // 命中/未命中只按 get() 计算(put() 内部对主缓存的探测不算), 其余取自主缓存
+    CacheStatsSnapshot getStats() override {
+        CacheStatsSnapshot snapshot = lruCache_->getStats();
+        snapshot.hits = stats_.hits.load();
+        snapshot.misses = stats_.misses.load();
+        return snapshot;
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    void put(const Key& key, const Value& value) override {
+        putImpl(key, value);
+    }
+
+    void put(const Key& key, Value&& value) override {
+        putImpl(key, std::move(value));
+    }
+
+    /**
+     * 批量接口的分片入口, 下标含义同 LruCache::getBatch()
+     * 每个 key 都要先更新访问历史再查主缓存, 逐个处理(主缓存和历史各自加锁)
+    */
+    size_t getBatch(const std::vector<Key>& keys, const size_t* indices, size_t count,
+                    std::vector<Value>& values, std::vector<bool>& found) {
+        size_t hits = 0;
+        for (size_t pos = 0; pos < count; pos++) {
+            size_t i = batchIndexAt(indices, pos);
+            if (get(keys[i], values[i])) {
+                found[i] = true;
+                hits++;
+            }
+        }
+        return hits;
+    }
+
+    void putBatch(const std::vector<Key>& keys, const std::vector<Value>& values, const size_t* indices, size_t count) {
+        for (size_t pos = 0; pos < count; pos++) {
+            size_t i = batchIndexAt(indices, pos);
+            putImpl(keys[i], values[i]);
+        }
+    }
+
+private:
+    template<typename V>
+    void putImpl(const Key& key, V&& value) {
         // 先判断是否存在与缓存中, 如果存在则直接覆盖, 如果不存在则不直接添加到缓存
-        if (LruCache<Key, Value>::get(key) != "") {
-            LruCache<Key, Value>::put(key, value);
+        if (lruCache_->contains(key)) {
+            lruCache_->put(key, std::forward<V>(value));
+            return;
         }
 
         // 如果数据历史访问次数达到k次, 则加入到缓存
-        int historyCount = historyList_->get(key);
+        size_t historyCount = historyList_->get(key);
         historyList_->put(key, ++historyCount);
 
-        if (historyCount >= k_) {
+        if (historyCount >= static_cast<size_t>(k_)) {
             // 移除历史记录
             historyList_->remove(key);
             // 添加到缓存中
-            LruCache<Key, Value>::put(key, value);
+            lruCache_->put(key, std::forward<V>(value));
         }
     }
+
 private:
     int k_;                             // 进入缓存队列的评判标准(>= k_)
-    std::unique_ptr<LruCache<Key, size_t>> historyList_; // 访问数据历史记录(value为访问次数)
+    std::unique_ptr<LruCache<Key, Value, std::mutex, Hash>> lruCache_;        // 达到 k 次访问后进入的主缓存
+    std::unique_ptr<LruCache<Key, size_t, std::mutex, Hash>> historyList_;    // 访问数据历史记录(value为访问次数)
+    CacheStats stats_;                  // 自身没有锁, 计数器用原子加
 };
 
 
 /**
- * 当多个线程同时访问一个LRU/LFU时, 由于锁的粒度大, 会造成长时间的同步等待
- * 如果是多个线程同时访问多个LRU/LFU缓存，同步等待时间将大大减少 
+ * SLRU 和 2Q 共用的骨架: 两个分段共用一个索引、内存池和定时轮, 分段本身是 LruList
+ * 1. 访问次数为 1 的条目在第一个分段 entry_, 至少为 2 的在第二个分段 main_,
+ *    节点在哪个分段由访问次数判断, 不需要额外的字段
+ * 2. 具体策略(Derived)只决定: 新条目进入哪个分段(onAdmit)、命中后怎样调整分段(onHit)、容量不足时淘汰谁(victim)
+ * 3. TTL、批量接口、淘汰监听器、延迟释放和后台维护与 LruCache 一致
 */
-// LRU优化: 对LRU进行分片, 提高高并发使用的性能
-template<typename Key, typename Value>
-class HashLruCaches {
+template<typename Key, typename Value, typename Derived, typename Mutex, typename Hash>
+class SegmentedLruBase : public CacheStrategy<Key, Value> {
 public:
-    HashLruCaches(size_t capacity, int sliceNum)
+    using LruNodeType = LruNode<Key, Value>;
+    using NodePtr = LruNodeType*;
+    using NodeMap = FlatNodeIndex<Key, LruNodeType, Hash>;
+    using Weigher = CacheWeigher<Key, Value>;
+
+    // 设置 weigher 后 capacity 为总权重预算, 各分段的大小也按权重计算
+    SegmentedLruBase(size_t capacity, Weigher weigher)
         : capacity_(capacity)
-        , sliceNum_(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency()) 
+        , weigher_(std::move(weigher))
+        , nodePool_(weigher_ ? 0 : capacity)
+        , nodeMap_(weigher_ ? 0 : capacity)
     {
-        size_t sliceSize = std::ceil(capacity / static_cast<double>(sliceNum_));
-        // 获取每个分片的大小
-        for (int i = 0; i < sliceNum; i++) {
-            lruSliceCaches_.emplace_back(new LruCache<Key, Value>(sliceSize));
-        }
+        this->template useLoadHash<Hash>();
+    }
+
+    ~SegmentedLruBase() override {
+        this->cancelLoads();
+        entry_.forEach([this](NodePtr node) { nodePool_.deallocate(node); });
+        main_.forEach([this](NodePtr node) { nodePool_.deallocate(node); });
+    }
+
+    void put(const Key& key, const Value& value) override {
+        putImpl(key, 0, value);
     }
 
-    void put(Key key, Value value) {
-        // 获取key的hash值, 并计算出对应的分片索引
-        size_t sliceIndex = Hash(key) % sliceNum_;
-        return lruSliceCaches_[sliceIndex]->put(key, value);
+    void put(const Key& key, Value&& value) override {
+        putImpl(key, 0, std::move(value));
     }
 
-    bool get(Key key, Value& value) {
-        // 获取key的hash值, 并计算出对应的分片索引
-        size_t sliceIndex = Hash(key) % sliceNum_;
-        return lruSliceCaches_[sliceIndex]->get(key, value);
+    // 带 TTL 的添加: ttl 之后条目失效, 由定时轮回收; 不带 ttl 的 put() 会清除已有的过期时间
+    void put(const Key& key, const Value& value, std::chrono::nanoseconds ttl) {
+        putImpl(key, cacheExpireAt(ttl), value);
     }
 
-    Value get(Key key) {
-        Value value;
-        memset(&value, 0, sizeof(value));
+    void put(const Key& key, Value&& value, std::chrono::nanoseconds ttl) {
+        putImpl(key, cacheExpireAt(ttl), std::move(value));
+    }
+
+    // key 不在缓存中时直接在新节点里构造值; key 已存在时构造新值并移动赋值
+    template<typename... Args>
+    void emplace(const Key& key, Args&&... args) {
+        putImpl(key, 0, std::forward<Args>(args)...);
+    }
+
+    bool get(const Key& key, Value& value) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        return getLocked(nodeMap_.find(key), value);
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
         get(key, value);
         return value;
     }
+
+    // 只判断 key 是否在缓存中(已过期的不算), 不调整分段也不拷贝值
+    bool contains(const Key& key) override {
+        std::lock_guard<Mutex> lock(mutex_);
+        NodePtr node = nodeMap_.find(key);
+        return node != nullptr && (node->expireAt_ == 0 || !node->isExpired(cacheNowNanos()));
+    }
+
+    size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) override {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        return getBatch(keys, nullptr, keys.size(), values, found);
+    }
+
+    void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) override {
+        putBatch(keys, values, nullptr, std::min(keys.size(), values.size()));
+    }
+
+    // 批量查找的分片入口, 下标含义同 LruCache::getBatch(), 整批只加一次锁
+    size_t getBatch(const std::vector<Key>& keys, const size_t* indices, size_t count,
+                    std::vector<Value>& values, std::vector<bool>& found) {
+        size_t hits = 0;
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            if (getLocked(nodeMap_.find(keys[i], hash), values[i])) {
+                found[i] = true;
+                hits++;
+            }
+        });
+        return hits;
+    }
+
+    // 批量添加的分片入口, 下标含义同 getBatch()
+    void putBatch(const std::vector<Key>& keys, const std::vector<Value>& values, const size_t* indices, size_t count) {
+        if (capacity_ == 0) return;
+
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            putLocked(keys[i], nodeMap_.find(keys[i], hash), 0, values[i]);
+        });
+    }
+
+    // 删除指定元素, 不进入 ghost 列表
+    void remove(const Key& key) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        NodePtr node = nodeMap_.find(key);
+        if (node != nullptr) {
+            release(node);
+        }
+    }
+
+    // 立即回收所有已经到期的条目; 读写操作本身也会顺带回收, 这里用于长时间没有访问的缓存
+    void purgeExpired() {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+    }
+
+    // 清空缓存, 包括策略自己的 ghost 列表
+    void purge() {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        clearLocked();
+    }
+
+    // 淘汰监听器, 传入空函数时取消; 见 CacheEvictionListener
+    void setEvictionListener(CacheEvictionListener<Key, Value> listener) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        evictionListener_ = std::move(listener);
+    }
+
+    // 延迟释放: 开启后淘汰、过期、覆盖和删除的旧值移进待释放列表, 由 runMaintenance() 在锁外析构
+    void setDeferredRelease(bool enabled) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        retired_.setEnabled(enabled);
+    }
+
+    // 节点内存池和索引绑定到 NUMA 节点 node, 已有的内存一并迁移; 通常由分片缓存的 placeShardsOnNumaNodes() 调用
+    void setNumaNode(int node) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        nodePool_.setNumaNode(node);
+        nodeMap_.setNumaNode(node);
+    }
+
+    // 一次后台维护: 回收到期条目, 待释放的旧值在锁外析构
+    void runMaintenance() {
+        std::vector<Value> retired;
+        {
+            StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+            expireEntries();
+            retired = retired_.take();
+        }
+    }
+
+    // window 之内到期、并且上次写入之后被读过的条目的 key, 用于提前刷新
+    std::vector<Key> expiringKeys(std::chrono::nanoseconds window) {
+        std::vector<Key> keys;
+        std::lock_guard<Mutex> lock(mutex_);
+        if (timerWheel_.empty()) return keys;
+        uint64_t deadline = cacheNowNanos() + static_cast<uint64_t>(window.count());
+        timerWheel_.forEachExpiringBefore(deadline, [&](TimerEntry* entry) {
+            if (entry->readSinceWrite()) keys.push_back(static_cast<NodePtr>(entry)->key_);
+        });
+        return keys;
+    }
+
+    // 提前刷新的写回: 只替换已有条目的值并以 ttl 续期, 不移动分段也不算命中; 条目已经不在缓存中时返回 false
+    template<typename V>
+    bool refresh(const Key& key, V&& value, std::chrono::nanoseconds ttl) {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        NodePtr node = nodeMap_.find(key);
+        if (node == nullptr || node->isExpired(now_)) return false;
+        retired_.retire(node->value_);
+        node->value_ = std::forward<V>(value);
+        node->markWritten();
+        timerWheel_.reschedule(node, cacheExpireAt(ttl));
+        segmentOf(node).reweigh(node, weigh(node));
+        while (usedWeight() > capacity_) {
+            evict(derived().victim());
+        }
+        return true;
+    }
+
+    /**
+     * 统计快照, 复用 ARC 的分区字段:
+     * lruPartSize/lfuPartSize 为两个分段的条目数, 分段的容量和 ghost 大小由具体策略填写
+    */
+    CacheStatsSnapshot getStats() override {
+        CacheStatsSnapshot snapshot;
+        stats_.addTo(snapshot);
+        std::lock_guard<Mutex> lock(mutex_);
+        snapshot.lruPartSize = entry_.size();
+        snapshot.lfuPartSize = main_.size();
+        snapshot.size = nodeMap_.size();
+        snapshot.weight = usedWeight();
+        derived().segmentStats(snapshot);
+        return snapshot;
+    }
+
+protected:
+    // 节点所在的分段
+    LruList<Key, Value>& segmentOf(NodePtr node) {
+        return node->accessCount_ > 1 ? main_ : entry_;
+    }
+
+    size_t usedWeight() const {
+        return entry_.weight() + main_.weight();
+    }
+
+    size_t capacity_;               // 缓存容量(设置权重函数时为总权重预算)
+    Weigher weigher_;               // 权重函数, 为空时每个条目权重为 1
+    NodePool<LruNodeType> nodePool_;
+    NodeMap nodeMap_;               // key -> 两个分段中的节点
+    LruList<Key, Value> entry_;     // 第一个分段: SLRU 的试用段 / 2Q 的 A1in
+    LruList<Key, Value> main_;      // 第二个分段: SLRU 的保护段 / 2Q 的 Am
+    TimerWheel timerWheel_;         // 设置了 TTL 的节点
+    RetireList<Value> retired_;     // 延迟释放的旧值
+    CacheEvictionListener<Key, Value> evictionListener_;   // 容量淘汰时的回调, 可以为空
+    uint64_t now_ = 0;              // 最近一次读取的时间, 只在有节点设置了 TTL 时更新
+    Mutex mutex_;
+    CacheStats stats_;              // 统计计数器(锁内更新)
+
 private:
-    size_t capacity_;               // 缓存总容量
-    int sliceNum_;                  // 切片数量
-    std::vector<std::unique_ptr<LruCache<Key, Value>>> lruSliceCaches_;     // 切片LRU缓存
+    Derived& derived() {
+        return static_cast<Derived&>(*this);
+    }
+
+    template<typename... Args>
+    void putImpl(const Key& key, uint64_t expireAt, Args&&... args) {
+        if (capacity_ == 0) return;
+
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        expireEntries();
+        putLocked(key, nodeMap_.find(key), expireAt, std::forward<Args>(args)...);
+    }
+
+    // 以下函数由调用方持有 mutex_, 并且已经调用过 expireEntries()
+    bool getLocked(NodePtr node, Value& value) {
+        if (node != nullptr && node->isExpired(now_)) {
+            removeExpired(node);
+            node = nullptr;
+        }
+        if (node == nullptr) {
+            stats_.misses.add();
+            return false;
+        }
+        derived().onHit(node);
+        node->markRead();
+        value = node->value_;
+        stats_.hits.add();
+        return true;
+    }
+
+    // expireAt 为绝对过期时间, 0 表示不过期
+    template<typename... Args>
+    void putLocked(const Key& key, NodePtr node, uint64_t expireAt, Args&&... args) {
+        if (node != nullptr && node->isExpired(now_)) {
+            removeExpired(node);
+            node = nullptr;
+        }
+        if (node != nullptr) {
+            // 已经在缓存中: 更新值, 按命中处理
+            retired_.retire(node->value_);
+            node->value_ = Value(std::forward<Args>(args)...);
+            node->markWritten();
+            if (node->expireAt_ != expireAt) {
+                timerWheel_.reschedule(node, expireAt);
+            }
+            segmentOf(node).reweigh(node, weigh(node));
+            derived().onHit(node);
+            // 新值变重后可能超出预算, 必要时连同这个节点本身一起淘汰
+            while (usedWeight() > capacity_) {
+                evict(derived().victim());
+            }
+            return;
+        }
+
+        node = nodePool_.allocate(key, std::forward<Args>(args)...);
+        node->weight_ = weigh(node);
+        if (node->weight_ > capacity_) {
+            // 单个条目就超过总预算, 不缓存
+            nodePool_.deallocate(node);
+            return;
+        }
+        // 先决定进入哪个分段, 再腾出空间, 淘汰产生的 ghost 不会挤掉这个 key 自己的 ghost
+        derived().onAdmit(node);
+        while (usedWeight() + node->weight_ > capacity_) {
+            evict(derived().victim());
+        }
+        segmentOf(node).pushBack(node);
+        nodeMap_.insert(key, node);
+        if (expireAt != 0) {
+            timerWheel_.reschedule(node, expireAt);
+        }
+        stats_.inserts.add();
+    }
+
+    // 容量淘汰, victim() 已经把需要记住的 key 放进策略自己的 ghost 列表
+    void evict(NodePtr node) {
+        if (evictionListener_) evictionListener_(node->key_, node->value_, node->expireAt_);
+        release(node);
+        stats_.evictions.add();
+    }
+
+    void removeExpired(NodePtr node) {
+        release(node);
+        stats_.expirations.add();
+    }
+
+    void release(NodePtr node) {
+        segmentOf(node).remove(node);
+        nodeMap_.erase(node->key_);
+        timerWheel_.deschedule(node);
+        retired_.retire(node->value_);
+        nodePool_.deallocate(node);
+    }
+
+    // 回收定时轮中已经到期的节点, 没有设置过 TTL 的节点时不读时钟
+    void expireEntries() {
+        if (timerWheel_.empty()) return;
+        now_ = cacheNowNanos();
+        timerWheel_.advance(now_, [this](TimerEntry* entry) {
+            removeExpired(static_cast<NodePtr>(entry));
+        });
+    }
+
+    size_t weigh(NodePtr node) const {
+        return weigher_ ? std::max<size_t>(1, weigher_(node->key_, node->value_)) : 1;
+    }
+
+    void clearLocked() {
+        for (LruList<Key, Value>* segment: {&entry_, &main_}) {
+            segment->forEach([this](NodePtr node) {
+                retired_.retire(node->value_);
+                nodePool_.deallocate(node);
+            });
+            segment->reset();
+        }
+        nodeMap_.clear();
+        timerWheel_.clear();
+        derived().clearGhosts();
+    }
+};
+
+
+/**
+ * 分段 LRU (SLRU, Karedla 等人 "Caching Strategies to Improve Disk System Performance")
+ * 1. 缓存分为试用段(probation)和保护段(protected), 两段内部都按 LRU 排序
+ * 2. 新条目进入试用段; 在试用段里再次命中后晋升到保护段, 保护段内的命中只移到它的最近访问端
+ * 3. 保护段超过 protectedRatio * capacity 时, 它最久未访问的条目降级回试用段的最近访问端, 还有一次晋升的机会
+ * 4. 淘汰总是先从试用段的最久未访问端开始, 只访问一次的扫描数据不会挤掉保护段里的热点
+ * 与 LRU-K 相比不需要单独的访问历史, 每次操作都是 O(1)
+*/
+template<typename Key, typename Value, typename Mutex, typename Hash>
+class SlruCache : public SegmentedLruBase<Key, Value, SlruCache<Key, Value, Mutex, Hash>, Mutex, Hash> {
+public:
+    using Base = SegmentedLruBase<Key, Value, SlruCache<Key, Value, Mutex, Hash>, Mutex, Hash>;
+    using NodePtr = typename Base::NodePtr;
+
+    // protectedRatio 为保护段占总容量的比例, 常用 0.8
+    explicit SlruCache(size_t capacity = 10, double protectedRatio = 0.8, CacheWeigher<Key, Value> weigher = nullptr)
+        : Base(capacity, std::move(weigher))
+        , protectedCapacity_(static_cast<size_t>(capacity * std::min(1.0, std::max(0.0, protectedRatio))))
+    {}
+
+    // 写回会用到本类的成员, 在基类析构之前停止
+    ~SlruCache() override {
+        this->cancelLoads();
+    }
+
+private:
+    friend Base;
+
+    // 以下由基类在持有锁时调用
+    void onAdmit(NodePtr) {}
+
+    void onHit(NodePtr node) {
+        if (node->accessCount_ == 1) {
+            // 试用段中再次命中, 晋升到保护段
+            this->entry_.remove(node);
+            node->accessCount_ = 2;
+            this->main_.pushBack(node);
+        }
+        else {
+            this->main_.moveToBack(node);
+            node->incrementAccessCount();
+        }
+        // 保护段超出容量时降级, 刚晋升的节点在最近访问端, 不会被立即降级
+        while (this->main_.weight() > protectedCapacity_ && this->main_.size() > 1) {
+            NodePtr demoted = this->main_.front();
+            this->main_.remove(demoted);
+            demoted->accessCount_ = 1;
+            this->entry_.pushBack(demoted);
+        }
+    }
+
+    NodePtr victim() {
+        return this->entry_.empty() ? this->main_.front() : this->entry_.front();
+    }
+
+    void clearGhosts() {}
+
+    void segmentStats(CacheStatsSnapshot& snapshot) const {
+        snapshot.lruPartCapacity = this->capacity_ - protectedCapacity_;
+        snapshot.lfuPartCapacity = protectedCapacity_;
+    }
+
+private:
+    size_t protectedCapacity_;      // 保护段的容量(按权重)
+};
+
+
+/**
+ * 2Q (Johnson & Shasha "2Q: A Low Overhead High Performance Buffer Management Replacement Algorithm"), 完整版
+ * 1. A1in: FIFO, 新条目进入这里, 命中不调整位置(短时间内的重复访问不代表长期热点)
+ * 2. A1out: 从 A1in 淘汰的 key 的指纹(ghost, 不占缓存容量), 最多 Kout = capacity / 2
+ * 3. Am: LRU, 只有在 A1out 中找到的 key 再次写入时才进入, 此时它已经被证明不只访问一次
+ * 4. 腾空间时 A1in 超过 Kin = capacity / 4 就淘汰 A1in 最旧的条目(进入 A1out), 否则淘汰 Am 最久未访问的条目
+ * A1in 中的条目访问次数保持为 1, 进入 Am 的条目从 2 开始计数, 基类据此区分两个队列
+*/
+template<typename Key, typename Value, typename Mutex, typename Hash>
+class TwoQueueCache : public SegmentedLruBase<Key, Value, TwoQueueCache<Key, Value, Mutex, Hash>, Mutex, Hash> {
+public:
+    using Base = SegmentedLruBase<Key, Value, TwoQueueCache<Key, Value, Mutex, Hash>, Mutex, Hash>;
+    using NodePtr = typename Base::NodePtr;
+
+    // 设置 weigher 后 Kin/Kout 也按权重计算
+    explicit TwoQueueCache(size_t capacity = 10, CacheWeigher<Key, Value> weigher = nullptr)
+        : Base(capacity, std::move(weigher))
+        , kin_(std::max<size_t>(1, capacity / 4))
+        , kout_(std::max<size_t>(1, capacity / 2))
+        , a1out_(this->weigher_ ? 0 : kout_)
+    {}
+
+    // 写回会用到 a1out_, 在基类析构之前停止
+    ~TwoQueueCache() override {
+        this->cancelLoads();
+    }
 
 private:
-    // 将key转换为对应的hash值
-    size_t Hash(Key key) {
-        std::hash<Key> hashFunc;
-        return hashFunc(key);
+    friend Base;
+
+    // 以下由基类在持有锁时调用
+    void onAdmit(NodePtr node) {
+        size_t ghostWeight = 0;
+        if (a1out_.remove(node->key_, ghostWeight)) {
+            node->accessCount_ = 2;
+            this->stats_.lruGhostHits.add();
+        }
     }
+
+    void onHit(NodePtr node) {
+        if (node->accessCount_ > 1) {
+            this->main_.moveToBack(node);
+            node->incrementAccessCount();
+        }
+    }
+
+    NodePtr victim() {
+        if (this->entry_.empty() || (this->entry_.weight() <= kin_ && !this->main_.empty())) {
+            return this->main_.front();
+        }
+        NodePtr node = this->entry_.front();
+        a1out_.push(node->key_, node->weight_);
+        while (a1out_.weight() > kout_) {
+            a1out_.removeOldest();
+        }
+        return node;
+    }
+
+    void clearGhosts() {
+        a1out_.clear();
+    }
+
+    void segmentStats(CacheStatsSnapshot& snapshot) const {
+        snapshot.lruPartCapacity = kin_;
+        snapshot.lfuPartCapacity = this->capacity_ - std::min(kin_, this->capacity_);
+        snapshot.lruGhostSize = a1out_.size();
+    }
+
+private:
+    size_t kin_;                    // A1in 的目标大小
+    size_t kout_;                   // A1out 的最大大小
+    ArcGhostList<Key, Hash> a1out_; // 从 A1in 淘汰的 key 的指纹
+};
+
+
+/**
+ * 当多个线程同时访问一个LRU/LFU时, 由于锁的粒度大, 会造成长时间的同步等待
+ * 如果是多个线程同时访问多个LRU/LFU缓存，同步等待时间将大大减少 
+ * · rebalanceCapacity() 按各分片的未命中次数在分片之间重新分配容量, 热点分片不会在冷分片半空时溢出
+ * · Resize 为 ResizableShards 时可以用 resizeShards() 在运行中调整分片数
+ * · Mutex 默认是 std::mutex; 需要只读操作共享时传 std::shared_mutex, 争用时跳过提升传 SkipPromotionOnContention<>
+*/
+// LRU优化: 对LRU进行分片, 提高高并发使用的性能
+template<typename Key, typename Value, typename Hash = CacheHash<Key>, typename Resize = FixedShards, typename Mutex = std::mutex>
+class HashLruCaches : public ShardedCacheStrategy<LruCache<Key, Value, Mutex, Hash>, 0, Hash, NullShardLock, SumShardStats, Resize> {
+public:
+    using Base = ShardedCacheStrategy<LruCache<Key, Value, Mutex, Hash>, 0, Hash, NullShardLock, SumShardStats, Resize>;
+
+    // 设置 weigher 后 capacity 为总权重预算, 平均分给各分片
+    HashLruCaches(size_t capacity, int sliceNum, bool readOptimized = false, CacheWeigher<Key, Value> weigher = nullptr)
+        : Base(capacity, sliceNum, readOptimized, weigher)
+    {}
+
+    // 分片间容量再平衡(由调用方定期调用), 按各分片上个周期的未命中次数分配, 见 ShardedCache::rebalanceCapacity()
+    void rebalanceCapacity(size_t minSliceCapacity = 1) {
+        this->sharded_.rebalanceCapacity([](LruCache<Key, Value, Mutex, Hash>& slice) { return slice.takeMisses(); }, minSliceCapacity);
+    }
+};
+
+
+// SLRU 分片, 每个分片各自按比例划分试用段和保护段
+template<typename Key, typename Value, typename Hash = CacheHash<Key>, typename Mutex = std::mutex>
+class HashSlruCache : public ShardedCacheStrategy<SlruCache<Key, Value, Mutex, Hash>, 0, Hash> {
+public:
+    HashSlruCache(size_t capacity, int sliceNum, double protectedRatio = 0.8, CacheWeigher<Key, Value> weigher = nullptr)
+        : ShardedCacheStrategy<SlruCache<Key, Value, Mutex, Hash>, 0, Hash>(capacity, sliceNum, protectedRatio, weigher)
+    {}
+};
+
+// 2Q 分片, 每个分片有自己的 A1in/A1out/Am
+template<typename Key, typename Value, typename Hash = CacheHash<Key>, typename Mutex = std::mutex>
+class HashTwoQueueCache : public ShardedCacheStrategy<TwoQueueCache<Key, Value, Mutex, Hash>, 0, Hash> {
+public:
+    HashTwoQueueCache(size_t capacity, int sliceNum, CacheWeigher<Key, Value> weigher = nullptr)
+        : ShardedCacheStrategy<TwoQueueCache<Key, Value, Mutex, Hash>, 0, Hash>(capacity, sliceNum, weigher)
+    {}
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,506 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CacheStrategy.h"
+#include "CacheBatch.h"
+#include "CacheSharded.h"
+#include "CacheNodePool.h"
+#include "CacheFlatIndex.h"
+#include "CacheSketch.h"
+#include "CacheLock.h"
+
+/**
+ * W-TinyLFU (Einziger 等人 "TinyLFU: A Highly Efficient Cache Admission Policy")
+ * 1. 窗口区(window): 约占容量的 1%, 普通 LRU, 新条目先进入窗口, 保护刚出现的突发访问
+ * 2. 主区(main): 分段 LRU (SLRU), 试用段(probation) + 保护段(protected, 占主区的 80%)
+ *    · 从窗口淘汰出来的候选者进入试用段, 试用段中再次被访问的条目提升到保护段
+ *    · 保护段超出容量时, 最久未访问的条目降级回试用段
+ * 3. 准入: 主区放不下候选者时, 用 FrequencySketch 比较候选者和试用段最久未访问的条目(受害者)的频次,
+ *    候选者频次更高才淘汰受害者, 否则淘汰候选者本身
+ * 频次由 count-min sketch 估计, 每个 key 只占几个字节, 不在缓存中的 key 也有访问记录
+*/
+
+namespace Cache {
+
+template<typename Key, typename Value, typename Mutex = std::mutex, typename Hash = CacheHash<Key>> class TinyLfuCache;
+
+template<typename Key, typename Value>
+class TinyLfuNode {
+private:
+    Key key_;
+    Value value_;
+    size_t weight_;     // 条目权重, 插入和更新值时由缓存计算
+    int segment_;       // 所在的区段: 窗口/试用段/保护段
+    TinyLfuNode<Key, Value>* prev_;     // 侵入式循环链表指针, 节点内存由 NodePool 管理
+    TinyLfuNode<Key, Value>* next_;
+
+public:
+    template<typename... Args>
+    explicit TinyLfuNode(const Key& key, Args&&... args)
+        : key_(key)
+        , value_(std::forward<Args>(args)...)
+        , weight_(1)
+        , segment_(0)
+        , prev_(this)
+        , next_(this)
+    {}
+
+    const Key& getKey() const {
+        return key_;
+    }
+    const Value& getValue() const {
+        return value_;
+    }
+
+    template<typename, typename, typename, typename> friend class TinyLfuCache;
+};
+
+
+// Mutex 为锁策略, 见 CacheLock.h
+template<typename Key, typename Value, typename Mutex, typename Hash>
+class TinyLfuCache : public CacheStrategy<Key, Value> {
+public:
+    using NodeType = TinyLfuNode<Key, Value>;
+    using NodePtr = NodeType*;
+    using NodeMap = FlatNodeIndex<Key, NodeType, Hash>;
+    using Weigher = CacheWeigher<Key, Value>;
+
+    // 窗口区占 1%(至少1), 剩余为主区, 主区的 80% 为保护段
+    // 设置 weigher 后 capacity 为总权重预算, 各区段也都按权重计算, sketch 随条目数增长
+    explicit TinyLfuCache(size_t capacity, Weigher weigher = nullptr)
+        : capacity_(capacity)
+        , weigher_(std::move(weigher))
+        , nodePool_(weigher_ ? kSegmentCount : capacity + kSegmentCount)
+        , nodeMap_(weigher_ ? 0 : capacity)
+        , sketch_(weigher_ ? 0 : capacity)
+    {
+        this->template useLoadHash<Hash>();
+        windowCapacity_ = std::min(capacity_, std::max<size_t>(1, capacity_ / 100));
+        mainCapacity_ = capacity_ - windowCapacity_;
+        protectedCapacity_ = mainCapacity_ * 4 / 5;
+        for (Segment& segment: segments_) {
+            segment.head = nodePool_.allocate(Key(), Value());
+            segment.weight = 0;
+        }
+    }
+
+    ~TinyLfuCache() override {
+        this->cancelLoads();
+        for (Segment& segment: segments_) {
+            NodePtr node = segment.head->next_;
+            while (node != segment.head) {
+                NodePtr next = node->next_;
+                nodePool_.deallocate(node);
+                node = next;
+            }
+            nodePool_.deallocate(segment.head);
+        }
+    }
+
+    void put(const Key& key, const Value& value) override {
+        putImpl(key, value);
+    }
+
+    void put(const Key& key, Value&& value) override {
+        putImpl(key, std::move(value));
+    }
+
+    // key 不存在时直接在新节点里构造值; key 已存在时构造新值并移动赋值
+    template<typename... Args>
+    void emplace(const Key& key, Args&&... args) {
+        if (capacity_ == 0) return;
+
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        putLocked(key, nodeMap_.find(key), std::forward<Args>(args)...);
+    }
+
+    bool get(const Key& key, Value& value) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        return getLocked(key, nodeMap_.find(key), value);
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 只查索引, 不记录访问频次
+    bool contains(const Key& key) override {
+        std::lock_guard<Mutex> lock(mutex_);
+        return nodeMap_.find(key) != nullptr;
+    }
+
+    // 删除指定元素, sketch 中的频次保留
+    void remove(const Key& key) override {
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        NodePtr node = nodeMap_.find(key);
+        if (node == nullptr) return;
+        unlink(node);
+        nodeMap_.erase(key);
+        nodePool_.deallocate(node);
+    }
+
+    size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) override {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        return getBatch(keys, nullptr, keys.size(), values, found);
+    }
+
+    void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) override {
+        putBatch(keys, values, nullptr, std::min(keys.size(), values.size()));
+    }
+
+    /**
+     * 批量查找的分片入口: 只处理 indices 指定的 count 个下标(indices 为空表示 0..count-1), 整批只加一次锁
+     * values/found 由调用方预先调整好大小, 返回命中个数
+    */
+    size_t getBatch(const std::vector<Key>& keys, const size_t* indices, size_t count,
+                    std::vector<Value>& values, std::vector<bool>& found) {
+        size_t hits = 0;
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            if (getLocked(keys[i], nodeMap_.find(keys[i], hash), values[i])) {
+                found[i] = true;
+                hits++;
+            }
+        });
+        return hits;
+    }
+
+    // 批量添加的分片入口, 下标含义同 getBatch()
+    void putBatch(const std::vector<Key>& keys, const std::vector<Value>& values, const size_t* indices, size_t count) {
+        if (capacity_ == 0) return;
+
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        forEachBatched(nodeMap_, keys, indices, count, [&](size_t i, size_t hash) {
+            putLocked(keys[i], nodeMap_.find(keys[i], hash), values[i]);
+        });
+    }
+
+    CacheStatsSnapshot getStats() override {
+        CacheStatsSnapshot snapshot;
+        stats_.addTo(snapshot);
+        std::lock_guard<Mutex> lock(mutex_);
+        snapshot.size = nodeMap_.size();
+        snapshot.weight = segments_[kWindow].weight + mainWeight();
+        return snapshot;
+    }
+
+private:
+    static constexpr int kWindow = 0;
+    static constexpr int kProbation = 1;
+    static constexpr int kProtected = 2;
+    static constexpr int kSegmentCount = 3;
+
+    // 一个区段: 以虚拟节点为头的循环链表, head->next_ 是最久未访问的一端
+    struct Segment {
+        NodePtr head;
+        size_t weight;
+    };
+
+    template<typename V>
+    void putImpl(const Key& key, V&& value) {
+        if (capacity_ == 0) return;
+
+        StatsLockGuard<Mutex> lock(mutex_, stats_.lockWaitNs);
+        putLocked(key, nodeMap_.find(key), std::forward<V>(value));
+    }
+
+    // node 为 key 在索引中查到的节点(可能为空), args 为值本身或值的构造参数
+    template<typename... Args>
+    void putLocked(const Key& key, NodePtr node, Args&&... args) {
+        sketch_.increment(key);
+        if (node != nullptr) {
+            node->value_ = Value(std::forward<Args>(args)...);
+            // 重新计算权重, 和 get() 一样算一次访问
+            unlink(node);
+            node->weight_ = weigh(node);
+            linkLast(node, node->segment_);
+            onAccess(node);
+        }
+        else {
+            node = nodePool_.allocate(key, std::forward<Args>(args)...);
+            node->weight_ = weigh(node);
+            if (node->weight_ > capacity_) {
+                // 单个条目就超过总预算, 不缓存
+                nodePool_.deallocate(node);
+                return;
+            }
+            nodeMap_.insert(key, node);
+            linkLast(node, kWindow);
+            stats_.inserts.add();
+            if (weigher_ && nodeMap_.size() > sketch_.width()) {
+                sketch_.ensureCapacity(nodeMap_.size());
+            }
+        }
+        evictEntries();
+    }
+
+    // 命中和未命中都记录进 sketch, 不在缓存中的 key 也要积累频次才能通过准入
+    bool getLocked(const Key& key, NodePtr node, Value& value) {
+        sketch_.increment(key);
+        if (node == nullptr) {
+            stats_.misses.add();
+            return false;
+        }
+        onAccess(node);
+        value = node->value_;
+        stats_.hits.add();
+        return true;
+    }
+
+    // 命中后的移动: 窗口和保护段内移到最新位置, 试用段提升到保护段
+    void onAccess(NodePtr node) {
+        int segment = node->segment_ == kProbation ? kProtected : node->segment_;
+        unlink(node);
+        linkLast(node, segment);
+        if (segment == kProtected) {
+            demoteProtected();
+        }
+    }
+
+    // 保护段超出容量, 最久未访问的条目降级到试用段
+    void demoteProtected() {
+        Segment& protectedSegment = segments_[kProtected];
+        while (protectedSegment.weight > protectedCapacity_) {
+            NodePtr node = protectedSegment.head->next_;
+            unlink(node);
+            linkLast(node, kProbation);
+        }
+    }
+
+    /**
+     * 窗口超出容量时, 最久未访问的条目作为候选者进入主区
+     * 主区放不下时候选者和受害者(试用段最久未访问的条目, 试用段为空时取保护段)比较频次, 频次低的被淘汰
+    */
+    void evictEntries() {
+        Segment& window = segments_[kWindow];
+        while (window.weight > windowCapacity_) {
+            NodePtr candidate = window.head->next_;
+            unlink(candidate);
+            admit(candidate);
+        }
+        // 主区内更新值后变重, 直接从试用段一端淘汰
+        demoteProtected();
+        while (mainWeight() > mainCapacity_) {
+            evict(victim());
+        }
+    }
+
+    void admit(NodePtr candidate) {
+        size_t candidateFreq = sketch_.frequency(candidate->key_);
+        while (mainWeight() + candidate->weight_ > mainCapacity_) {
+            NodePtr node = victim();
+            if (node == nullptr || candidateFreq <= sketch_.frequency(node->key_)) {
+                stats_.rejections.add();
+                evict(candidate);
+                return;
+            }
+            evict(node);
+        }
+        linkLast(candidate, kProbation);
+    }
+
+    // 主区中下一个被淘汰的条目, 主区为空时返回空
+    NodePtr victim() const {
+        for (int segment: {kProbation, kProtected}) {
+            NodePtr head = segments_[segment].head;
+            if (head->next_ != head) return head->next_;
+        }
+        return nullptr;
+    }
+
+    // 淘汰节点, 仍在链表中的节点先移出
+    void evict(NodePtr node) {
+        if (node->next_ != node) {
+            unlink(node);
+        }
+        nodeMap_.erase(node->key_);
+        nodePool_.deallocate(node);
+        stats_.evictions.add();
+    }
+
+    void unlink(NodePtr node) {
+        node->prev_->next_ = node->next_;
+        node->next_->prev_ = node->prev_;
+        node->prev_ = node;
+        node->next_ = node;
+        segments_[node->segment_].weight -= node->weight_;
+    }
+
+    // 插入到区段的最新一端
+    void linkLast(NodePtr node, int segment) {
+        NodePtr head = segments_[segment].head;
+        node->prev_ = head->prev_;
+        node->next_ = head;
+        head->prev_->next_ = node;
+        head->prev_ = node;
+        node->segment_ = segment;
+        segments_[segment].weight += node->weight_;
+    }
+
+    size_t mainWeight() const {
+        return segments_[kProbation].weight + segments_[kProtected].weight;
+    }
+
+    size_t weigh(NodePtr node) const {
+        return weigher_ ? std::max<size_t>(1, weigher_(node->key_, node->value_)) : 1;
+    }
+
+private:
+    size_t capacity_;               // 缓存容量(设置权重函数时为总权重预算)
+    size_t windowCapacity_;         // 窗口区容量
+    size_t mainCapacity_;           // 主区容量
+    size_t protectedCapacity_;      // 保护段容量
+    Weigher weigher_;               // 权重函数, 为空时每个条目权重为 1
+    NodePool<NodeType> nodePool_;   // 节点内存池(含各区段的虚拟头节点)
+    NodeMap nodeMap_;               // key -> node
+    FrequencySketch<Key, Hash> sketch_;     // 访问频次估计
+    Segment segments_[kSegmentCount];
+    Mutex mutex_;
+    CacheStats stats_;              // 统计计数器(锁内更新)
+};
+
+
+/**
+ * TinyLFU 准入过滤器, 可以套在任意 CacheStrategy 实现前面
+ * · get()/put() 都记录进 sketch, put() 一个不在缓存中的 key 时, 只有估计频次达到 admitFrequency 才交给内部缓存
+ * · 内部缓存不暴露淘汰对象, 因此这里不和受害者比较, 而是用固定的频次门槛,
+ *   默认 2 即"第二次出现才缓存", 相当于用几个字节一个 key 的 sketch 代替 LruKCache 的历史记录链表
+ * · sketch 按 key 的哈希分条带, 每个条带一把锁, 不会让分片缓存在准入这一层重新串行化
+*/
+template<typename Key, typename Value, typename Hash = CacheHash<Key>>
+class TinyLfuAdmission : public CacheStrategy<Key, Value> {
+public:
+    // expectedSize 为预计的条目数, 用来确定 sketch 的大小
+    TinyLfuAdmission(std::unique_ptr<CacheStrategy<Key, Value>> cache, size_t expectedSize, size_t admitFrequency = 2)
+        : cache_(std::move(cache))
+        , admitFrequency_(admitFrequency)
+        , stripes_(new Stripe[kStripeCount])
+    {
+        this->template useLoadHash<Hash>();
+        for (size_t i = 0; i < kStripeCount; i++) {
+            stripes_[i].sketch.ensureCapacity(expectedSize / kStripeCount);
+        }
+    }
+
+    ~TinyLfuAdmission() override {
+        this->cancelLoads();
+    }
+
+    void put(const Key& key, const Value& value) override {
+        if (admit(key)) cache_->put(key, value);
+    }
+
+    void put(const Key& key, Value&& value) override {
+        if (admit(key)) cache_->put(key, std::move(value));
+    }
+
+    bool get(const Key& key, Value& value) override {
+        record(key);
+        return cache_->get(key, value);
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    bool contains(const Key& key) override {
+        return cache_->contains(key);
+    }
+
+    void remove(const Key& key) override {
+        cache_->remove(key);
+    }
+
+    size_t getMany(const std::vector<Key>& keys, std::vector<Value>& values, std::vector<bool>& found) override {
+        for (const Key& key: keys) {
+            record(key);
+        }
+        return cache_->getMany(keys, values, found);
+    }
+
+    // 先逐个过准入, 通过的部分再整批交给内部缓存
+    void putMany(const std::vector<Key>& keys, const std::vector<Value>& values) override {
+        size_t count = std::min(keys.size(), values.size());
+        std::vector<Key> admittedKeys;
+        std::vector<Value> admittedValues;
+        for (size_t i = 0; i < count; i++) {
+            if (admit(keys[i])) {
+                admittedKeys.push_back(keys[i]);
+                admittedValues.push_back(values[i]);
+            }
+        }
+        cache_->putMany(admittedKeys, admittedValues);
+    }
+
+    CacheStatsSnapshot getStats() override {
+        CacheStatsSnapshot snapshot = cache_->getStats();
+        snapshot.rejections += rejections_.load();
+        return snapshot;
+    }
+
+private:
+    static constexpr size_t kStripeCount = 16;
+
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+        FrequencySketch<Key, Hash> sketch;
+    };
+
+    Stripe& stripeOf(const Key& key) {
+        return stripes_[cacheShardOf(cacheHashOf(Hash(), key), kStripeCount)];
+    }
+
+    void record(const Key& key) {
+        Stripe& stripe = stripeOf(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.sketch.increment(key);
+    }
+
+    // 记录一次访问并判断是否放行; 已经在缓存中的 key 总是放行, 保证更新不会丢失
+    bool admit(const Key& key) {
+        size_t freq;
+        {
+            Stripe& stripe = stripeOf(key);
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            stripe.sketch.increment(key);
+            freq = stripe.sketch.frequency(key);
+        }
+        if (freq >= admitFrequency_ || cache_->contains(key)) {
+            return true;
+        }
+        rejections_.addShared();
+        return false;
+    }
+
+private:
+    std::unique_ptr<CacheStrategy<Key, Value>> cache_;     // 被过滤的内部缓存
+    size_t admitFrequency_;                                 // 放行的最低估计频次
+    std::unique_ptr<Stripe[]> stripes_;
+    StatCounter rejections_;                                // 锁外更新, 用原子加
+};
+
+
+// 对缓存空间切片, 实现 HashTinyLfu, 每个分片有独立的窗口区/主区和 sketch
+template<typename Key, typename Value, typename Hash = CacheHash<Key>, typename Mutex = std::mutex>
+class HashTinyLfuCache : public ShardedCacheStrategy<TinyLfuCache<Key, Value, Mutex, Hash>, 0, Hash> {
+public:
+    // 设置 weigher 后 capacity 为总权重预算, 平均分给各分片
+    HashTinyLfuCache(size_t capacity, int sliceNum, CacheWeigher<Key, Value> weigher = nullptr)
+        : ShardedCacheStrategy<TinyLfuCache<Key, Value, Mutex, Hash>, 0, Hash>(capacity, sliceNum, weigher)
+    {}
+};
+
+} // namespace Cache
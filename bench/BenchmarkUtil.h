@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../CacheStrategy.h"
+#include "../LruCache.h"
+#include "../LfuCache.h"
+#include "../ArcCache/ArcCache.h"
+#include "../ArcCache/ExactArcCache.h"
+#include "../TinyLfuCache.h"
+#include "../ClockProCache.h"
+#include "../CompactLruCache.h"
+
+// 基准测试和回放工具共用的辅助代码: 策略工厂, key分布生成器, 参数解析
+namespace CacheBench {
+
+using BenchKey = uint64_t;
+using BenchValue = std::string;
+using BenchCache = Cache::CacheStrategy<BenchKey, BenchValue>;
+
+// 所有可测试的策略名称
+inline const std::vector<std::string>& allPolicies() {
+    static const std::vector<std::string> policies = {
+        "lru", "lru-k", "slru", "2q", "lfu", "arc", "arc-exact", "clockpro", "tinylfu", "lru-tinylfu",
+        "hash-lru", "hash-slru", "hash-2q", "hash-lfu", "hash-arc", "hash-arc-exact", "hash-clockpro", "hash-tinylfu",
+        "hash-lru-spin", "hash-lru-skip", "hash-lfu-spin", "lru-compact", "hash-lru-compact"
+    };
+    return policies;
+}
+
+// 按名称创建缓存, 未知名称返回空指针; V 默认是基准测试的 value, 命中率曲线的影子缓存用单字节的 value
+template<typename V = BenchValue>
+std::unique_ptr<Cache::CacheStrategy<BenchKey, V>> makePolicy(const std::string& name, size_t capacity, int shards) {
+    int cap = static_cast<int>(capacity);
+    if (name == "lru") return std::make_unique<Cache::LruCache<BenchKey, V>>(cap);
+    if (name == "lru-k") return std::make_unique<Cache::LruKCache<BenchKey, V>>(cap, cap, 2);
+    if (name == "slru") return std::make_unique<Cache::SlruCache<BenchKey, V>>(capacity);
+    if (name == "2q") return std::make_unique<Cache::TwoQueueCache<BenchKey, V>>(capacity);
+    if (name == "lfu") return std::make_unique<Cache::LfuCache<BenchKey, V>>(cap);
+    if (name == "arc") return std::make_unique<Cache::ArcCache<BenchKey, V>>(capacity);
+    if (name == "arc-exact") return std::make_unique<Cache::ExactArcCache<BenchKey, V>>(capacity);
+    if (name == "clockpro") return std::make_unique<Cache::ClockProCache<BenchKey, V>>(capacity);
+    if (name == "tinylfu") return std::make_unique<Cache::TinyLfuCache<BenchKey, V>>(capacity);
+    if (name == "lru-tinylfu") {
+        // LRU 前面套一层 TinyLFU 准入过滤, 和 lru-k 对比
+        return std::make_unique<Cache::TinyLfuAdmission<BenchKey, V>>(
+            std::make_unique<Cache::LruCache<BenchKey, V>>(cap), capacity);
+    }
+    if (name == "hash-lru") return std::make_unique<Cache::HashLruCaches<BenchKey, V>>(capacity, shards);
+    if (name == "hash-slru") return std::make_unique<Cache::HashSlruCache<BenchKey, V>>(capacity, shards);
+    if (name == "hash-2q") return std::make_unique<Cache::HashTwoQueueCache<BenchKey, V>>(capacity, shards);
+    if (name == "hash-lfu") return std::make_unique<Cache::HashLfuCache<BenchKey, V>>(capacity, shards);
+    if (name == "hash-arc") return std::make_unique<Cache::HashArcCache<BenchKey, V>>(capacity, shards);
+    if (name == "hash-arc-exact") return std::make_unique<Cache::HashExactArcCache<BenchKey, V>>(capacity, shards);
+    if (name == "hash-clockpro") return std::make_unique<Cache::HashClockProCache<BenchKey, V>>(capacity, shards);
+    if (name == "hash-tinylfu") return std::make_unique<Cache::HashTinyLfuCache<BenchKey, V>>(capacity, shards);
+    // BenchValue 是 std::string 时紧凑 LRU 走的是 value 单独分配的布局
+    if (name == "lru-compact") return std::make_unique<Cache::CompactLruCache<BenchKey, V>>(capacity);
+    if (name == "hash-lru-compact") return std::make_unique<Cache::HashCompactLruCache<BenchKey, V>>(capacity, shards);
+    // 同一策略换用不同的锁, 对比锁策略本身的开销(见 CacheLock.h)
+    if (name == "hash-lru-spin") {
+        return std::make_unique<Cache::HashLruCaches<BenchKey, V, Cache::CacheHash<BenchKey>, Cache::FixedShards,
+                                                     Cache::SpinThenParkMutex>>(capacity, shards);
+    }
+    if (name == "hash-lru-skip") {
+        return std::make_unique<Cache::HashLruCaches<BenchKey, V, Cache::CacheHash<BenchKey>, Cache::FixedShards,
+                                                     Cache::SkipPromotionOnContention<>>>(capacity, shards);
+    }
+    if (name == "hash-lfu-spin") {
+        return std::make_unique<Cache::HashLfuCache<BenchKey, V, Cache::CacheHash<BenchKey>, Cache::FixedShards,
+                                                    Cache::SpinThenParkMutex>>(capacity, shards);
+    }
+    return nullptr;
+}
+
+/**
+ * Zipf 分布生成器 (Gray 等人 "Quickly Generating Billion-Record Synthetic Databases" 中的方法)
+ * 初始化时计算一次 zeta(n), 之后每次生成都是 O(1), 返回 [0, n) 的排名, 0 最热
+*/
+class ZipfGenerator {
+public:
+    ZipfGenerator(uint64_t n, double theta)
+        : n_(std::max<uint64_t>(n, 2))
+        , theta_(theta)
+    {
+        zetaN_ = zeta(n_, theta_);
+        double zeta2 = zeta(2, theta_);
+        alpha_ = 1.0 / (1.0 - theta_);
+        eta_ = (1.0 - std::pow(2.0 / n_, 1.0 - theta_)) / (1.0 - zeta2 / zetaN_);
+        halfPowTheta_ = 1.0 + std::pow(0.5, theta_);
+    }
+
+    template<typename Rng>
+    uint64_t next(Rng& rng) {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        double uz = u * zetaN_;
+        if (uz < 1.0) return 0;
+        if (uz < halfPowTheta_) return 1;
+        uint64_t rank = static_cast<uint64_t>(n_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+        return std::min(rank, n_ - 1);
+    }
+
+private:
+    static double zeta(uint64_t n, double theta) {
+        double sum = 0;
+        for (uint64_t i = 1; i <= n; i++) {
+            sum += 1.0 / std::pow(static_cast<double>(i), theta);
+        }
+        return sum;
+    }
+
+private:
+    uint64_t n_;
+    double theta_;
+    double zetaN_;
+    double alpha_;
+    double eta_;
+    double halfPowTheta_;
+};
+
+// 逗号分隔的列表
+inline std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// 从已排序的样本中取百分位
+inline uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1));
+    return sorted[index];
+}
+
+} // namespace CacheBench
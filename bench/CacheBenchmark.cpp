@@ -0,0 +1,377 @@
+/**
+ * 多线程吞吐量/延迟基准测试
+ * · 对每个 (策略, 线程数, key分布, 读比例, value大小) 组合跑一轮, 输出 ops/sec, 命中率和 p50/p99/p999 延迟
+ * · key 序列在计时前按线程预先生成, 计时循环里只有缓存操作
+ * · 读操作未命中时回填 (cache-aside), 写操作直接 put
+ * · 延迟按 --latency-sample 间隔采样, 避免每个操作都读时钟影响吞吐量
+ * · 每轮结束后读取缓存自身的统计(getStats), 输出淘汰次数和等锁时间
+ * · --batch N (N > 1) 时每 N 个操作一批: 读操作走 getMany, 写操作和未命中的回填走 putMany, 延迟按整批采样
+ * 用法示例:
+ *   cache_bench --policies lru,arc,hash-lru --threads 1,4,8 --dist zipf,uniform --read-ratio 0.9 --format csv
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkUtil.h"
+
+using namespace std;
+using namespace CacheBench;
+
+struct BenchOptions {
+    vector<string> policies = allPolicies();
+    vector<int> threads = {1, 2, 4, 8};
+    vector<string> distributions = {"zipf", "uniform", "scan"};
+    vector<double> readRatios = {0.9};
+    vector<size_t> valueSizes = {64};
+    size_t keys = 1000000;                  // key 空间大小
+    size_t capacity = 100000;               // 缓存总容量
+    size_t opsPerThread = 1000000;          // 每个线程的操作次数
+    int shards = 0;                         // Hash* 分片数, 0 表示按 CPU 核数
+    double zipfTheta = 0.99;
+    size_t latencySample = 8;               // 每隔多少个操作记录一次延迟
+    size_t batch = 1;                       // 批量接口每批的操作数, 1 表示逐个操作
+    string format = "csv";                  // csv 或 json
+    unsigned seed = 42;
+};
+
+struct BenchResult {
+    string policy;
+    int threads;
+    string distribution;
+    double readRatio;
+    size_t valueSize;
+    uint64_t ops;
+    double seconds;
+    double hitRatio;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    Cache::CacheStatsSnapshot stats;    // 缓存自身统计, 含预热阶段
+};
+
+// 每个线程预先生成的操作序列
+struct ThreadWorkload {
+    vector<BenchKey> keys;
+    vector<uint8_t> isRead;
+};
+
+// 每个线程的测量结果
+struct ThreadStats {
+    uint64_t reads = 0;
+    uint64_t hits = 0;
+    vector<uint64_t> latencies;
+};
+
+static void printUsage() {
+    cout << "用法: cache_bench [选项]\n"
+         << "  --policies LIST     策略列表, 可选 lru,lru-k,slru,2q,lfu,arc,arc-exact,clockpro,tinylfu,\n"
+         << "                      lru-tinylfu,hash-lru,hash-slru,hash-2q,hash-lfu,hash-arc,\n"
+         << "                      hash-arc-exact,hash-clockpro,hash-tinylfu,\n"
+         << "                      hash-lru-spin,hash-lru-skip,hash-lfu-spin,lru-compact,hash-lru-compact\n"
+         << "  --threads LIST      线程数列表, 默认 1,2,4,8\n"
+         << "  --dist LIST         key 分布, 可选 zipf,uniform,scan\n"
+         << "  --read-ratio LIST   读操作比例列表, 默认 0.9\n"
+         << "  --value-size LIST   value 字节数列表, 默认 64\n"
+         << "  --keys N            key 空间大小, 默认 1000000\n"
+         << "  --capacity N        缓存容量, 默认 100000\n"
+         << "  --ops N             每个线程的操作次数, 默认 1000000\n"
+         << "  --shards N          Hash* 策略的分片数, 默认按 CPU 核数\n"
+         << "  --zipf-theta X      zipf 偏斜参数, 默认 0.99\n"
+         << "  --latency-sample N  延迟采样间隔, 默认 8\n"
+         << "  --batch N           每批操作数, 大于 1 时使用 getMany/putMany, 默认 1\n"
+         << "  --format csv|json   输出格式, 默认 csv\n"
+         << "  --seed N            随机种子\n";
+}
+
+static bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            exit(0);
+        }
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return false;
+        }
+        string value = argv[++i];
+        if (arg == "--policies") {
+            options.policies = splitList(value);
+        }
+        else if (arg == "--threads") {
+            options.threads.clear();
+            for (const string& item: splitList(value)) options.threads.push_back(stoi(item));
+        }
+        else if (arg == "--dist") {
+            options.distributions = splitList(value);
+        }
+        else if (arg == "--read-ratio") {
+            options.readRatios.clear();
+            for (const string& item: splitList(value)) options.readRatios.push_back(stod(item));
+        }
+        else if (arg == "--value-size") {
+            options.valueSizes.clear();
+            for (const string& item: splitList(value)) options.valueSizes.push_back(stoul(item));
+        }
+        else if (arg == "--keys") options.keys = stoul(value);
+        else if (arg == "--capacity") options.capacity = stoul(value);
+        else if (arg == "--ops") options.opsPerThread = stoul(value);
+        else if (arg == "--shards") options.shards = stoi(value);
+        else if (arg == "--zipf-theta") options.zipfTheta = stod(value);
+        else if (arg == "--latency-sample") options.latencySample = max<size_t>(1, stoul(value));
+        else if (arg == "--batch") options.batch = max<size_t>(1, stoul(value));
+        else if (arg == "--format") options.format = value;
+        else if (arg == "--seed") options.seed = static_cast<unsigned>(stoul(value));
+        else {
+            cerr << "未知参数: " << arg << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static vector<ThreadWorkload> buildWorkloads(const BenchOptions& options, int threads,
+                                             const string& distribution, double readRatio) {
+    vector<ThreadWorkload> workloads(threads);
+    ZipfGenerator zipf(options.keys, options.zipfTheta);
+    for (int t = 0; t < threads; t++) {
+        mt19937_64 gen(options.seed + t);
+        uniform_real_distribution<double> coin(0.0, 1.0);
+        ThreadWorkload& workload = workloads[t];
+        workload.keys.resize(options.opsPerThread);
+        workload.isRead.resize(options.opsPerThread);
+        // 顺序扫描时各线程从 key 空间的不同位置开始
+        uint64_t scanPos = options.keys * t / threads;
+        for (size_t op = 0; op < options.opsPerThread; op++) {
+            BenchKey key;
+            if (distribution == "zipf") {
+                key = zipf.next(gen);
+            }
+            else if (distribution == "scan") {
+                key = scanPos;
+                scanPos = (scanPos + 1) % options.keys;
+            }
+            else {
+                key = gen() % options.keys;
+            }
+            workload.keys[op] = key;
+            workload.isRead[op] = coin(gen) < readRatio;
+        }
+    }
+    return workloads;
+}
+
+// 批量模式的线程主循环: 每批先 getMany 所有读, 再把写和读未命中的 key 一起 putMany
+static void runBatched(BenchCache& cache, const ThreadWorkload& workload, ThreadStats& local,
+                       const BenchValue& value, const BenchOptions& options) {
+    vector<BenchKey> readKeys, writeKeys;
+    vector<BenchValue> results;
+    vector<bool> found;
+    const vector<BenchValue> writeValues(options.batch * 2, value);
+    readKeys.reserve(options.batch);
+    writeKeys.reserve(options.batch * 2);
+
+    size_t batchIndex = 0;
+    for (size_t begin = 0; begin < workload.keys.size(); begin += options.batch, batchIndex++) {
+        size_t end = min(begin + options.batch, workload.keys.size());
+        bool sample = (batchIndex % options.latencySample) == 0;
+        chrono::steady_clock::time_point start;
+        if (sample) start = chrono::steady_clock::now();
+
+        readKeys.clear();
+        writeKeys.clear();
+        for (size_t op = begin; op < end; op++) {
+            if (workload.isRead[op]) {
+                readKeys.push_back(workload.keys[op]);
+            }
+            else {
+                writeKeys.push_back(workload.keys[op]);
+            }
+        }
+        local.reads += readKeys.size();
+        local.hits += cache.getMany(readKeys, results, found);
+        for (size_t i = 0; i < readKeys.size(); i++) {
+            if (!found[i]) writeKeys.push_back(readKeys[i]);
+        }
+        cache.putMany(writeKeys, writeValues);
+
+        if (sample) {
+            auto ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+            local.latencies.push_back(static_cast<uint64_t>(ns));
+        }
+    }
+}
+
+static BenchResult runOne(const BenchOptions& options, const string& policy, int threads,
+                          const string& distribution, double readRatio, size_t valueSize) {
+    unique_ptr<BenchCache> cache = makePolicy(policy, options.capacity, options.shards);
+    const BenchValue value(valueSize, 'v');
+
+    // 预热: 先把容量范围内的 key 填进去(zipf 分布下编号小的 key 最热)
+    size_t warmKeys = min(options.capacity, options.keys);
+    for (size_t key = 0; key < warmKeys; key++) {
+        cache->put(key, value);
+    }
+
+    vector<ThreadWorkload> workloads = buildWorkloads(options, threads, distribution, readRatio);
+    vector<ThreadStats> stats(threads);
+    atomic<int> ready(0);
+    atomic<bool> start(false);
+
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            const ThreadWorkload& workload = workloads[t];
+            ThreadStats& local = stats[t];
+            local.latencies.reserve(options.opsPerThread / options.latencySample + 1);
+            BenchValue result;
+            ready.fetch_add(1);
+            while (!start.load(memory_order_acquire)) {
+                this_thread::yield();
+            }
+            if (options.batch > 1) {
+                runBatched(*cache, workload, local, value, options);
+                return;
+            }
+            for (size_t op = 0; op < workload.keys.size(); op++) {
+                bool sample = (op % options.latencySample) == 0;
+                chrono::steady_clock::time_point begin;
+                if (sample) begin = chrono::steady_clock::now();
+
+                BenchKey key = workload.keys[op];
+                if (workload.isRead[op]) {
+                    local.reads++;
+                    if (cache->get(key, result)) {
+                        local.hits++;
+                    }
+                    else {
+                        cache->put(key, value);
+                    }
+                }
+                else {
+                    cache->put(key, value);
+                }
+
+                if (sample) {
+                    auto ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count();
+                    local.latencies.push_back(static_cast<uint64_t>(ns));
+                }
+            }
+        });
+    }
+
+    while (ready.load() < threads) {
+        this_thread::yield();
+    }
+    auto begin = chrono::steady_clock::now();
+    start.store(true, memory_order_release);
+    for (thread& worker: workers) {
+        worker.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    uint64_t reads = 0, hits = 0;
+    vector<uint64_t> latencies;
+    for (const ThreadStats& local: stats) {
+        reads += local.reads;
+        hits += local.hits;
+        latencies.insert(latencies.end(), local.latencies.begin(), local.latencies.end());
+    }
+    sort(latencies.begin(), latencies.end());
+
+    BenchResult res;
+    res.policy = policy;
+    res.threads = threads;
+    res.distribution = distribution;
+    res.readRatio = readRatio;
+    res.valueSize = valueSize;
+    res.ops = static_cast<uint64_t>(threads) * options.opsPerThread;
+    res.seconds = seconds;
+    res.hitRatio = reads == 0 ? 0.0 : static_cast<double>(hits) / reads;
+    res.p50 = percentile(latencies, 0.50);
+    res.p99 = percentile(latencies, 0.99);
+    res.p999 = percentile(latencies, 0.999);
+    res.stats = cache->getStats();
+    return res;
+}
+
+static void printCsvHeader() {
+    printf("policy,threads,distribution,read_ratio,value_size,ops,seconds,ops_per_sec,hit_ratio,p50_ns,p99_ns,p999_ns,evictions,lock_wait_ms\n");
+}
+
+static void printCsvRow(const BenchResult& r) {
+    printf("%s,%d,%s,%.3f,%zu,%llu,%.6f,%.0f,%.6f,%llu,%llu,%llu,%llu,%.3f\n",
+           r.policy.c_str(), r.threads, r.distribution.c_str(), r.readRatio, r.valueSize,
+           static_cast<unsigned long long>(r.ops), r.seconds, r.ops / r.seconds, r.hitRatio,
+           static_cast<unsigned long long>(r.p50), static_cast<unsigned long long>(r.p99),
+           static_cast<unsigned long long>(r.p999), static_cast<unsigned long long>(r.stats.evictions),
+           r.stats.lockWaitNs / 1e6);
+    fflush(stdout);
+}
+
+static void printJsonRow(const BenchResult& r, bool first) {
+    printf("%s  {\"policy\": \"%s\", \"threads\": %d, \"distribution\": \"%s\", \"read_ratio\": %.3f, "
+           "\"value_size\": %zu, \"ops\": %llu, \"seconds\": %.6f, \"ops_per_sec\": %.0f, \"hit_ratio\": %.6f, "
+           "\"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"evictions\": %llu, \"lock_wait_ms\": %.3f}",
+           first ? "" : ",\n", r.policy.c_str(), r.threads, r.distribution.c_str(), r.readRatio, r.valueSize,
+           static_cast<unsigned long long>(r.ops), r.seconds, r.ops / r.seconds, r.hitRatio,
+           static_cast<unsigned long long>(r.p50), static_cast<unsigned long long>(r.p99),
+           static_cast<unsigned long long>(r.p999), static_cast<unsigned long long>(r.stats.evictions),
+           r.stats.lockWaitNs / 1e6);
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+    for (const string& policy: options.policies) {
+        if (!makePolicy(policy, 1, 1)) {
+            cerr << "未知策略: " << policy << endl;
+            return 1;
+        }
+    }
+
+    bool json = (options.format == "json");
+    if (json) {
+        printf("[\n");
+    }
+    else {
+        printCsvHeader();
+    }
+
+    bool first = true;
+    for (const string& policy: options.policies) {
+        for (int threads: options.threads) {
+            for (const string& distribution: options.distributions) {
+                for (double readRatio: options.readRatios) {
+                    for (size_t valueSize: options.valueSizes) {
+                        BenchResult result = runOne(options, policy, threads, distribution, readRatio, valueSize);
+                        if (json) {
+                            printJsonRow(result, first);
+                        }
+                        else {
+                            printCsvRow(result);
+                        }
+                        first = false;
+                    }
+                }
+            }
+        }
+    }
+
+    if (json) {
+        printf("\n]\n");
+    }
+    return 0;
+}
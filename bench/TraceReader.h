@@ -0,0 +1,252 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * 访问日志(trace)流式读取
+ * · 整个文件用 mmap 映射, 只按顺序读取, 已经读过的区域定期 MADV_DONTNEED 释放, 不会把整个 trace 读进内存
+ * · 支持的格式:
+ *   bin     : 连续的小端 uint64 key
+ *   arc     : ARC 论文 trace 格式, 每行 "起始块 块数 忽略 请求号", 展开为连续的块号
+ *   twitter : Twitter cache trace 的 CSV 格式, "时间戳,key,key大小,value大小,客户端id,操作,ttl"
+ *             字符串 key 用 FNV-1a 哈希成 uint64
+*/
+namespace CacheBench {
+
+enum class TraceOp {
+    Read,
+    Write,
+    Delete
+};
+
+struct TraceRecord {
+    uint64_t key;
+    TraceOp op;
+    uint32_t valueSize;     // trace 中记录的 value 大小, 没有时为 0
+};
+
+class TraceReader {
+public:
+    TraceReader()
+        : fd_(-1), data_(nullptr), size_(0), pos_(0), releasedUpTo_(0)
+        , arcNext_(0), arcRemaining_(0)
+    {}
+
+    ~TraceReader() {
+        close();
+    }
+
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    // 打开 trace 文件, 失败返回 false
+    bool open(const std::string& path, const std::string& format) {
+        close();
+        if (format == "bin") format_ = Format::Binary;
+        else if (format == "arc") format_ = Format::Arc;
+        else if (format == "twitter") format_ = Format::Twitter;
+        else return false;
+
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) return false;
+        struct stat st;
+        if (fstat(fd_, &st) != 0) {
+            close();
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (addr == MAP_FAILED) {
+                close();
+                return false;
+            }
+            data_ = static_cast<const char*>(addr);
+            madvise(addr, size_, MADV_SEQUENTIAL);
+        }
+        return true;
+    }
+
+    void close() {
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+            data_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        size_ = 0;
+        rewind();
+    }
+
+    // 回到文件开头重新读取
+    void rewind() {
+        pos_ = 0;
+        releasedUpTo_ = 0;
+        arcNext_ = 0;
+        arcRemaining_ = 0;
+    }
+
+    // 读取下一条记录, 读完返回 false
+    bool next(TraceRecord& record) {
+        bool ok = false;
+        switch (format_) {
+        case Format::Binary:
+            ok = nextBinary(record);
+            break;
+        case Format::Arc:
+            ok = nextArc(record);
+            break;
+        case Format::Twitter:
+            ok = nextTwitter(record);
+            break;
+        }
+        releaseConsumed();
+        return ok;
+    }
+
+private:
+    enum class Format {
+        Binary,
+        Arc,
+        Twitter
+    };
+
+    static constexpr size_t kReleaseChunk = 64 << 20;   // 每读过 64MB 释放一次
+
+    bool nextBinary(TraceRecord& record) {
+        if (pos_ + sizeof(uint64_t) > size_) return false;
+        std::memcpy(&record.key, data_ + pos_, sizeof(uint64_t));
+        pos_ += sizeof(uint64_t);
+        record.op = TraceOp::Read;
+        record.valueSize = 0;
+        return true;
+    }
+
+    bool nextArc(TraceRecord& record) {
+        // 一行描述一段连续的块, 逐个吐出
+        while (arcRemaining_ == 0) {
+            const char* line;
+            size_t length;
+            if (!nextLine(line, length)) return false;
+            const char* cur = line;
+            const char* end = line + length;
+            uint64_t start = parseUnsigned(cur, end);
+            uint64_t count = parseUnsigned(cur, end);
+            arcNext_ = start;
+            arcRemaining_ = count;
+        }
+        record.key = arcNext_++;
+        arcRemaining_--;
+        record.op = TraceOp::Read;
+        record.valueSize = 0;
+        return true;
+    }
+
+    bool nextTwitter(TraceRecord& record) {
+        const char* line;
+        size_t length;
+        while (nextLine(line, length)) {
+            // 按逗号切分出前 6 个字段
+            const char* fields[7];
+            size_t lengths[7];
+            size_t count = 0;
+            const char* cur = line;
+            const char* end = line + length;
+            while (count < 7 && cur <= end) {
+                const char* comma = static_cast<const char*>(std::memchr(cur, ',', end - cur));
+                const char* fieldEnd = comma ? comma : end;
+                fields[count] = cur;
+                lengths[count] = fieldEnd - cur;
+                count++;
+                if (!comma) break;
+                cur = comma + 1;
+            }
+            if (count < 6) continue;
+
+            record.key = fnv1a(fields[1], lengths[1]);
+            const char* sizeCur = fields[3];
+            record.valueSize = static_cast<uint32_t>(parseUnsigned(sizeCur, fields[3] + lengths[3]));
+            std::string op(fields[5], lengths[5]);
+            if (op == "get" || op == "gets") {
+                record.op = TraceOp::Read;
+            }
+            else if (op == "delete") {
+                record.op = TraceOp::Delete;
+            }
+            else {
+                // set/add/replace/cas/append/prepend/incr/decr 都当作写
+                record.op = TraceOp::Write;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // 取出下一行(不含换行符), 跳过空行
+    bool nextLine(const char*& line, size_t& length) {
+        while (pos_ < size_) {
+            const char* begin = data_ + pos_;
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', size_ - pos_));
+            size_t lineLength = newline ? static_cast<size_t>(newline - begin) : size_ - pos_;
+            pos_ += lineLength + (newline ? 1 : 0);
+            if (lineLength > 0 && begin[lineLength - 1] == '\r') lineLength--;
+            if (lineLength == 0) continue;
+            line = begin;
+            length = lineLength;
+            return true;
+        }
+        return false;
+    }
+
+    static uint64_t parseUnsigned(const char*& cur, const char* end) {
+        while (cur < end && (*cur < '0' || *cur > '9')) cur++;
+        uint64_t value = 0;
+        while (cur < end && *cur >= '0' && *cur <= '9') {
+            value = value * 10 + static_cast<uint64_t>(*cur - '0');
+            cur++;
+        }
+        return value;
+    }
+
+    static uint64_t fnv1a(const char* data, size_t length) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // 把已经读过的整块区域交还给内核, 保证常驻内存不随 trace 大小增长
+    void releaseConsumed() {
+        if (pos_ - releasedUpTo_ < kReleaseChunk) return;
+        size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t upTo = (pos_ / pageSize) * pageSize;
+        if (upTo > releasedUpTo_) {
+            madvise(const_cast<char*>(data_) + releasedUpTo_, upTo - releasedUpTo_, MADV_DONTNEED);
+            releasedUpTo_ = upTo;
+        }
+    }
+
+private:
+    Format format_ = Format::Binary;
+    int fd_;
+    const char* data_;
+    size_t size_;
+    size_t pos_;                // 当前读取位置
+    size_t releasedUpTo_;       // 已经释放的区域末尾(页对齐)
+    uint64_t arcNext_;          // arc 格式当前段的下一个块号
+    uint64_t arcRemaining_;     // arc 格式当前段剩余块数
+};
+
+} // namespace CacheBench
@@ -0,0 +1,220 @@
+/**
+ * trace 回放模拟器
+ * · 把磁盘上的真实访问日志流式送入任意 CacheStrategy 实现, 不把整个 trace 读进内存
+ * · 读请求未命中时回填 (cache-aside), 写请求直接 put, 删除请求调用 remove(), 之后的读按未命中计
+ * · 每 --window 个请求输出一行窗口命中率和累计命中率, 结束时输出总吞吐量
+ * · --capacities 可以给多个容量, 每个容量从头回放一遍, 用来从真实 trace 选容量
+ * · --mrc-rate R 额外回放一遍, 用 CacheMissRatioCurve 按采样率 R 一次估计出所有容量的命中率, 与逐个容量的结果对比
+ * 用法示例:
+ *   trace_replay --trace wiki.bin --format bin --policy arc --capacities 10000,100000 --window 1000000
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BenchmarkUtil.h"
+#include "TraceReader.h"
+#include "../CacheMissRatio.h"
+
+using namespace std;
+using namespace CacheBench;
+
+struct ReplayOptions {
+    string tracePath;
+    string format = "bin";
+    vector<string> policies = {"lru"};
+    vector<size_t> capacities = {10000};
+    int shards = 0;
+    uint64_t window = 1000000;          // 每多少个请求输出一次
+    uint64_t limit = 0;                 // 最多回放多少个请求, 0 不限制
+    size_t valueSize = 16;              // 写入缓存的 value 大小
+    bool traceValueSize = false;        // 使用 trace 中记录的 value 大小
+    double mrcRate = 0;                 // 命中率曲线估计的采样率, 0 表示不估计
+};
+
+static void printUsage() {
+    cout << "用法: trace_replay --trace 文件 [选项]\n"
+         << "  --format bin|arc|twitter  trace 格式, 默认 bin\n"
+         << "  --policy LIST             策略列表, 可选 lru,lru-k,slru,2q,lfu,arc,arc-exact,clockpro,tinylfu,\n"
+         << "                            lru-tinylfu,hash-lru,hash-slru,hash-2q,hash-lfu,hash-arc,\n"
+         << "                            hash-arc-exact,hash-clockpro,hash-tinylfu,\n"
+         << "                            hash-lru-spin,hash-lru-skip,hash-lfu-spin,lru-compact,hash-lru-compact\n"
+         << "  --capacities LIST         缓存容量列表, 默认 10000\n"
+         << "  --shards N                Hash* 策略的分片数, 默认按 CPU 核数\n"
+         << "  --window N                输出间隔(请求数), 默认 1000000\n"
+         << "  --limit N                 最多回放的请求数, 默认不限制\n"
+         << "  --value-size N            写入的 value 字节数, 默认 16\n"
+         << "  --trace-value-size        使用 trace 中记录的 value 大小\n"
+         << "  --mrc-rate R              以采样率 R 估计所有容量的命中率曲线, 默认不估计\n";
+}
+
+static bool parseOptions(int argc, char* argv[], ReplayOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            exit(0);
+        }
+        if (arg == "--trace-value-size") {
+            options.traceValueSize = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "缺少参数值: " << arg << endl;
+            return false;
+        }
+        string value = argv[++i];
+        if (arg == "--trace") options.tracePath = value;
+        else if (arg == "--format") options.format = value;
+        else if (arg == "--policy") options.policies = splitList(value);
+        else if (arg == "--capacities") {
+            options.capacities.clear();
+            for (const string& item: splitList(value)) options.capacities.push_back(stoul(item));
+        }
+        else if (arg == "--shards") options.shards = stoi(value);
+        else if (arg == "--window") options.window = max<uint64_t>(1, stoull(value));
+        else if (arg == "--limit") options.limit = stoull(value);
+        else if (arg == "--value-size") options.valueSize = stoul(value);
+        else if (arg == "--mrc-rate") options.mrcRate = stod(value);
+        else {
+            cerr << "未知参数: " << arg << endl;
+            return false;
+        }
+    }
+    return !options.tracePath.empty();
+}
+
+// 回放一遍 trace, 返回是否成功
+static bool replay(TraceReader& reader, const ReplayOptions& options, const string& policy, size_t capacity) {
+    unique_ptr<BenchCache> cache = makePolicy(policy, capacity, options.shards);
+    if (!cache) {
+        cerr << "未知策略: " << policy << endl;
+        return false;
+    }
+    reader.rewind();
+
+    const BenchValue fixedValue(options.valueSize, 'v');
+    BenchValue result;
+    uint64_t requests = 0, reads = 0, hits = 0, deletes = 0;
+    uint64_t windowReads = 0, windowHits = 0;
+
+    auto begin = chrono::steady_clock::now();
+    TraceRecord record;
+    while (reader.next(record)) {
+        if (options.limit != 0 && requests >= options.limit) break;
+        requests++;
+
+        if (record.op == TraceOp::Read) {
+            reads++;
+            windowReads++;
+            if (cache->get(record.key, result)) {
+                hits++;
+                windowHits++;
+            }
+            else if (options.traceValueSize) {
+                cache->put(record.key, BenchValue(record.valueSize, 'v'));
+            }
+            else {
+                cache->put(record.key, fixedValue);
+            }
+        }
+        else if (record.op == TraceOp::Write) {
+            if (options.traceValueSize) {
+                cache->put(record.key, BenchValue(record.valueSize, 'v'));
+            }
+            else {
+                cache->put(record.key, fixedValue);
+            }
+        }
+        else {
+            deletes++;
+            cache->remove(record.key);
+        }
+
+        if (requests % options.window == 0) {
+            printf("window,%s,%zu,%llu,%.6f,%.6f\n", policy.c_str(), capacity,
+                   static_cast<unsigned long long>(requests),
+                   windowReads == 0 ? 0.0 : static_cast<double>(windowHits) / windowReads,
+                   reads == 0 ? 0.0 : static_cast<double>(hits) / reads);
+            fflush(stdout);
+            windowReads = 0;
+            windowHits = 0;
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    printf("total,%s,%zu,%llu,%llu,%llu,%.6f,%.6f,%.0f\n", policy.c_str(), capacity,
+           static_cast<unsigned long long>(requests), static_cast<unsigned long long>(reads),
+           static_cast<unsigned long long>(deletes),
+           reads == 0 ? 0.0 : static_cast<double>(hits) / reads, seconds,
+           seconds > 0 ? requests / seconds : 0.0);
+    fflush(stdout);
+    return true;
+}
+
+// 读请求和删除请求喂给命中率曲线估计, 影子缓存与被评估的策略相同
+static bool estimateCurve(TraceReader& reader, const ReplayOptions& options, const string& policy) {
+    if (!makePolicy<uint8_t>(policy, 1, options.shards)) {
+        cerr << "未知策略: " << policy << endl;
+        return false;
+    }
+    Cache::CacheMissRatioCurve<BenchKey> curve(options.capacities, options.mrcRate, [&](size_t capacity) {
+        return makePolicy<uint8_t>(policy, capacity, options.shards);
+    });
+    reader.rewind();
+
+    uint64_t requests = 0;
+    auto begin = chrono::steady_clock::now();
+    TraceRecord record;
+    while (reader.next(record)) {
+        if (options.limit != 0 && requests >= options.limit) break;
+        requests++;
+        if (record.op == TraceOp::Read) {
+            curve.record(record.key);
+        }
+        else if (record.op == TraceOp::Delete) {
+            curve.remove(record.key);
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    for (const Cache::MissRatioPoint& point: curve.curve()) {
+        printf("mrc,%s,%zu,%zu,%llu,%.6f,%.6f\n", policy.c_str(), point.capacity, point.shadowCapacity,
+               static_cast<unsigned long long>(point.accesses), point.hitRatio(), seconds);
+    }
+    fflush(stdout);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    ReplayOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    TraceReader reader;
+    if (!reader.open(options.tracePath, options.format)) {
+        cerr << "无法打开 trace: " << options.tracePath << " (格式 " << options.format << ")" << endl;
+        return 1;
+    }
+
+    printf("# window,policy,capacity,requests,window_hit_ratio,cumulative_hit_ratio\n");
+    printf("# total,policy,capacity,requests,reads,deletes,hit_ratio,seconds,ops_per_sec\n");
+    for (const string& policy: options.policies) {
+        for (size_t capacity: options.capacities) {
+            if (!replay(reader, options, policy, capacity)) return 1;
+        }
+    }
+    if (options.mrcRate > 0) {
+        printf("# mrc,policy,capacity,shadow_capacity,sampled_reads,estimated_hit_ratio,seconds\n");
+        for (const string& policy: options.policies) {
+            if (!estimateCurve(reader, options, policy)) return 1;
+        }
+    }
+    return 0;
+}
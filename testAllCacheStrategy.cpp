@@ -11,6 +11,8 @@
 #include "LruCache.h"
 #include "LfuCache.h"
 #include "ArcCache/ArcCache.h"
+#include "ArcCache/ExactArcCache.h"
+#include "ClockProCache.h"
 
 using namespace std;
 
@@ -35,6 +37,8 @@ void printResults(const string& testName, int capacity, const vector<int>& get_o
     cout << "LRU - 命中率: " << fixed << setprecision(2) << (100.0 * hits[0] / get_operations[0]) << "%" << endl;
     cout << "LFU - 命中率: " << fixed << setprecision(2) << (100.0 * hits[1] / get_operations[1]) << "%" << endl;
     cout << "ARC - 命中率: " << fixed << setprecision(2) << (100.0 * hits[2] / get_operations[2]) << "%" << endl;
+    cout << "CLOCK-Pro - 命中率: " << fixed << setprecision(2) << (100.0 * hits[3] / get_operations[3]) << "%" << endl;
+    cout << "ARC(标准) - 命中率: " << fixed << setprecision(2) << (100.0 * hits[4] / get_operations[4]) << "%" << endl;
 }
 
 
@@ -48,13 +52,15 @@ void testHotDataAccess() {
     Cache::LruCache<int, string> lru(CAPACITY);
     Cache::LfuCache<int, string> lfu(CAPACITY);
     Cache::ArcCache<int, string> arc(CAPACITY);
+    Cache::ClockProCache<int, string> clockPro(CAPACITY);
+    Cache::ExactArcCache<int, string> exactArc(CAPACITY);
 
     random_device rd;
     mt19937 gen(rd());
 
-    array<Cache::CacheStrategy<int, string>*, 3> caches = {&lru, &lfu, &arc};
-    vector<int> hits(3, 0);
-    vector<int> get_operations(3, 0);
+    array<Cache::CacheStrategy<int, string>*, 5> caches = {&lru, &lfu, &arc, &clockPro, &exactArc};
+    vector<int> hits(5, 0);
+    vector<int> get_operations(5, 0);
 
     // 先进行一系列put操作
     for (int i = 0; i < caches.size(); i++) {
@@ -102,13 +108,15 @@ void testLoopPattern() {
     Cache::LruCache<int, string> lru(CAPACITY);
     Cache::LfuCache<int, string> lfu(CAPACITY);
     Cache::ArcCache<int, string> arc(CAPACITY);
+    Cache::ClockProCache<int, string> clockPro(CAPACITY);
+    Cache::ExactArcCache<int, string> exactArc(CAPACITY);
 
     random_device rd;
     mt19937 gen(rd());
 
-    array<Cache::CacheStrategy<int, string>*, 3> caches = {&lru, &lfu, &arc};
-    vector<int> hits(3, 0);
-    vector<int> get_operations(3, 0);
+    array<Cache::CacheStrategy<int, string>*, 5> caches = {&lru, &lfu, &arc, &clockPro, &exactArc};
+    vector<int> hits(5, 0);
+    vector<int> get_operations(5, 0);
 
     // 先填充数据
     for (int i = 0; i < caches.size(); i++) {
@@ -155,13 +163,15 @@ void testWorkloadShift() {
     Cache::LruCache<int, string> lru(CAPACITY);
     Cache::LfuCache<int, string> lfu(CAPACITY);
     Cache::ArcCache<int, string> arc(CAPACITY);
+    Cache::ClockProCache<int, string> clockPro(CAPACITY);
+    Cache::ExactArcCache<int, string> exactArc(CAPACITY);
 
     random_device rd;
     mt19937 gen(rd());
 
-    array<Cache::CacheStrategy<int, string>*, 3> caches = {&lru, &lfu, &arc};
-    vector<int> hits(3, 0);
-    vector<int> get_operations(3, 0);
+    array<Cache::CacheStrategy<int, string>*, 5> caches = {&lru, &lfu, &arc, &clockPro, &exactArc};
+    vector<int> hits(5, 0);
+    vector<int> get_operations(5, 0);
 
     // 填充一些初始数据
     for (int i = 0; i < caches.size(); i++) {
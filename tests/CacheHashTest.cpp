@@ -0,0 +1,137 @@
+// 自定义 key 类型和哈希: 没有 std::hash 特化的 key 可以用于所有缓存策略, 传入的 Hash 同时决定分片和分片内的索引
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "../LruCache.h"
+#include "../LfuCache.h"
+#include "../ArcCache/ArcCache.h"
+#include "../ArcCache/ExactArcCache.h"
+#include "../ClockProCache.h"
+#include "../TinyLfuCache.h"
+#include "../CompactLruCache.h"
+#include "../CacheMissRatio.h"
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            return false; \
+        } \
+    } while (0)
+
+struct UserKey {
+    uint32_t tenant;
+    uint32_t id;
+
+    bool operator==(const UserKey& other) const {
+        return tenant == other.tenant && id == other.id;
+    }
+};
+
+// 故意不提供 std::hash<UserKey>, 所有哈希都必须经过 UserKeyHash
+struct UserKeyHash {
+    static std::atomic<uint64_t> calls;
+
+    size_t operator()(const UserKey& key) const {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        return (static_cast<size_t>(key.tenant) << 32) ^ key.id;
+    }
+};
+
+std::atomic<uint64_t> UserKeyHash::calls{0};
+
+template<typename CacheType>
+static bool exercise(CacheType& cache, const char* name) {
+    uint64_t before = UserKeyHash::calls.load();
+    for (uint32_t i = 0; i < 64; i++) {
+        cache.put(UserKey{i % 4, i}, static_cast<int>(i));
+    }
+    int value = 0;
+    CHECK(cache.get(UserKey{3, 63}, value) && value == 63);
+    CHECK(cache.contains(UserKey{3, 63}));
+    cache.remove(UserKey{3, 63});
+    CHECK(!cache.contains(UserKey{3, 63}));
+    CHECK(cache.getOrLoad(UserKey{9, 1}, [](const UserKey& key) { return static_cast<int>(key.id) + 100; }) == 101);
+    auto flight = cache.getOrLoadAsync(UserKey{9, 2}, [](const UserKey& key) {
+        return std::async(std::launch::deferred, [id = key.id]() { return static_cast<int>(id) + 200; });
+    });
+    CHECK(flight.get() && *flight.get() == 202);
+    if (UserKeyHash::calls.load() == before) {
+        std::printf("%s: UserKeyHash was never called\n", name);
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    {
+        Cache::LruCache<UserKey, int, std::mutex, UserKeyHash> cache(128);
+        ok = exercise(cache, "LruCache") && ok;
+    }
+    {
+        Cache::LruKCache<UserKey, int, UserKeyHash> cache(128, 128, 1);
+        ok = exercise(cache, "LruKCache") && ok;
+    }
+    {
+        Cache::HashLruCaches<UserKey, int, UserKeyHash> cache(128, 4);
+        ok = exercise(cache, "HashLruCaches") && ok;
+    }
+    {
+        Cache::HashLruCaches<UserKey, int, UserKeyHash> cache(128, 4, true);
+        ok = exercise(cache, "HashLruCaches(readOptimized)") && ok;
+    }
+    {
+        Cache::HashSlruCache<UserKey, int, UserKeyHash> cache(128, 4);
+        ok = exercise(cache, "HashSlruCache") && ok;
+    }
+    {
+        Cache::HashTwoQueueCache<UserKey, int, UserKeyHash> cache(128, 4);
+        ok = exercise(cache, "HashTwoQueueCache") && ok;
+    }
+    {
+        Cache::HashLfuCache<UserKey, int, UserKeyHash> cache(128, 4);
+        ok = exercise(cache, "HashLfuCache") && ok;
+    }
+    {
+        Cache::HashArcCache<UserKey, int, UserKeyHash> cache(128, 4);
+        ok = exercise(cache, "HashArcCache") && ok;
+    }
+    {
+        Cache::HashExactArcCache<UserKey, int, UserKeyHash> cache(128, 4);
+        ok = exercise(cache, "HashExactArcCache") && ok;
+    }
+    {
+        Cache::HashClockProCache<UserKey, int, UserKeyHash> cache(128, 4);
+        ok = exercise(cache, "HashClockProCache") && ok;
+    }
+    {
+        Cache::HashTinyLfuCache<UserKey, int, UserKeyHash> cache(128, 4);
+        ok = exercise(cache, "HashTinyLfuCache") && ok;
+    }
+    {
+        Cache::HashCompactLruCache<UserKey, int, UserKeyHash> cache(128, 4);
+        ok = exercise(cache, "HashCompactLruCache") && ok;
+    }
+    {
+        Cache::TinyLfuAdmission<UserKey, int, UserKeyHash> cache(
+            std::make_unique<Cache::LruCache<UserKey, int, std::mutex, UserKeyHash>>(128), 128, 1);
+        ok = exercise(cache, "TinyLfuAdmission") && ok;
+    }
+    {
+        using Shadow = Cache::CacheStrategy<UserKey, uint8_t>;
+        Cache::MissRatioCurveTracker<UserKey, int, UserKeyHash> cache(
+            std::make_unique<Cache::LruCache<UserKey, int, std::mutex, UserKeyHash>>(128), {64, 128}, 1.0,
+            [](size_t capacity) -> std::unique_ptr<Shadow> {
+                return std::make_unique<Cache::LruCache<UserKey, uint8_t, std::mutex, UserKeyHash>>(capacity);
+            });
+        ok = exercise(cache, "MissRatioCurveTracker") && ok;
+    }
+    std::printf(ok ? "CacheHashTest passed\n" : "CacheHashTest FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+// LoadCoalescer 异步加载的回归测试: 缓存先于加载结束析构, 以及大量未就绪加载时的线程数
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../LruCache.h"
+#include "../LfuCache.h"
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            return false; \
+        } \
+    } while (0)
+
+// 当前进程的线程数(Linux), 读不到时返回 0
+static int threadCount() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 8, "Threads:") == 0) return std::stoi(line.substr(8));
+    }
+    return 0;
+}
+
+// 加载还在进行时缓存离开作用域: 不能再写回已经析构的缓存, 等待者拿到 broken_promise
+static bool destroyWhileLoading() {
+    std::shared_future<std::optional<int>> flight;
+    {
+        Cache::LruCache<int, int> cache(10);
+        flight = cache.getOrLoadAsync(1, [](int key) {
+            return std::async(std::launch::async, [key]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                return key * 2;
+            });
+        });
+    }
+    CHECK(flight.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    bool broken = false;
+    try {
+        flight.get();
+    }
+    catch (const std::future_error& error) {
+        broken = error.code() == std::future_errc::broken_promise;
+    }
+    CHECK(broken);
+
+    // 派生层级更深的缓存(写回经过 SLRU 自己的成员)同样安全
+    std::promise<std::string> never;
+    {
+        Cache::SlruCache<int, std::string> cache(10);
+        cache.getOrLoadAsync(2, [&](int) { return never.get_future(); });
+    }
+    return true;
+}
+
+// 冷启动时大量不同的 key 同时未命中: 只需要一个完成线程, 结果就绪后全部写回缓存, 没有人等待 future
+static bool coldStartMisses() {
+    const int keys = 5000;
+    Cache::LfuCache<int, int> cache(keys);
+    std::vector<std::promise<int>> backend(keys);
+    int before = threadCount();
+    for (int key = 0; key < keys; key++) {
+        cache.getOrLoadAsync(key, [&](int k) { return backend[k].get_future(); });
+    }
+    int after = threadCount();
+    CHECK(before == 0 || after - before <= 1);
+
+    for (int key = 0; key < keys; key++) {
+        backend[key].set_value(key + 1);
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    int landed = 0;
+    while (std::chrono::steady_clock::now() < deadline) {
+        landed = 0;
+        for (int key = 0; key < keys; key++) {
+            landed += cache.contains(key) ? 1 : 0;
+        }
+        if (landed == keys) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    CHECK(landed == keys);
+    int value = 0;
+    CHECK(cache.get(keys - 1, value) && value == keys);
+
+    // 写回之后登记已经撤销, 同一个 key 重新加载时不会合并到旧的那一次
+    cache.remove(7);
+    auto reload = cache.getOrLoadAsync(7, [](int) {
+        return std::async(std::launch::deferred, []() { return 70; });
+    });
+    CHECK(reload.get() && *reload.get() == 70);
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = destroyWhileLoading() && ok;
+    ok = coldStartMisses() && ok;
+    std::printf(ok ? "CacheLoaderTest passed\n" : "CacheLoaderTest FAILED\n");
+    return ok ? 0 : 1;
+}